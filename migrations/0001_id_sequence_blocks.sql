@@ -0,0 +1,23 @@
+-- Lets one NEXTVAL of an entity id sequence reserve a whole block of ids (DB_ID_BLOCK, 100 by default), so the
+-- server reserves a block with one call instead of one call per id. Run it with a role owning the sequences
+-- while the default DB_ID_BLOCK is in use, or replace 100 with the configured block.
+--
+-- Ids stay unique for every writer, a NEXTVAL still returns an id nobody else got, but ids taken one at a
+-- time by other writers are spaced by the block from now on.
+DO $$
+DECLARE
+    entity text;
+BEGIN
+    FOREACH entity IN ARRAY ARRAY[
+        'users', 'providers',
+        'clinics', 'pharmacies', 'laboratories', 'radiologycenters',
+        'clinics_appointments', 'pharmacies_appointments', 'laboratories_appointments', 'radiologycenters_appointments',
+        'patients', 'patients_drugs', 'patients_health', 'patients_reports', 'patients_visitdrugs',
+        'clinics_visits', 'clinics_requests', 'clinics_prescriptions', 'clinics_paidservices']
+    LOOP
+        IF to_regclass(format('%I', entity || '_id_seq')) IS NOT NULL THEN
+            EXECUTE format('ALTER SEQUENCE %I INCREMENT BY 100;', entity || '_id_seq');
+        END IF;
+    END LOOP;
+END
+$$;
@@ -16,6 +16,10 @@
 #include <utility>
 
 #include "api/v2/helper/helper.hpp"
+#include "configurator/configurator.hpp"
+#include "database/readrouter.hpp"
+#include "database/requestlease.hpp"
+#include "store/store.hpp"
 #include "utils/global/callback.hpp"
 #include "utils/global/http.hpp"
 #include "utils/global/requester.hpp"
@@ -33,6 +37,9 @@ namespace api::v2
     static void executeControllerMethod(const Registry& registry, const std::string_view key, Func method, const drogon::HttpRequestPtr& req,
         std::function<void(const drogon::HttpResponsePtr&)>&& callback, Args&&... args)
     {
+        // the configuration does not change at runtime, read it once rather than on every request
+        static const bool requestLease = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().request_lease;
+
         auto ctl = registry.find(key);
         if (ctl != registry.end())
         {
@@ -41,8 +48,26 @@ namespace api::v2
                 std::visit(
                     [&](const auto& controller)
                     {
-                        CALLBACK_ mcb = [&callback](int code, const std::string& content)
+                        Requester requester(req->getAttributes()->get<uint64_t>("clientID"), req->getAttributes()->get<std::string>("clientGroup"));
+
+                        // every blocking query of the request shares one pooled connection, optionally inside one transaction
+                        std::shared_ptr<RequestLease> lease;
+                        if (requestLease)
+                        {
+                            lease = std::make_shared<RequestLease>(req->getHeader("X-Request-Transaction") == "true");
+                            req->getAttributes()->insert("dbLease", lease);
+                        }
+
+                        // the controller may answer from an event loop callback after this frame is gone, so the callback is owned by mcb
+                        CALLBACK_ mcb = [callback = std::move(callback), lease](int code, const std::string& content) mutable
                         {
+                            // the transaction is settled before the client hears about it
+                            if (lease != nullptr && !lease->finish(code == api::v2::Http::Status::OK) && code == api::v2::Http::Status::OK)
+                            {
+                                Helper::failureResponse("Failed to commit request transaction.", std::move(callback));
+                                return;
+                            }
+
                             switch (code)
                             {
                                 case api::v2::Http::Status::OK:
@@ -57,7 +82,11 @@ namespace api::v2
                             }
                         };
 
-                        Requester requester(req->getAttributes()->get<uint64_t>("clientID"), req->getAttributes()->get<std::string>("clientGroup"));
+                        // database reads issued while dispatching are routed with this client's recent writes in mind
+                        ReadRouter::Scope scope(requester);
+                        // and run on the request's connection. Only mcb finishes the lease, continuations answering after dispatching
+                        // re-enter it, and it rolls back if it is dropped unanswered
+                        RequestLease::Scope leaseScope(lease);
 
                         std::invoke(method, controller.get(), std::move(mcb), std::move(requester), std::forward<Args>(args)...);
                         return;
@@ -63,6 +63,17 @@ namespace api::v2
                 clinicRegistry, "patients", &ClinicControllerBase::GetVisits, req, std::move(callback), stoll(req->getParameter("patient_id")));
         }
 
+        void Import(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback, const std::string &serviceType)
+        {
+            executeControllerMethod(
+                clinicRegistry, serviceType, &ClinicControllerBase::Import, req, std::move(callback), req->body(), req->getHeader("Content-Type"));
+        }
+
+        void Batch(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback, const std::string &serviceType)
+        {
+            executeControllerMethod(clinicRegistry, serviceType, &ClinicControllerBase::Batch, req, std::move(callback), req->body());
+        }
+
         METHOD_LIST_BEGIN
         METHOD_ADD(Clinic::Create, "/{serviceType}/create", drogon::Post, SECURE);
         METHOD_ADD(Clinic::Read, "/{serviceType}/read", drogon::Post, SECURE);
@@ -70,6 +81,8 @@ namespace api::v2
         METHOD_ADD(Clinic::Delete, "/{serviceType}/delete", drogon::Delete, SECURE);
         METHOD_ADD(Clinic::Search, "/patients/search", drogon::HttpMethod::Post, SECURE);
         METHOD_ADD(Clinic::GetVisits, "/patients/getvisits", drogon::Get, SECURE);
+        METHOD_ADD(Clinic::Import, "/{serviceType}/import", drogon::Post, SECURE);
+        METHOD_ADD(Clinic::Batch, "/{serviceType}/batch", drogon::Post, SECURE);
         METHOD_LIST_END
 
        private:
@@ -39,3 +39,9 @@ Configurator::EmailSenderConfig& Configurator::get<Configurator::EmailSenderConf
 {
     return email_sender_config_;
 }
+
+template <>
+Configurator::CacheConfig& Configurator::get<Configurator::CacheConfig>()
+{
+    return cache_config_;
+}
@@ -3,6 +3,7 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -30,6 +31,7 @@ class Configurator
         token_manager_parameters_.printValues();
         frontend_config_.printValues();
         email_sender_config_.printValues();
+        cache_config_.printValues();
     }
 
     using DOSDetectorConfig = struct DOSDetectorConfig : public EnvLoader
@@ -73,24 +75,56 @@ class Configurator
 
     using DatabaseConfig = struct DatabaseConfig : public EnvLoader
     {
-        bool        ssl;
-        uint16_t    max_conn;
-        uint16_t    port;
-        std::string name;
-        std::string user;
-        std::string pass;
-        std::string host;
+        bool                      ssl;
+        bool                      json_passthrough;
+        bool                      fused_case_read;  // case reads check permissions in the statement that fetches the row
+        bool                      request_lease;    // all queries of a request share one pooled connection
+        uint16_t                  min_conn;
+        uint16_t                  max_conn;
+        std::chrono::seconds      idle_timeout;
+        std::chrono::milliseconds grow_wait;
+        std::chrono::milliseconds io_lease_wait;  // an IO thread waits this long for a connection before the query fails
+        uint16_t                  port;
+        std::string               name;
+        std::string               user;
+        std::string               pass;
+        std::string               host;
+
+        std::unordered_set<std::string> replica_hosts;
+        std::chrono::milliseconds       replica_max_lag;
+        std::chrono::seconds            read_your_writes;  // reads stay on the primary this long after a client writes
+        uint32_t                        import_chunk;      // rows per COPY of a bulk import
+        uint32_t                        id_block;          // ids reserved from a sequence at once and handed out from memory
+        std::string                     schema_snapshot;   // file the loaded catalog is kept in between runs, empty disables it
+        std::chrono::seconds            schema_poll;       // the catalog is checked for changes this often besides notifications, 0 disables it
 
         DatabaseConfig()
             : ssl(getEnvironmentVariable("DB_SSL", Defaults::Database::DB_SSL_)),
+              json_passthrough(getEnvironmentVariable("DB_JSON_PASSTHROUGH", Defaults::Database::DB_JSON_PASSTHROUGH_)),
+              fused_case_read(getEnvironmentVariable("DB_FUSED_CASE_READ", Defaults::Database::DB_FUSED_CASE_READ_)),
+              request_lease(getEnvironmentVariable("DB_REQUEST_LEASE", Defaults::Database::DB_REQUEST_LEASE_)),
+              min_conn(getEnvironmentVariable("DB_MIN_CONN", Defaults::Database::DB_MIN_CONN_)),
               max_conn(getEnvironmentVariable("DB_MAX_CONN", Defaults::Database::DB_MAX_CONN_)),
+              idle_timeout(getEnvironmentVariable("DB_IDLE_TIMEOUT", std::chrono::seconds(Defaults::Database::DB_IDLE_TIMEOUT_))),
+              grow_wait(getEnvironmentVariable("DB_GROW_WAIT", Defaults::Database::DB_GROW_WAIT_)),
+              io_lease_wait(getEnvironmentVariable("DB_IO_LEASE_WAIT", Defaults::Database::DB_IO_LEASE_WAIT_)),
               port(getEnvironmentVariable("DB_PORT", Defaults::Database::DB_PORT_)),
               name(getEnvironmentVariable("DB_NAME", Defaults::Database::DB_NAME_)),
               user(getEnvironmentVariable("DB_USER", Defaults::Database::DB_USER_)),
               pass(getEnvironmentVariable("DB_PASS", Defaults::Database::DB_PASS_)),
-              host(getEnvironmentVariable("DB_HOST", Defaults::Database::DB_HOST_))
+              host(getEnvironmentVariable("DB_HOST", Defaults::Database::DB_HOST_)),
+              replica_hosts(getEnvironmentVariable("DB_REPLICA_HOSTS")),
+              replica_max_lag(getEnvironmentVariable("DB_REPLICA_MAX_LAG", Defaults::Database::DB_REPLICA_MAX_LAG_)),
+              read_your_writes(getEnvironmentVariable("DB_READ_YOUR_WRITES", std::chrono::seconds(Defaults::Database::DB_READ_YOUR_WRITES_))),
+              import_chunk(getEnvironmentVariable("DB_IMPORT_CHUNK", Defaults::Database::DB_IMPORT_CHUNK_)),
+              id_block(getEnvironmentVariable("DB_ID_BLOCK", Defaults::Database::DB_ID_BLOCK_)),
+              schema_snapshot(getEnvironmentVariable("DB_SCHEMA_SNAPSHOT", Defaults::Database::DB_SCHEMA_SNAPSHOT_)),
+              schema_poll(getEnvironmentVariable("DB_SCHEMA_POLL", std::chrono::seconds(Defaults::Database::DB_SCHEMA_POLL_)))
         {
             optimize_performance(max_conn, 5);
+            min_conn     = std::min(min_conn, max_conn);
+            import_chunk = std::max<uint32_t>(import_chunk, 1);
+            id_block     = std::max<uint32_t>(id_block, 1);
         }
 
         void printValues() const override
@@ -104,7 +138,21 @@ class Configurator
             Message::ConfMessage(fmt::format("User: {}", user));
             Message::ConfMessage(fmt::format("Pass: {}", pass));
             Message::ConfMessage(fmt::format("SSL: {}", ssl));
+            Message::ConfMessage(fmt::format("JSON pass-through: {}", json_passthrough));
+            Message::ConfMessage(fmt::format("Fused case read: {}", fused_case_read));
+            Message::ConfMessage(fmt::format("Request lease: {}", request_lease));
+            Message::ConfMessage(fmt::format("Min Connections: {}", min_conn));
             Message::ConfMessage(fmt::format("Max Connections: {}", max_conn));
+            Message::ConfMessage(fmt::format("Idle Timeout: {} seconds", idle_timeout.count()));
+            Message::ConfMessage(fmt::format("Grow Wait: {} milliseconds", grow_wait.count()));
+            Message::ConfMessage(fmt::format("IO Lease Wait: {} milliseconds", io_lease_wait.count()));
+            Message::ConfMessage(fmt::format("Replica Hosts: {}", fmt::join(replica_hosts, ", ")));
+            Message::ConfMessage(fmt::format("Replica Max Lag: {} milliseconds", replica_max_lag.count()));
+            Message::ConfMessage(fmt::format("Read Your Writes: {} seconds", read_your_writes.count()));
+            Message::ConfMessage(fmt::format("Import Chunk: {} rows", import_chunk));
+            Message::ConfMessage(fmt::format("ID Block: {} ids", id_block));
+            Message::ConfMessage(fmt::format("Schema Snapshot: {}", schema_snapshot.empty() ? "disabled" : schema_snapshot));
+            Message::ConfMessage(fmt::format("Schema Poll: {} seconds", schema_poll.count()));
         }
     };
 
@@ -122,6 +170,8 @@ class Configurator
         std::string log_dir;
         std::string log_file;
         std::string upload_dir;
+        size_t      max_body_size;         // bytes, every route but the imports
+        size_t      import_max_body_size;  // bytes, bulk imports need far more than a single entity
 
         ServerConfig()
             : host(getEnvironmentVariable("SERVER_HOST", Defaults::Server::SERVER_HOST_)),
@@ -135,7 +185,9 @@ class Configurator
               log_to_file(getEnvironmentVariable("SERVER_LOG_TO_FILE", Defaults::Server::SERVER_LOG_TO_FILE_)),
               log_dir(getEnvironmentVariable("SERVER_LOG_DIR", Defaults::Server::SERVER_LOG_DIR_)),
               log_file(getEnvironmentVariable("SERVER_LOG_FILE", Defaults::Server::SERVER_LOG_FILE_)),
-              upload_dir(getEnvironmentVariable("SERVER_UPLOAD_DIR", Defaults::Server::SERVER_UPLOAD_DIR_))
+              upload_dir(getEnvironmentVariable("SERVER_UPLOAD_DIR", Defaults::Server::SERVER_UPLOAD_DIR_)),
+              max_body_size(getEnvironmentVariable("SERVER_MAX_BODY_SIZE", Defaults::Server::SERVER_MAX_BODY_SIZE_)),
+              import_max_body_size(getEnvironmentVariable("SERVER_IMPORT_MAX_BODY_SIZE", Defaults::Server::SERVER_IMPORT_MAX_BODY_SIZE_))
         {
             optimize_performance(threads, 4);
         }
@@ -157,6 +209,8 @@ class Configurator
             Message::ConfMessage(fmt::format("Log directory: {}", log_dir));
             Message::ConfMessage(fmt::format("Log file: {}", log_file));
             Message::ConfMessage(fmt::format("Upload directory: {}", upload_dir));
+            Message::ConfMessage(fmt::format("Max body size: {} bytes", max_body_size));
+            Message::ConfMessage(fmt::format("Import max body size: {} bytes", import_max_body_size));
         }
     };
 
@@ -235,6 +289,41 @@ class Configurator
         }
     };
 
+    using CacheConfig = struct CacheConfig : public EnvLoader
+    {
+        uint32_t             entity_cache_size;  // entries, 0 disables the entity cache
+        uint32_t             entity_cache_max_entry;  // bytes, larger bodies are not cached
+        std::chrono::seconds entity_cache_ttl;
+        uint32_t             search_count_cache_size;   // entries, 0 disables caching search counts
+        std::chrono::seconds search_count_cache_ttl;
+        // rows, larger results are counted by the planner estimate. A count that misses the cache reads up to this
+        // many + 1 rows of the search on a second pooled connection, next to the one serving the page
+        uint32_t             search_count_exact_limit;
+
+        CacheConfig()
+            : entity_cache_size(getEnvironmentVariable("ENTITY_CACHE_SIZE", Defaults::Cache::ENTITY_CACHE_SIZE_)),
+              entity_cache_max_entry(getEnvironmentVariable("ENTITY_CACHE_MAX_ENTRY", Defaults::Cache::ENTITY_CACHE_MAX_ENTRY_)),
+              entity_cache_ttl(getEnvironmentVariable("ENTITY_CACHE_TTL", std::chrono::seconds(Defaults::Cache::ENTITY_CACHE_TTL_))),
+              search_count_cache_size(getEnvironmentVariable("SEARCH_COUNT_CACHE_SIZE", Defaults::Cache::SEARCH_COUNT_CACHE_SIZE_)),
+              search_count_cache_ttl(getEnvironmentVariable("SEARCH_COUNT_CACHE_TTL", std::chrono::seconds(Defaults::Cache::SEARCH_COUNT_CACHE_TTL_))),
+              search_count_exact_limit(getEnvironmentVariable("SEARCH_COUNT_EXACT_LIMIT", Defaults::Cache::SEARCH_COUNT_EXACT_LIMIT_))
+        {
+        }
+
+        void printValues() const override
+        {
+            Message::ConfMessage("------------------------------------------------");
+            Message::ConfMessage("-------------------Cache Config-----------------");
+            Message::ConfMessage("------------------------------------------------");
+            Message::ConfMessage(fmt::format("Entity cache size: {} entries", entity_cache_size));
+            Message::ConfMessage(fmt::format("Entity cache max entry: {} bytes", entity_cache_max_entry));
+            Message::ConfMessage(fmt::format("Entity cache TTL: {} seconds", entity_cache_ttl.count()));
+            Message::ConfMessage(fmt::format("Search count cache size: {} entries", search_count_cache_size));
+            Message::ConfMessage(fmt::format("Search count cache TTL: {} seconds", search_count_cache_ttl.count()));
+            Message::ConfMessage(fmt::format("Search count exact limit: {} rows", search_count_exact_limit));
+        }
+    };
+
     // Template getter for structs
 
     template <Config T>
@@ -247,4 +336,5 @@ class Configurator
     TokenManagerParameters token_manager_parameters_;
     FrontEndConfig         frontend_config_;
     EmailSenderConfig      email_sender_config_;
+    CacheConfig            cache_config_;
 };
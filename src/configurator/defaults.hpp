@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -24,13 +25,26 @@ namespace Defaults
         /*
          * Default values for Database configuration.
          */
-        const bool        DB_SSL_      = false;
-        const uint8_t     DB_MAX_CONN_ = 10;
-        const uint16_t    DB_PORT_     = 5432;
-        const std::string DB_HOST_     = "172.20.0.2";
-        const std::string DB_NAME_     = "postgres";
-        const std::string DB_USER_     = "postgres";
-        const std::string DB_PASS_     = "postgres";
+        const bool        DB_SSL_              = false;
+        const bool        DB_JSON_PASSTHROUGH_ = false;
+        const bool        DB_FUSED_CASE_READ_  = true;
+        const bool        DB_REQUEST_LEASE_    = true;
+        const uint8_t     DB_MIN_CONN_         = 2;
+        const uint8_t     DB_MAX_CONN_         = 10;
+        const uint32_t    DB_IDLE_TIMEOUT_     = 300;   // seconds
+        const uint32_t    DB_GROW_WAIT_        = 10;    // milliseconds
+        const uint32_t    DB_IO_LEASE_WAIT_    = 50;    // milliseconds
+        const uint32_t    DB_REPLICA_MAX_LAG_  = 1000;  // milliseconds
+        const uint32_t    DB_READ_YOUR_WRITES_ = 5;     // seconds
+        const uint32_t    DB_IMPORT_CHUNK_     = 1000;  // rows
+        const uint32_t    DB_ID_BLOCK_         = 100;   // ids
+        const std::string DB_SCHEMA_SNAPSHOT_  = "";    // disabled, servers started in one directory would share the file
+        const uint32_t    DB_SCHEMA_POLL_      = 60;  // seconds
+        const uint16_t    DB_PORT_             = 5432;
+        const std::string DB_HOST_             = "172.20.0.2";
+        const std::string DB_NAME_             = "postgres";
+        const std::string DB_USER_             = "postgres";
+        const std::string DB_PASS_             = "postgres";
 
     };  // namespace Database
 
@@ -39,18 +53,20 @@ namespace Defaults
         /*
          * Default values for Server configuration.
          */
-        const uint16_t    SERVER_THREADS_        = 4;
-        const uint16_t    SERVER_PORT_           = 8080;
-        const std::string SERVER_NAME_           = "ProjectValhalla";
-        const std::string SERVER_VER_            = "1.0.0";
-        const std::string SERVER_DESC_           = "ProjectValhalla API";
-        const std::string SERVER_HOST_           = "0.0.0.0";
-        const uint8_t     SERVER_DEBUG_LEVEL_    = 1;
-        const bool        SERVER_LOG_TO_CONSOLE_ = true;
-        const bool        SERVER_LOG_TO_FILE_    = true;
-        const std::string SERVER_LOG_DIR_        = "./logs/";
-        const std::string SERVER_LOG_FILE_       = "server.log";
-        const std::string SERVER_UPLOAD_DIR_     = "./uploads/";
+        const uint16_t    SERVER_THREADS_              = 4;
+        const uint16_t    SERVER_PORT_                 = 8080;
+        const std::string SERVER_NAME_                 = "ProjectValhalla";
+        const std::string SERVER_VER_                  = "1.0.0";
+        const std::string SERVER_DESC_                 = "ProjectValhalla API";
+        const std::string SERVER_HOST_                 = "0.0.0.0";
+        const uint8_t     SERVER_DEBUG_LEVEL_          = 1;
+        const bool        SERVER_LOG_TO_CONSOLE_       = true;
+        const bool        SERVER_LOG_TO_FILE_          = true;
+        const std::string SERVER_LOG_DIR_              = "./logs/";
+        const std::string SERVER_LOG_FILE_             = "server.log";
+        const std::string SERVER_UPLOAD_DIR_           = "./uploads/";
+        const size_t      SERVER_MAX_BODY_SIZE_        = 1024 * 1024;       // bytes, drogon's default
+        const size_t      SERVER_IMPORT_MAX_BODY_SIZE_ = 64 * 1024 * 1024;  // bytes
 
     }  // namespace Server
 
@@ -76,4 +92,14 @@ namespace Defaults
         const uint16_t    PORT_       = 5000;
         const std::string QUEUE_PATH_ = "/enqueue";
     }  // namespace EmailSenderDaemon
+
+    namespace Cache
+    {
+        const uint32_t ENTITY_CACHE_SIZE_        = 10000;
+        const uint32_t ENTITY_CACHE_MAX_ENTRY_   = 65536;  // bytes
+        const uint32_t ENTITY_CACHE_TTL_         = 60;     // seconds, also how long another instance may serve a row written here
+        const uint32_t SEARCH_COUNT_CACHE_SIZE_  = 10000;
+        const uint32_t SEARCH_COUNT_CACHE_TTL_   = 10;     // seconds
+        const uint32_t SEARCH_COUNT_EXACT_LIMIT_ = 10000;  // rows, an uncached count reads up to this + 1 on its own connection
+    }  // namespace Cache
 };  // namespace Defaults
@@ -5,28 +5,41 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <functional>
 #include <jsoncons/basic_json.hpp>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
+#include <variant>
+#include <vector>
 
 #include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/idallocator.hpp"
+#include "database/preparedstatement.hpp"
+#include "database/requestlease.hpp"
+#include "database/resultdecoder.hpp"
 #include "entities/base/client.hpp"
 #include "entities/base/types.hpp"
 #include "entities/services/clinics/patient/patient.hpp"
 #include "gatekeeper/gatekeeper.hpp"
 #include "store/store.hpp"
+#include "utils/entitycache/entitycache.hpp"
 #include "utils/global/callback.hpp"
 #include "utils/global/global.hpp"
 #include "utils/global/http.hpp"
 #include "utils/jsonhelper/jsonhelper.hpp"
 #include "utils/message/message.hpp"
+#include "utils/searchcount/searchcount.hpp"
+#include "utils/searchfilter/searchfilter.hpp"
 
 using Search_t   = api::v2::Types::Search_t;
 using Client     = api::v2::Client;
@@ -40,6 +53,9 @@ class Controller
         try
         {
             databaseController = Store::getObject<DatabaseController>();
+            entityCache        = Store::getObject<EntityCache>();
+            searchCount        = Store::getObject<SearchCount>();
+            idAllocator        = Store::getObject<IdAllocator>();
         }
         catch (const std::exception &e)
         {
@@ -59,66 +75,206 @@ class Controller
     template <typename T>
     void Create(T &entity, CALLBACK_ &&callback)
     {
-        std::optional<std::string> (T::*sqlstatement)() = &T::getSqlCreateStatement;
-        cruds(entity, sqlstatement, dbexec, std::forward<CALLBACK_>(std::move(callback)));
+        std::optional<PreparedStatement> (T::*sqlstatement)() = &T::getSqlCreateStatement;
+        cruds(entity, sqlstatement, dbpexec, std::forward<CALLBACK_>(std::move(callback)));
     }
 
     template <typename T>
     void Read(T &entity, CALLBACK_ &&callback)
     {
-        std::optional<std::string> (T::*sqlstatement)() = &T::getSqlReadStatement;
-        cruds(entity, sqlstatement, dbrexec, std::forward<CALLBACK_>(std::move(callback)));
+        std::optional<PreparedStatement> (T::*sqlstatement)() = &T::getSqlReadStatement;
+        CALLBACK_ respond                                     = std::move(callback);
+
+        if (serveCached(entity, respond))
+        {
+            return;
+        }
+
+        if (databaseController->jsonPassThrough())
+        {
+            passThrough(entity, sqlstatement, std::move(respond));
+            return;
+        }
+        cruds(entity, sqlstatement, dbprexec, std::move(respond));
+    }
+    // Read of a case with its permission check fused into the statement fetching the row, authorize decides on the
+    // permission columns. A missing row is reported as not found, a refused check as the error authorize sets.
+    // It never answers from the cache, a cached row still needs its own permission check, see isCached.
+    template <typename T>
+    void ReadWithPermissions(T &entity, std::function<bool(const jsoncons::json &, api::v2::Http::Error &)> &&authorize, CALLBACK_ &&callback)
+    {
+        try
+        {
+            std::optional<EntityCache::Ticket> ticket = ticketOf(entity);
+            if (ticket.has_value())
+            {
+                callback = filling(std::move(ticket.value()), std::move(callback));
+            }
+
+            std::optional<PreparedStatement> statement = entity.getSqlReadWithPermissionsStatement();
+
+            if (!statement.has_value())
+            {
+                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, fmt::format("Failed to get SQL statement for {}.", entity.getTableName()));
+                return;
+            }
+
+            databaseController->executeReadPreparedRowsAsync(statement.value(),
+                [callback, authorize = std::move(authorize)](std::optional<ResultDecoder> &&rows) mutable
+                {
+                    try
+                    {
+                        if (!rows.has_value())
+                        {
+                            std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to execute read query.");
+                            return;
+                        }
+
+                        if (rows->rows() == 0)
+                        {
+                            std::move(callback)(api::v2::Http::Status::NOT_FOUND, "Requested item was not found.");
+                            return;
+                        }
+
+                        jsoncons::json permissions_j = rows->rowToJson(0);
+                        jsoncons::json entity_j      = permissions_j.at("entity");
+                        permissions_j.erase("entity");
+
+                        api::v2::Http::Error error;
+                        if (!authorize(permissions_j, error))
+                        {
+                            std::move(callback)(error.code, error.message);
+                            return;
+                        }
+
+                        // the row exists but its safe view hides it
+                        if (entity_j.is_null())
+                        {
+                            std::move(callback)(api::v2::Http::Status::NOT_FOUND, "Requested item was not found.");
+                            return;
+                        }
+
+                        std::move(callback)(api::v2::Http::Status::OK, entity_j.as<std::string>());
+                    }
+                    catch (const std::exception &e)
+                    {
+                        CRITICALMESSAGERESPONSE
+                    }
+                });
+        }
+        catch (const std::exception &e)
+        {
+            CRITICALMESSAGERESPONSE
+        }
     }
+
+    // whether Read would answer from the cache
+    template <typename T>
+    bool isCached(T &entity)
+    {
+        std::optional<EntityCache::Ticket> ticket = ticketOf(entity);
+        return ticket.has_value() && entityCache->contains(ticket.value());
+    }
+
     template <typename T>
     void Update(T &entity, CALLBACK_ &&callback)
     {
-        std::optional<std::string> (T::*sqlstatement)() = &T::getSqlUpdateStatement;
-        cruds(entity, sqlstatement, dbexec, std::forward<CALLBACK_>(std::move(callback)));
+        std::optional<PreparedStatement> (T::*sqlstatement)() = &T::getSqlUpdateStatement;
+        cruds(entity, sqlstatement, dbpexec, invalidating(entity, std::move(callback)));
     }
     template <typename T>
     void Delete(T &entity, CALLBACK_ &&callback)
     {
-        std::optional<std::string> (T::*sqlstatement)() = &T::getSqlDeleteStatement;
-        cruds(entity, sqlstatement, dbexec, std::forward<CALLBACK_>(std::move(callback)));
+        std::optional<PreparedStatement> (T::*sqlstatement)() = &T::getSqlDeleteStatement;
+        cruds(entity, sqlstatement, dbpexec, invalidating(entity, std::move(callback)));
     }
     template <typename T>
     void Search(T &entity, CALLBACK_ &&callback)
     {
-        jsoncons::json response_json;
-        response_json["more"]   = false;
-        response_json["offset"] = 0;
-
-        std::optional<jsoncons::json> query_results_json_array;
-        std::optional<std::string>    query;
+        std::optional<PreparedStatement> query;
 
         try
         {
             query = entity.getSqlSearchStatement();
 
-            if (query.has_value())
+            if (!query.has_value())
             {
-                bool isSqlInjection      = false;
-                query_results_json_array = databaseController->executeSearchQuery(query.value(), isSqlInjection);
+                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to create sql query");
+                return;
+            }
 
-                if (isSqlInjection)
-                {
-                    std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "A Sql Injection pattern is detected in generated query.");
-                    return;
-                }
+            const Search_t &searchdata = std::get<Search_t>(entity.getData());
+            size_t          limit      = searchdata.limit;
+            size_t          offset     = searchdata.offset;
+
+            // which predicates of a where filter an index serves, so clients can tell a slow filter from a slow server
+            std::string filters =
+                searchdata.compiled != nullptr ? fmt::format(R"(,"filters":{})", SearchFilter::describe(searchdata.compiled->predicates).to_string()) : "";
+
+            if (searchdata.count)
+            {
+                callback = counting(entity, std::move(callback));
+            }
+
+            if (searchdata.keyset)
+            {
+                seek(query.value(), searchdata, filters, std::move(callback));
+                return;
+            }
+
+            if (databaseController->jsonPassThrough())
+            {
+                databaseController->executeReadPreparedRowsAsync(query->asJsonPage(limit),
+                    [callback, limit, offset, filters](std::optional<ResultDecoder> &&page) mutable
+                    {
+                        try
+                        {
+                            std::optional<std::string_view> more    = page.has_value() && page->rows() != 0 ? page->cell(0, 0) : std::nullopt;
+                            std::optional<std::string_view> results = page.has_value() && page->rows() != 0 ? page->cell(0, 1) : std::nullopt;
+
+                            if (!more.has_value() || !results.has_value())
+                            {
+                                std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to execute search query.");
+                                return;
+                            }
+
+                            bool has_more = more.value() == "t";
+                            std::move(callback)(api::v2::Http::Status::OK,
+                                fmt::format(R"({{"more":{},"offset":{}{},"results":{}}})", has_more, has_more ? offset + limit : 0, filters, results.value()));
+                        }
+                        catch (const std::exception &e)
+                        {
+                            CRITICALMESSAGERESPONSE
+                        }
+                    });
+                return;
+            }
 
-                if (query_results_json_array.has_value() && !query_results_json_array->empty())
+            databaseController->executeReadPreparedRowsAsync(query.value(),
+                [callback, limit, offset, filters](std::optional<ResultDecoder> &&rows) mutable
                 {
-                    size_t results_count = query_results_json_array->size();
-                    if (results_count > std::get<Search_t>(entity.getData()).limit)
+                    try
                     {
-                        response_json["more"]   = true;
-                        response_json["offset"] = std::get<Search_t>(entity.getData()).offset + std::get<Search_t>(entity.getData()).limit;
-                        query_results_json_array->erase(query_results_json_array->array_range().end() - 1);
+                        if (!rows.has_value())
+                        {
+                            std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to execute search query.");
+                            return;
+                        }
+
+                        // the statement asks for limit + 1 rows, an extra row means there is another page
+                        bool more = rows->rows() > limit;
+
+                        std::string response = fmt::format(R"({{"more":{},"offset":{}{},"results":)", more, more ? offset + limit : 0, filters);
+                        rows->writeRows(response, limit);
+                        response.push_back('}');
+
+                        std::move(callback)(api::v2::Http::Status::OK, response);
                     }
-                }
-            }
-            response_json["results"] = query_results_json_array.value();
-            std::move(callback)(api::v2::Http::Status::OK, response_json.as<std::string>());
+                    catch (const std::exception &e)
+                    {
+                        CRITICALMESSAGERESPONSE
+                    }
+                });
         }
         catch (const std::exception &e)
         {
@@ -131,7 +287,7 @@ class Controller
         requires(std::is_base_of_v<Client, T>)
     {
         std::optional<std::string> (T::*sqlstatement)() = &T::getSqlSuspendStatement;
-        cruds(entity, sqlstatement, dbexec, std::move(callback));
+        cruds(entity, sqlstatement, dbexec, invalidating(entity, std::move(callback)));
     }
 
     template <typename T>
@@ -139,15 +295,14 @@ class Controller
         requires(std::is_base_of_v<Client, T>)
     {
         std::optional<std::string> (T::*sqlstatement)() = &T::getSqlActivateStatement;
-        cruds(entity, sqlstatement, dbexec, std::move(callback));
+        cruds(entity, sqlstatement, dbexec, invalidating(entity, std::move(callback)));
     }
 
     template <typename T>
     void GetServices(T &entity, CALLBACK_ &&callback)
         requires(std::is_base_of_v<Client, T>)
     {
-        std::optional<jsoncons::json> services;
-        std::optional<std::string>    query;
+        std::optional<std::string> query;
 
         try
         {
@@ -157,19 +312,21 @@ class Controller
             {
                 bool isSqlInjection = false;
 
-                services = databaseController->executeSearchQuery(query.value(), isSqlInjection);
+                databaseController->executeSearchQueryAsync(query.value(), isSqlInjection,
+                    [callback](std::optional<jsoncons::json::array> &&services) mutable
+                    {
+                        if (services.has_value())
+                        {
+                            std::move(callback)(api::v2::Http::Status::OK, api::v2::JsonHelper::stringify(jsoncons::json(services.value())));
+                            return;
+                        }
+                        std::move(callback)(api::v2::Http::Status::OK, "[]");
+                    });
+
                 if (isSqlInjection)
                 {
                     std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "A Sql Injection pattern is detected in generated query.");
-                    return;
                 }
-
-                if (services.has_value())
-                {
-                    std::move(callback)(api::v2::Http::Status::OK, api::v2::JsonHelper::stringify(services.value()));
-                    return;
-                }
-                std::move(callback)(api::v2::Http::Status::OK, "[]");
             }
         }
         catch (const std::exception &e)
@@ -182,88 +339,494 @@ class Controller
     void GetVisits(T &entity, CALLBACK_ &&callback)
         requires std::is_same<T, Patient>::value
     {
-        jsoncons::json             visits;
-        std::optional<std::string> query;
-
         try
         {
-            query = entity.getSqlGetVisitsStatement();
+            PreparedStatement statement = entity.getSqlGetVisitsStatement();
 
-            if (query.has_value())
+            if (databaseController->jsonPassThrough())
             {
-                bool isSqlInjection = false;
-                visits              = databaseController->executeSearchQuery(query.value(), isSqlInjection);
-
-                if (isSqlInjection)
-                {
-                    std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "A Sql Injection pattern is detected in generated query.");
-                    return;
-                }
+                databaseController->executeReadPreparedRowsAsync(statement.asJsonArray(),
+                    [callback](std::optional<ResultDecoder> &&rows) mutable
+                    {
+                        try
+                        {
+                            // the statement always yields one row, none means the query failed
+                            std::optional<std::string_view> visits = rows.has_value() && rows->rows() != 0 ? rows->cell(0, 0) : std::nullopt;
+                            if (!visits.has_value())
+                            {
+                                std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to get visits.");
+                                return;
+                            }
+                            std::move(callback)(api::v2::Http::Status::OK, std::string(visits.value()));
+                        }
+                        catch (const std::exception &e)
+                        {
+                            CRITICALMESSAGERESPONSE
+                        }
+                    });
+                return;
             }
 
-            std::move(callback)(api::v2::Http::Status::OK, api::v2::JsonHelper::stringify(visits));
+            databaseController->executeSearchPreparedAsync(statement,
+                [callback](std::optional<jsoncons::json::array> &&visits) mutable
+                {
+                    try
+                    {
+                        if (!visits.has_value())
+                        {
+                            std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to get visits.");
+                            return;
+                        }
+                        std::move(callback)(api::v2::Http::Status::OK, api::v2::JsonHelper::stringify(jsoncons::json(std::move(visits.value()))));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        CRITICALMESSAGERESPONSE
+                    }
+                });
         }
         catch (const std::exception &e)
         {
-            CRITICALMESSAGE
+            CRITICALMESSAGERESPONSE
         }
     }
 
    private:
     std::shared_ptr<DatabaseController> databaseController;
-    std::optional<jsoncons::json> (DatabaseController::*dbexec)(const std::string &, bool &)  = &DatabaseController::executeQuery;
-    std::optional<jsoncons::json> (DatabaseController::*dbrexec)(const std::string &, bool &) = &DatabaseController::executeReadQuery;
+    std::shared_ptr<EntityCache>        entityCache;
+    std::shared_ptr<SearchCount>        searchCount;
+    std::shared_ptr<IdAllocator>        idAllocator;
+    void (DatabaseController::*dbexec)(const std::string &, bool &, DatabaseController::JsonCallback &&)  = &DatabaseController::executeQueryAsync;
+    void (DatabaseController::*dbrexec)(const std::string &, bool &, DatabaseController::JsonCallback &&) = &DatabaseController::executeReadQueryAsync;
+    void (DatabaseController::*dbpexec)(const PreparedStatement &, DatabaseController::JsonCallback &&)  = &DatabaseController::executePreparedAsync;
+    void (DatabaseController::*dbprexec)(const PreparedStatement &, DatabaseController::JsonCallback &&) = &DatabaseController::executeReadPreparedAsync;
+
+    // Holds the answer of a search until its total arrived, or the total until the answer did, whichever comes last
+    // responds with the total spliced in as "count".
+    struct CountJoin
+    {
+        std::mutex                                 mutex;
+        std::optional<std::string>                 total;
+        std::optional<std::pair<int, std::string>> answer;
+        CALLBACK_                                  callback;
 
-   protected:
+        void setTotal(std::string value)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            total = std::move(value);
+            respond(lock);
+        }
+
+        void setAnswer(int status, const std::string &content)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            answer = std::make_pair(status, content);
+            respond(lock);
+        }
+
+       private:
+        void respond(std::unique_lock<std::mutex> &lock)
+        {
+            if (!total.has_value() || !answer.has_value())
+            {
+                return;
+            }
+
+            auto [status, content] = std::move(answer.value());
+            if (status == api::v2::Http::Status::OK && content.starts_with('{'))
+            {
+                content.insert(1, fmt::format(R"("count":{},)", total.value()));
+            }
+            lock.unlock();
+            std::move(callback)(status, content);
+        }
+    };
+
+    // Counts the search while its page is read and wraps the callback so the answer carries the total. Up to the exact
+    // limit the rows are counted, beyond it the planner estimate is reported. A failed count answers null, the page is
+    // still served.
     template <typename T>
-    std::optional<uint64_t> getNextID(api::v2::Http::Error &error)
+    CALLBACK_ counting(const T &entity, CALLBACK_ &&callback)
     {
-        try
+        std::optional<PreparedStatement> count    = entity.getSqlSearchCountStatement(searchCount->exactLimit() + 1);
+        std::optional<PreparedStatement> estimate = entity.getSqlSearchEstimateStatement();
+
+        auto join      = std::make_shared<CountJoin>();
+        join->callback = std::move(callback);
+
+        CALLBACK_ wrapped = [join](int status, const std::string &content) { join->setAnswer(status, content); };
+
+        if (!count.has_value() || !estimate.has_value())
         {
-            bool                          isSqlInjection = false;
-            std::optional<jsoncons::json> json_nextval =
-                databaseController->executeQuery(fmt::format("SELECT NEXTVAL('{}_id_seq');", T::getTableName()), isSqlInjection);
+            join->setTotal(SearchCount::toJson(std::nullopt));
+            return wrapped;
+        }
 
-            if (isSqlInjection)
+        // a total counted inside a request transaction may include its uncommitted rows, it is not shared
+        bool shared = !RequestLease::inTransaction();
+
+        std::optional<SearchCount::Total> cached = shared ? searchCount->get(count.value()) : std::nullopt;
+        if (cached.has_value())
+        {
+            join->setTotal(SearchCount::toJson(cached));
+            return wrapped;
+        }
+
+        databaseController->executeReadPreparedRowsAsync(count.value(),
+            [join, counter = searchCount, shared, database = databaseController, count = count.value(), estimate = std::move(estimate.value())](
+                std::optional<ResultDecoder> &&rows) mutable
             {
-                error.message = "A Sql Injection pattern is detected in generated query.";
-                error.code    = api::v2::Http::Status::BAD_REQUEST;
-                return std::nullopt;
+                try
+                {
+                    std::optional<std::string_view> cell = rows.has_value() && rows->rows() != 0 ? rows->cell(0, 0) : std::nullopt;
+                    if (!cell.has_value())
+                    {
+                        join->setTotal(SearchCount::toJson(std::nullopt));
+                        return;
+                    }
+
+                    uint64_t counted = std::stoull(std::string(cell.value()));
+                    if (counted <= counter->exactLimit())
+                    {
+                        SearchCount::Total total{.rows = counted, .exact = true};
+                        if (shared)
+                        {
+                            counter->insert(count, total);
+                        }
+                        join->setTotal(SearchCount::toJson(total));
+                        return;
+                    }
+
+                    database->executeReadPreparedRowsAsync(estimate,
+                        [join, counter, shared, count, counted](std::optional<ResultDecoder> &&plan) mutable
+                        {
+                            std::optional<std::string_view> cell = plan.has_value() && plan->rows() != 0 ? plan->cell(0, 0) : std::nullopt;
+                            std::optional<uint64_t>         rows = cell.has_value() ? SearchCount::planRows(cell.value()) : std::nullopt;
+                            if (!rows.has_value())
+                            {
+                                join->setTotal(SearchCount::toJson(std::nullopt));
+                                return;
+                            }
+
+                            // the count already proved there are more rows than the limit, an estimate below it is stale statistics
+                            SearchCount::Total total{.rows = std::max(rows.value(), counted), .exact = false};
+                            if (shared)
+                            {
+                                counter->insert(count, total);
+                            }
+                            join->setTotal(SearchCount::toJson(total));
+                        });
+                }
+                catch (const std::exception &e)
+                {
+                    Message::ErrorMessage("Failed to count the search results.");
+                    Message::CriticalMessage(e.what());
+                    join->setTotal(SearchCount::toJson(std::nullopt));
+                }
+            });
+
+        return wrapped;
+    }
+
+    // Search with a keyset cursor, the answer carries the cursor of the next page instead of its offset
+    void seek(const PreparedStatement &query, const Search_t &searchdata, const std::string &filters, CALLBACK_ &&callback)
+    {
+        size_t limit = searchdata.limit;
+
+        if (databaseController->jsonPassThrough())
+        {
+            databaseController->executeReadPreparedRowsAsync(query.asJsonSeekPage(limit, searchdata.order_by),
+                [callback, searchdata, filters](std::optional<ResultDecoder> &&page) mutable
+                {
+                    try
+                    {
+                        std::optional<std::string_view> more    = page.has_value() && page->rows() != 0 ? page->cell(0, 0) : std::nullopt;
+                        std::optional<std::string_view> results = page.has_value() && page->rows() != 0 ? page->cell(0, 1) : std::nullopt;
+
+                        if (!more.has_value() || !results.has_value())
+                        {
+                            std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to execute search query.");
+                            return;
+                        }
+
+                        bool        has_more = more.value() == "t" && searchdata.limit != 0;
+                        std::string cursor   = has_more ? cursorOf(searchdata, page->cell(0, 2), page->cell(0, 3)) : "null";
+
+                        std::move(callback)(
+                            api::v2::Http::Status::OK, fmt::format(R"({{"more":{},"cursor":{}{},"results":{}}})", has_more, cursor, filters, results.value()));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        CRITICALMESSAGERESPONSE
+                    }
+                });
+            return;
+        }
+
+        databaseController->executeReadPreparedRowsAsync(query,
+            [callback, searchdata, filters](std::optional<ResultDecoder> &&rows) mutable
+            {
+                try
+                {
+                    if (!rows.has_value())
+                    {
+                        std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to execute search query.");
+                        return;
+                    }
+
+                    size_t limit  = searchdata.limit;
+                    bool   more   = rows->rows() > limit && limit != 0;
+                    auto   column = rows->columnIndex(searchdata.order_by);
+                    auto   id     = rows->columnIndex("id");
+
+                    std::string cursor = more && column.has_value() && id.has_value()
+                                             ? cursorOf(searchdata, rows->cell(limit - 1, column.value()), rows->cell(limit - 1, id.value()))
+                                             : "null";
+
+                    std::string response = fmt::format(R"({{"more":{},"cursor":{}{},"results":)", more, cursor, filters);
+                    rows->writeRows(response, limit);
+                    response.push_back('}');
+
+                    std::move(callback)(api::v2::Http::Status::OK, response);
+                }
+                catch (const std::exception &e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
+    }
+
+    // the next page cursor as a json value
+    static std::string cursorOf(const Search_t &searchdata, std::optional<std::string_view> value, std::optional<std::string_view> id)
+    {
+        if (!id.has_value())
+        {
+            return "null";
+        }
+        return fmt::format(R"("{}")", searchdata.encodeCursor(value, id.value()));
+    }
+
+    // the cache ticket of a read by id, nullopt if the cache is disabled. A request transaction reads its own uncommitted
+    // rows, they are neither served from nor put into the shared cache
+    template <typename T>
+    std::optional<EntityCache::Ticket> ticketOf(T &entity)
+    {
+        if (RequestLease::inTransaction())
+        {
+            return std::nullopt;
+        }
+
+        const Read_t &read = std::get<Read_t>(entity.getData());
+        return read.get_id().has_value() ? entityCache->ticket(entity.getTableName(), read.get_id().value(), read.get_data()) : std::nullopt;
+    }
+
+    // wraps the callback so a successful read fills the cache
+    CALLBACK_ filling(EntityCache::Ticket &&ticket, CALLBACK_ &&callback)
+    {
+        return [cache = entityCache, ticket = std::move(ticket), callback = std::move(callback)](int status, const std::string &content) mutable
+        {
+            if (status == api::v2::Http::Status::OK)
+            {
+                cache->insert(ticket, content);
             }
+            std::move(callback)(status, content);
+        };
+    }
+
+    // answers a read from the entity cache, on a miss the callback is wrapped so a successful read fills the cache
+    template <typename T>
+    bool serveCached(T &entity, CALLBACK_ &callback)
+    {
+        std::optional<EntityCache::Ticket> ticket = ticketOf(entity);
+        if (!ticket.has_value())
+        {
+            return false;
+        }
+
+        std::optional<std::string> body = entityCache->get(ticket.value());
+        if (body.has_value())
+        {
+            std::move(callback)(api::v2::Http::Status::OK, body.value());
+            return true;
+        }
+
+        callback = filling(std::move(ticket.value()), std::move(callback));
+        return false;
+    }
 
-            if (!json_nextval.has_value() || json_nextval->empty())
+    // drops the cached reads of the entity a mutation touches, once before it runs so no new read
+    // is cached from the old row and once after it completed so a read that raced it is dropped too
+    template <typename T>
+    CALLBACK_ invalidating(const T &entity, CALLBACK_ &&callback)
+    {
+        std::optional<uint64_t> id = std::visit(
+            [](const auto &data) -> std::optional<uint64_t>
             {
-                error.message = fmt::format(
-                    "nextID from seq function of {} failed, could not create a "
-                    "new ID.",
-                    T::getTableName());
-                error.code = api::v2::Http::Status::CONFLICT;
-                Message::ErrorMessage(error.message);
-                return std::nullopt;
+                if constexpr (requires { data.get_id(); })
+                {
+                    return data.get_id();
+                }
+                else if constexpr (requires { data.entity_id; })
+                {
+                    return data.entity_id;
+                }
+                else if constexpr (requires { data.client_id; })
+                {
+                    return data.client_id;
+                }
+                else
+                {
+                    return std::nullopt;
+                }
+            },
+            entity.getData());
+
+        if (!id.has_value())
+        {
+            return std::move(callback);
+        }
+
+        std::string table = entity.getTableName();
+        entityCache->invalidate(table, id.value());
+
+        return [cache = entityCache, table = std::move(table), id = id.value(), callback = std::move(callback)](int status, const std::string &content) mutable
+        {
+            cache->invalidate(table, id);
+            std::move(callback)(status, content);
+        };
+    }
+
+   protected:
+    void executeBatch(std::vector<PreparedStatement> &&statements, DatabaseController::BatchCallback &&callback)
+    {
+        databaseController->executeBatchAsync(std::move(statements), std::move(callback));
+    }
+
+    std::optional<size_t> copyRows(const std::vector<CopyRows> &groups, std::string &error) { return databaseController->copyRows(groups, error); }
+
+    // Runs labelled statements in one transaction, all of them apply or none does. Each statement is wrapped with
+    // asJsonReturning and its rows are appended to the array named by its label in the answer. The batch goes through
+    // the loop's pipeline inside BEGIN/COMMIT, so the IO thread does not wait for it. The cached reads of touched are
+    // dropped around it. A batch rejected by a constraint or a serialization failure is a conflict, any other failure is ours.
+    void Batch(const std::string &table, std::vector<std::pair<std::string, PreparedStatement>> &&statements, const std::vector<uint64_t> &touched,
+        CALLBACK_ &&callback)
+    {
+        try
+        {
+            jsoncons::json                 response;
+            std::vector<PreparedStatement> wrapped;
+            std::vector<std::string>       labels;
+            wrapped.reserve(statements.size());
+            labels.reserve(statements.size());
+
+            for (const auto &[label, statement] : statements)
+            {
+                response[label] = jsoncons::json::array();
+                wrapped.push_back(statement.asJsonReturning());
+                labels.push_back(label);
             }
 
-            auto obj = json_nextval->find("nextval");
-            if (obj != json_nextval->object_range().end())
+            for (uint64_t id : touched)
             {
-                return obj->value().as<uint64_t>();
+                entityCache->invalidate(table, id);
             }
+
+            databaseController->executeBatchAsync(std::move(wrapped),
+                [cache = entityCache, table, touched, labels = std::move(labels), response = std::move(response), callback = std::move(callback)](
+                    std::optional<std::vector<jsoncons::json>> &&results, const std::string &sqlstate) mutable
+                {
+                    try
+                    {
+                        for (uint64_t id : touched)
+                        {
+                            cache->invalidate(table, id);
+                        }
+
+                        if (!results.has_value() || results->size() != labels.size())
+                        {
+                            // class 23 is an integrity constraint violation, class 40 a serialization failure or deadlock
+                            if (sqlstate.starts_with("23") || sqlstate.starts_with("40"))
+                            {
+                                std::move(callback)(api::v2::Http::Status::CONFLICT, "The batch conflicts with the stored data, no operation was applied.");
+                                return;
+                            }
+                            std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to execute the batch, no operation was applied.");
+                            return;
+                        }
+
+                        for (size_t index = 0; index < labels.size(); ++index)
+                        {
+                            jsoncons::json rows = jsoncons::json::parse(results->at(index).at("rows").as<std::string>());
+                            for (auto &row : rows.array_range())
+                            {
+                                response[labels[index]].push_back(std::move(row));
+                            }
+                        }
+
+                        std::move(callback)(api::v2::Http::Status::OK, api::v2::JsonHelper::stringify(response));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        CRITICALMESSAGERESPONSE
+                    }
+                });
         }
         catch (const std::exception &e)
         {
-            CRITICALMESSAGE
+            CRITICALMESSAGERESPONSE
         }
-        return std::nullopt;
+    }
+
+    // Hands count ids of T and the callback to then, or answers the callback when no ids could be reserved. The ids
+    // come from the block IdAllocator keeps in memory, when it has run dry then is called on this loop once the next
+    // block arrived, the loop is never blocked waiting for it.
+    template <typename T, typename Then>
+    void withNextIDs(size_t count, CALLBACK_ &&callback, Then &&then)
+    {
+        // a block that arrives later continues the request under its lease
+        idAllocator->next(T::getTableName(), count,
+            RequestLease::bind(
+                [count, callback = std::move(callback), then = std::forward<Then>(then)](std::optional<std::vector<uint64_t>> &&ids) mutable
+                {
+                    if (!ids.has_value())
+                    {
+                        std::string message = fmt::format("nextID from seq function of {} failed, could not create {} new IDs.", T::getTableName(), count);
+                        Message::ErrorMessage(message);
+                        std::move(callback)(api::v2::Http::Status::CONFLICT, fmt::format("Failed to generate next ID, {}.", message));
+                        return;
+                    }
+                    then(std::move(callback), std::move(ids.value()));
+                }));
+    }
+
+    // count ids of T at once, waiting for a reservation if need be, for the import workers
+    template <typename T>
+    std::optional<std::vector<uint64_t>> getNextIDs(size_t count, api::v2::Http::Error &error)
+    {
+        std::optional<std::vector<uint64_t>> ids = idAllocator->nextBlocking(T::getTableName(), count);
+
+        if (!ids.has_value())
+        {
+            error.message = fmt::format("nextID from seq function of {} failed, could not create {} new IDs.", T::getTableName(), count);
+            error.code    = api::v2::Http::Status::CONFLICT;
+            Message::ErrorMessage(error.message);
+        }
+        return ids;
     }
 
     ///////////////////////////
-    template <typename S, typename T>
-    bool get_sql_statement(std::optional<std::string> &query, T &entity, S &sqlstatement, std::string &error)
+    template <typename Q, typename S, typename T>
+    bool get_sql_statement(std::optional<Q> &query, T &entity, S &sqlstatement, std::string &error)
     {
         query = (entity.*sqlstatement)();
-        if (query.has_value() && GateKeeper::isQuerySqlInjection(query.value()))
+        // prepared statements bind their values, only literal sql needs to be scanned
+        if constexpr (std::is_same_v<Q, std::string>)
         {
-            error = "A Sql Injection pattern is detected in generated query.";
-            return false;
+            if (query.has_value() && GateKeeper::isQuerySqlInjection(query.value()))
+            {
+                error = "A Sql Injection pattern is detected in generated query.";
+                return false;
+            }
         }
         if (!query.has_value())
         {
@@ -275,10 +838,10 @@ class Controller
     }
 
     template <typename S, typename T>
-    void cruds(T &entity, S &sqlstatement, std::optional<jsoncons::json> (DatabaseController::*func)(const std::string &, bool &), CALLBACK_ &&callback)
+    void cruds(T &entity, S &sqlstatement, void (DatabaseController::*func)(const std::string &, bool &, DatabaseController::JsonCallback &&),
+        CALLBACK_ &&callback)
     {
-        std::optional<jsoncons::json> results_j;
-        std::optional<std::string>    query;
+        std::optional<std::string> query;
         try
         {
             std::string error;
@@ -288,10 +851,47 @@ class Controller
                 return;
             }
 
-            if (query.has_value())
+            bool isSqlInjection = false;
+            (*databaseController.*func)(query.value(), isSqlInjection, respondWith(callback));
+
+            if (isSqlInjection)
+            {
+                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "A Sql Injection pattern is detected in generated query.");
+            }
+        }
+        catch (const std::exception &e)
+        {
+            CRITICALMESSAGE
+        }
+    }
+
+    template <typename S, typename T>
+    void cruds(T &entity, S &sqlstatement, void (DatabaseController::*func)(const PreparedStatement &, DatabaseController::JsonCallback &&), CALLBACK_ &&callback)
+    {
+        std::optional<PreparedStatement> statement;
+        try
+        {
+            std::string error;
+            if (!get_sql_statement(statement, entity, sqlstatement, error))
+            {
+                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, error);
+                return;
+            }
+
+            (*databaseController.*func)(statement.value(), respondWith(callback));
+        }
+        catch (const std::exception &e)
+        {
+            CRITICALMESSAGE
+        }
+    }
+
+    static DatabaseController::JsonCallback respondWith(const CALLBACK_ &callback)
+    {
+        return [callback](std::optional<jsoncons::json> &&results_j) mutable
+        {
+            try
             {
-                bool isSqlInjection = false;
-                results_j           = (*databaseController.*func)(query.value(), isSqlInjection);
                 if (results_j.has_value())
                 {
                     if (!results_j->empty())
@@ -306,6 +906,45 @@ class Controller
 
                 std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to create sql query");
             }
+            catch (const std::exception &e)
+            {
+                CRITICALMESSAGE
+            }
+        };
+    }
+
+    // Read in json pass-through mode, the body is the json text produced by Postgres
+    template <typename S, typename T>
+    void passThrough(T &entity, S &sqlstatement, CALLBACK_ &&callback)
+    {
+        std::optional<PreparedStatement> statement;
+        try
+        {
+            std::string error;
+            if (!get_sql_statement(statement, entity, sqlstatement, error))
+            {
+                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, error);
+                return;
+            }
+
+            databaseController->executeReadPreparedRowsAsync(statement->asJsonObject(),
+                [callback](std::optional<ResultDecoder> &&rows) mutable
+                {
+                    if (!rows.has_value())
+                    {
+                        std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to create sql query");
+                        return;
+                    }
+
+                    std::optional<std::string_view> body = rows->rows() != 0 ? rows->cell(0, 0) : std::nullopt;
+                    if (!body.has_value())
+                    {
+                        std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Query returned empty result, please recheck your parameters.");
+                        return;
+                    }
+
+                    std::move(callback)(api::v2::Http::Status::OK, std::string(body.value()));
+                });
         }
         catch (const std::exception &e)
         {
@@ -317,13 +956,13 @@ class Controller
     void addStaff(T &entity, CALLBACK_ &&callback)
     {
         std::optional<std::string> (T::*sqlstatement)() = &T::getSqlAddStaffStatement;
-        cruds(entity, sqlstatement, dbexec, std::move(callback));
+        cruds(entity, sqlstatement, dbexec, invalidating(entity, std::move(callback)));
     }
 
     template <typename T>
     void removeStaff(T &entity, CALLBACK_ &&callback)
     {
         std::optional<std::string> (T::*sqlstatement)() = &T::getSqlRemoveStaffStatement;
-        cruds(entity, sqlstatement, dbexec, std::move(callback));
+        cruds(entity, sqlstatement, dbexec, invalidating(entity, std::move(callback)));
     }
 };
@@ -79,27 +79,46 @@ void ClientController<T>::Update(CALLBACK_&& callback, const Requester&& request
 {
     try
     {
-        bool            success = false;
-        Validator::Rule rule(Validator::Rule::Action::ASSERT_IMMUTABLE, {"username", "password"});
-
-        HttpError      error;
-        UpdateClient_t client_data(data, _id, T::getTableName(), error, success, rule);
-
-        if (success)
+        if (!_id.has_value())
         {
-            T client(client_data);
-            if (!gateKeeper->canUpdate<T>(requester, _id.value(), error))
-            {
-                callback(error.code, error.message);
-                return;
-            }
-            Controller::Update(client, std::move(callback));
-        }
-        else
-        {
-            callback(error.code, fmt::format("ClientData parsing error: {}.", error.message));
+            callback(api::v2::Http::Status::BAD_REQUEST, "Missing client id.");
             return;
         }
+
+        // the body is parsed once allowed, the continuation owns it as the view does not outlive this frame
+        gateKeeper->canUpdate<T>(requester, _id.value(),
+            [this, callback = std::move(callback), body = std::string(data), _id](bool allowed, const HttpError& denied) mutable
+            {
+                try
+                {
+                    if (!allowed)
+                    {
+                        callback(denied.code, denied.message);
+                        return;
+                    }
+
+                    bool            success = false;
+                    Validator::Rule rule(Validator::Rule::Action::ASSERT_IMMUTABLE, {"username", "password"});
+
+                    HttpError      error;
+                    UpdateClient_t client_data(body, _id, T::getTableName(), error, success, rule);
+
+                    if (success)
+                    {
+                        T client(client_data);
+                        Controller::Update(client, std::move(callback));
+                    }
+                    else
+                    {
+                        callback(error.code, fmt::format("ClientData parsing error: {}.", error.message));
+                        return;
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception& e)
     {
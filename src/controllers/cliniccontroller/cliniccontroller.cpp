@@ -1,6 +1,25 @@
 #include "controllers/cliniccontroller/cliniccontroller.hpp"
 
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "controllers/entitycontroller/entitycontroller.hpp"
+#include "database/preparedstatement.hpp"
+#include "database/readrouter.hpp"
+#include "validator/databaseschema/databaseschema.hpp"
+#include "validator/validator.hpp"
 
 template <typename T>
 template <typename U>
@@ -93,7 +112,6 @@ template <typename U>
 void ClinicController<T>::GetVisitsImpl(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id)
     requires(std::is_same<U, Patient>::value)
 {
-    Http::Error error;
     try
     {
         if (!patient_id.has_value())
@@ -101,15 +119,30 @@ void ClinicController<T>::GetVisitsImpl(CALLBACK_ &&callback, const Requester &&
             callback(api::v2::Http::Status::BAD_REQUEST, "Missing patient id.");
             return;
         }
-        T entity((Types::Data_t(patient_id.value())));
 
-        if (!gateKeeper->canRead<T>(requester, patient_id.value(), error))
-        {
-            callback(error.code, error.message);
-            return;
-        }
+        gateKeeper->canRead<T>(requester, patient_id.value(),
+            [this, callback = std::move(callback), requester, id = patient_id.value()](bool allowed, const Http::Error &error) mutable
+            {
+                try
+                {
+                    if (!allowed)
+                    {
+                        callback(error.code, error.message);
+                        return;
+                    }
+
+                    T entity((Types::Data_t(id)));
+
+                    // the permissions may have arrived after the dispatching frame is gone, restore the client for the read
+                    ReadRouter::Scope scope(requester);
 
-        Controller::GetVisits(entity, std::move(callback));
+                    Controller::GetVisits(entity, std::move(callback));
+                }
+                catch (const std::exception &e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception &e)
     {
@@ -126,6 +159,23 @@ void ClinicController<T>::GetVisitsImpl(
     callback(api::v2::Http::Status::BAD_REQUEST, fmt::format("GetVisit is NOT implemented for entity type {}", T::getTableName()));
 }
 
+template <typename T>
+template <typename U>
+void ClinicController<T>::ImportImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType)
+    requires(std::is_same<U, Patient>::value || std::is_same<U, Visits>::value)
+{
+    EntityController<T>::Import(std::move(callback), std::move(requester), data, contentType);
+}
+
+template <typename T>
+template <typename U>
+void ClinicController<T>::ImportImpl(CALLBACK_ &&callback, [[maybe_unused]] const Requester &&requester, [[maybe_unused]] std::string_view data,
+    [[maybe_unused]] std::string_view contentType)
+    requires(!std::is_same<U, Patient>::value && !std::is_same<U, Visits>::value)
+{
+    callback(api::v2::Http::Status::BAD_REQUEST, fmt::format("Import is NOT implemented for entity type {}", T::getTableName()));
+}
+
 template <typename T>
 void ClinicController<T>::Create(CALLBACK_ &&callback, const Requester &&requester, std::string_view data)
 {
@@ -162,17 +212,296 @@ void ClinicController<T>::GetVisits(CALLBACK_ &&callback, const Requester &&requ
     GetVisitsImpl(std::move(callback), std::move(requester), patient_id);
 }
 
-#define INSTANTIATE_CLINIC_CONTROLLER(TYPE)                                                                                                             \
-    template void ClinicController<TYPE>::CreateImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                         \
-    template void ClinicController<TYPE>::DeleteImpl(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> id);                    \
-    template void ClinicController<TYPE>::SearchImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                         \
-    template void ClinicController<TYPE>::GetVisitsImpl(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id);         \
-    template void ClinicController<TYPE>::Create(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                             \
-    template void ClinicController<TYPE>::Read(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                               \
-    template void ClinicController<TYPE>::Update(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::optional<uint64_t> id); \
-    template void ClinicController<TYPE>::Delete(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> id);                        \
-    template void ClinicController<TYPE>::Search(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                             \
-    template void ClinicController<TYPE>::GetVisits(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id);
+template <typename T>
+void ClinicController<T>::Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType)
+{
+    ImportImpl(std::move(callback), std::move(requester), data, contentType);
+}
+
+template <typename T>
+void ClinicController<T>::Batch(CALLBACK_ &&callback, const Requester &&requester, std::string_view data)
+{
+    try
+    {
+        jsoncons::json request_j = jsoncons::json::parse(data);
+
+        if (!request_j.is_array() || request_j.empty())
+        {
+            callback(api::v2::Http::Status::BAD_REQUEST, "Batch expects a non empty array of operations.");
+            return;
+        }
+
+        if (request_j.size() > MAX_BATCH_OPERATIONS)
+        {
+            callback(api::v2::Http::Status::PAYLOAD_TOO_LARGE, fmt::format("A batch holds at most {} operations.", MAX_BATCH_OPERATIONS));
+            return;
+        }
+
+        constexpr bool allocatesIds = std::is_same<T, Patient>::value || std::is_same<T, Visits>::value;
+
+        Validator::Rule createRule(
+            (Validator::Rule::Action::IGNORE_IF_NOT_NULLABLE_IN_SCHEMA | Validator::Rule::Action::IGNORE_IF_MISSING_FROM_SCHEMA), {"id"});
+        Validator::Rule updateRule(Validator::Rule::Action::NONE, {});
+
+        std::vector<jsoncons::json>                      creates;
+        std::vector<std::pair<uint64_t, jsoncons::json>> updates;
+        std::vector<uint64_t>                            deletes;
+        std::unordered_set<uint64_t>                     touched;
+
+        // the parents the rows are created under, checked together once per clinic
+        std::unordered_set<uint64_t> parents;
+
+        Http::Error error;
+        size_t      index = 0;
+
+        auto reject = [&callback, &index](int code, const std::string &reason) { callback(code, fmt::format("Operation {}: {}", index, reason)); };
+
+        for (; index < request_j.size(); ++index)
+        {
+            const jsoncons::json &operation = request_j[index];
+
+            if (!operation.is_object() || !operation.contains("op") || !operation.at("op").is_string())
+            {
+                reject(api::v2::Http::Status::BAD_REQUEST, "op is missing.");
+                return;
+            }
+
+            std::string             op = operation.at("op").as<std::string>();
+            std::optional<uint64_t> id = operation.contains("id") && operation.at("id").is_uint64()
+                                             ? std::optional<uint64_t>(operation.at("id").as<uint64_t>())
+                                             : std::nullopt;
+
+            if (op == "create")
+            {
+                if (!operation.contains("data") || !operation.at("data").is_object())
+                {
+                    reject(api::v2::Http::Status::BAD_REQUEST, "data is missing.");
+                    return;
+                }
+
+                jsoncons::json row = operation.at("data");
+
+                if (!Validator::validateDatabaseCreateSchema(T::getTableName(), row, error, createRule))
+                {
+                    reject(error.code, fmt::format("Failed to validate data, {}.", error.message));
+                    return;
+                }
+
+                if constexpr (allocatesIds)
+                {
+                    // the id is allocated below, one sent by the client names nothing yet
+                    id = std::nullopt;
+                }
+                else
+                {
+                    if (!row.contains("id") || !row.at("id").is_uint64())
+                    {
+                        reject(api::v2::Http::Status::BAD_REQUEST, "id not provided.");
+                        return;
+                    }
+                    id = row.at("id").as<uint64_t>();
+                }
+
+                if (!row.contains(T::getCreateKey()) || !row.at(T::getCreateKey()).is_uint64())
+                {
+                    reject(api::v2::Http::Status::BAD_REQUEST, fmt::format("Missing {}.", T::getCreateKey()));
+                    return;
+                }
+
+                parents.insert(row.at(T::getCreateKey()).as<uint64_t>());
+
+                creates.push_back(std::move(row));
+            }
+            else if (op == "update")
+            {
+                if (!id.has_value())
+                {
+                    reject(api::v2::Http::Status::BAD_REQUEST, "No id provided.");
+                    return;
+                }
+
+                if (!operation.contains("data") || !operation.at("data").is_object() || operation.at("data").empty())
+                {
+                    reject(api::v2::Http::Status::BAD_REQUEST, "data is missing.");
+                    return;
+                }
+
+                if (!Validator::validateDatabaseUpdateSchema(T::getTableName(), operation.at("data"), error, updateRule))
+                {
+                    reject(error.code, fmt::format("Failed to validate data, {}.", error.message));
+                    return;
+                }
+
+                updates.emplace_back(id.value(), operation.at("data"));
+            }
+            else if (op == "delete")
+            {
+                if constexpr (!allocatesIds)
+                {
+                    reject(api::v2::Http::Status::BAD_REQUEST, fmt::format("Delete is NOT implemented for entity type {}", T::getTableName()));
+                    return;
+                }
+
+                if (!id.has_value())
+                {
+                    reject(api::v2::Http::Status::NOT_ACCEPTABLE, "Invalid id provided");
+                    return;
+                }
+
+                deletes.push_back(id.value());
+            }
+            else
+            {
+                reject(api::v2::Http::Status::BAD_REQUEST, fmt::format("Unknown op {}.", op));
+                return;
+            }
+
+            // the outcome of two operations on one entity would depend on their order within a statement
+            if (id.has_value() && !touched.insert(id.value()).second)
+            {
+                reject(api::v2::Http::Status::BAD_REQUEST, fmt::format("id {} appears in more than one operation.", id.value()));
+                return;
+            }
+        }
+
+        // the parents and the existing entities are checked together, once per clinic
+        std::vector<uint64_t> created(parents.begin(), parents.end());
+        std::vector<uint64_t> updated;
+        updated.reserve(updates.size());
+        for (const auto &update : updates)
+        {
+            updated.push_back(update.first);
+        }
+
+        if (!gateKeeper->canCreateMany<T>(requester, created, error) || !gateKeeper->canUpdateMany<T>(requester, updated, error) ||
+            !gateKeeper->canDeleteMany<T>(requester, deletes, error))
+        {
+            callback(error.code, error.message);
+            return;
+        }
+
+        std::vector<uint64_t> touchedIds(touched.begin(), touched.end());
+
+        if constexpr (allocatesIds)
+        {
+            if (!creates.empty())
+            {
+                size_t count = creates.size();
+                this->template withNextIDs<T>(count, std::move(callback),
+                    [this, requester, creates = std::move(creates), updates = std::move(updates), deletes = std::move(deletes),
+                        touchedIds = std::move(touchedIds)](CALLBACK_ &&callback, std::vector<uint64_t> &&ids) mutable
+                    {
+                        try
+                        {
+                            for (size_t i = 0; i < creates.size(); ++i)
+                            {
+                                creates[i]["id"] = ids.at(i);
+                            }
+
+                            // the ids may have arrived after the dispatching frame is gone, restore the client so the batch counts as its write
+                            ReadRouter::Scope scope(requester);
+
+                            runBatch(std::move(callback), std::move(creates), std::move(updates), std::move(deletes), std::move(touchedIds));
+                        }
+                        catch (const std::exception &e)
+                        {
+                            CRITICALMESSAGERESPONSE
+                        }
+                    });
+                return;
+            }
+        }
+
+        runBatch(std::move(callback), std::move(creates), std::move(updates), std::move(deletes), std::move(touchedIds));
+    }
+    catch (const std::exception &e)
+    {
+        CRITICALMESSAGERESPONSE
+    }
+}
+
+template <typename T>
+void ClinicController<T>::runBatch(CALLBACK_ &&callback, std::vector<jsoncons::json> &&creates, std::vector<std::pair<uint64_t, jsoncons::json>> &&updates,
+    std::vector<uint64_t> &&deletes, std::vector<uint64_t> &&touched)
+{
+    std::shared_ptr<const SCHEMA_t> schema       = DatabaseSchema::getDatabaseSchema();
+    auto                            table_schema = schema->find(T::getTableName());
+
+    if (table_schema == schema->end())
+    {
+        callback(api::v2::Http::Status::INTERNAL_SERVER_ERROR, fmt::format("No schema found for {}.", T::getTableName()));
+        return;
+    }
+
+    // one multi-row statement per distinct column set
+    std::map<std::vector<std::string>, std::vector<jsoncons::json>>                      createGroups;
+    std::map<std::vector<std::string>, std::vector<std::pair<uint64_t, jsoncons::json>>> updateGroups;
+
+    auto columnsOf = [](const jsoncons::json &row)
+    {
+        std::vector<std::string> columns;
+        for (const auto &iterator : row.object_range())
+        {
+            columns.push_back(iterator.key());
+        }
+        return columns;
+    };
+
+    for (auto &row : creates)
+    {
+        createGroups[columnsOf(row)].push_back(std::move(row));
+    }
+    for (auto &update : updates)
+    {
+        updateGroups[columnsOf(update.second)].push_back(std::move(update));
+    }
+
+    std::vector<std::pair<std::string, PreparedStatement>> statements;
+
+    for (const auto &group : createGroups)
+    {
+        std::optional<PreparedStatement> statement = T::getSqlBatchCreateStatement(T::getTableName(), group.second);
+        if (!statement.has_value())
+        {
+            callback(api::v2::Http::Status::BAD_REQUEST, fmt::format("Failed to get SQL statement for {}.", T::getTableName()));
+            return;
+        }
+        statements.emplace_back("created", std::move(statement.value()));
+    }
+
+    for (const auto &group : updateGroups)
+    {
+        std::optional<PreparedStatement> statement = T::getSqlBatchUpdateStatement(T::getTableName(), group.second, table_schema->second);
+        if (!statement.has_value())
+        {
+            callback(api::v2::Http::Status::BAD_REQUEST, fmt::format("Failed to get SQL statement for {}.", T::getTableName()));
+            return;
+        }
+        statements.emplace_back("updated", std::move(statement.value()));
+    }
+
+    if (!deletes.empty())
+    {
+        statements.emplace_back("deleted", T::getSqlBatchDeleteStatement(T::getTableName(), deletes));
+    }
+
+    Controller::Batch(T::getTableName(), std::move(statements), std::move(touched), std::move(callback));
+}
+
+#define INSTANTIATE_CLINIC_CONTROLLER(TYPE)                                                                                                                   \
+    template void ClinicController<TYPE>::CreateImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                               \
+    template void ClinicController<TYPE>::DeleteImpl(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> id);                          \
+    template void ClinicController<TYPE>::SearchImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                               \
+    template void ClinicController<TYPE>::GetVisitsImpl(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id);               \
+    template void ClinicController<TYPE>::Create(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                                   \
+    template void ClinicController<TYPE>::Read(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                                     \
+    template void ClinicController<TYPE>::Update(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::optional<uint64_t> id);       \
+    template void ClinicController<TYPE>::Delete(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> id);                              \
+    template void ClinicController<TYPE>::Search(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                                   \
+    template void ClinicController<TYPE>::GetVisits(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id);                   \
+    template void ClinicController<TYPE>::ImportImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType); \
+    template void ClinicController<TYPE>::Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType);     \
+    template void ClinicController<TYPE>::Batch(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);
 
 #include "gatekeeper/includes.hpp"  // IWYU pragma: keep
 // Instantiate for all entity types
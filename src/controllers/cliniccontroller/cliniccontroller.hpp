@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <jsoncons/json.hpp>
+#include <utility>
+#include <vector>
 
 #include "controllers/cliniccontroller/cliniccontrollerbase.hpp"
 #include "controllers/entitycontroller/entitycontroller.hpp"
@@ -46,6 +50,20 @@ class ClinicController : public EntityController<T>, public ClinicControllerBase
     void GetVisitsImpl(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id)
         requires(!std::is_same<U, Patient>::value);
 
+    template <typename U = T>
+    void ImportImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType)
+        requires(std::is_same<U, Patient>::value || std::is_same<U, Visits>::value);
+
+    template <typename U = T>
+    void ImportImpl(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType)
+        requires(!std::is_same<U, Patient>::value && !std::is_same<U, Visits>::value);
+
+    // builds the statements of a checked batch, the creates carry their ids, and runs them in one transaction
+    void runBatch(CALLBACK_ &&callback, std::vector<jsoncons::json> &&creates, std::vector<std::pair<uint64_t, jsoncons::json>> &&updates,
+        std::vector<uint64_t> &&deletes, std::vector<uint64_t> &&touched);
+
+    static constexpr size_t MAX_BATCH_OPERATIONS = 500;  // keeps the bind parameters of a multi-row statement below the protocol limit
+
    public:
     explicit ClinicController()  = default;
     ~ClinicController() override = default;
@@ -56,4 +74,10 @@ class ClinicController : public EntityController<T>, public ClinicControllerBase
     void Delete(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> id) final;
     void Search(CALLBACK_ &&callback, const Requester &&requester, std::string_view data) final;
     void GetVisits(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> patient_id) final;
+    void Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType) final;
+
+    // Creates, updates and deletes many entities in one transaction, the body is an array of
+    // {"op": "create" | "update" | "delete", "id": ..., "data": {...}}. Every operation is validated and permission
+    // checked before any is applied, and if one of them fails none is.
+    void Batch(CALLBACK_ &&callback, const Requester &&requester, std::string_view data) final;
 };
@@ -15,10 +15,12 @@ class ClinicControllerBase
     virtual ~ClinicControllerBase() = default;
 
     // CRUDS
-    virtual void Create(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                             = 0;
-    virtual void Read(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                               = 0;
-    virtual void Update(CALLBACK_&& callback, const Requester&& requester, std::string_view data, std::optional<uint64_t> id) = 0;
-    virtual void Delete(CALLBACK_&& callback, const Requester&& requester, std::optional<uint64_t> id)                        = 0;
-    virtual void Search(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                             = 0;
-    virtual void GetVisits(CALLBACK_&& callback, const Requester&& requester, std::optional<uint64_t> patient_id)             = 0;
+    virtual void Create(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                               = 0;
+    virtual void Read(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                                 = 0;
+    virtual void Update(CALLBACK_&& callback, const Requester&& requester, std::string_view data, std::optional<uint64_t> id)   = 0;
+    virtual void Delete(CALLBACK_&& callback, const Requester&& requester, std::optional<uint64_t> id)                          = 0;
+    virtual void Search(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                               = 0;
+    virtual void GetVisits(CALLBACK_&& callback, const Requester&& requester, std::optional<uint64_t> patient_id)               = 0;
+    virtual void Import(CALLBACK_&& callback, const Requester&& requester, std::string_view data, std::string_view contentType) = 0;
+    virtual void Batch(CALLBACK_&& callback, const Requester&& requester, std::string_view data)                                = 0;
 };
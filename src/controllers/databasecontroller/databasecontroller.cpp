@@ -1,38 +1,139 @@
 #include "databasecontroller.hpp"
 
 #include <fmt/core.h>
+#include <trantor/net/EventLoop.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
 #include <jsoncons/basic_json.hpp>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "configurator/configurator.hpp"
+#include "database/asyncdatabase.hpp"
 #include "database/database.hpp"
 #include "database/databaseconnectionpool.hpp"
+#include "database/readrouter.hpp"
+#include "database/replicaconnectionpool.hpp"
+#include "database/requestlease.hpp"
+#include "database/resultdecoder.hpp"
 #include "database/watchdog.hpp"
+#include "gatekeeper/gatekeeper.hpp"
 #include "store/store.hpp"
 #include "utils/global/types.hpp"
+#include "utils/message/message.hpp"
+#include "utils/singleflight/singleflight.hpp"
 
-DatabaseController::DatabaseController() : databaseConnectionPool_(Store::getObject<DatabaseConnectionPool>()), watchDog_(Store::getObject<WatchDog>()) {}
+DatabaseController::DatabaseController()
+    : databaseConnectionPool_(Store::getObject<DatabaseConnectionPool>()),
+      watchDog_(Store::getObject<WatchDog>()),
+      readRouter_(Store::getObject<ReadRouter>()),
+      replicaPool_(Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().replica_hosts.empty() ? nullptr
+                                                                                                               : Store::getObject<ReplicaConnectionPool>()),
+      jsonPassThrough_(Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().json_passthrough),
+      asyncFlights_(Store::getObject<SingleFlight<std::shared_ptr<PGresult>>>()),
+      readFlights_(Store::getObject<SingleFlight<std::optional<jsoncons::json>>>(), Store::getObject<SingleFlight<std::optional<jsoncons::json::array>>>(),
+          Store::getObject<SingleFlight<std::optional<std::string>>>(), Store::getObject<SingleFlight<std::optional<ResultDecoder>>>())
+{
+}
+
+std::unique_ptr<DatabaseHanndler> DatabaseController::leaseReplica()
+{
+    if (replicaPool_ == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<DatabaseHanndler> dbHandler = std::make_unique<DatabaseHanndler>(replicaPool_);
+    std::shared_ptr<Database>         db_ptr    = dbHandler->get_connection();
+
+    // the handler hands a lagging replica's connection straight back to its pool
+    if (db_ptr == nullptr || !replicaPool_->isHealthy(db_ptr->host()))
+    {
+        return nullptr;
+    }
+    return dbHandler;
+}
+
+std::shared_ptr<AsyncDatabase> DatabaseController::asyncTarget(bool readOnly)
+{
+    // the request transaction lives on the leased connection, the sync fallback runs on it
+    if (RequestLease::inTransaction())
+    {
+        return nullptr;
+    }
+
+    if (readOnly && replicaPool_ != nullptr && readRouter_->mayReadFromReplica())
+    {
+        std::optional<std::string> host = replicaPool_->pickHealthyHost();
+        if (host.has_value())
+        {
+            return AsyncDatabase::forCurrentLoop(host.value());
+        }
+    }
+    return AsyncDatabase::forCurrentLoop();
+}
+
+void DatabaseController::coalesce(const std::string &key, ResultCallback &&deliver, const std::function<void(ResultCallback &&)> &send)
+{
+    // a flight in progress may have started before this client's write
+    if (readRouter_->inWriteWindow())
+    {
+        send(std::move(deliver));
+        return;
+    }
+
+    trantor::EventLoop *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+
+    bool leader = asyncFlights_->join(key,
+        [loop, deliver = std::move(deliver)](const AsyncDatabase::ResultPtr &result)
+        {
+            // the result is only read from here on, so every waiter may decode it on its own loop
+            loop->runInLoop([deliver, result]() { deliver(AsyncDatabase::ResultPtr(result)); });
+        });
+
+    if (leader)
+    {
+        send([flights = asyncFlights_, key](AsyncDatabase::ResultPtr &&result) { flights->land(key, result); });
+    }
+}
+
+std::string DatabaseController::flightKey(const PreparedStatement &statement)
+{
+    // length prefixed so no two parameter lists map to the same key
+    std::string key = statement.name;
+    for (const auto &param : statement.params)
+    {
+        key += param.has_value() ? fmt::format("|{}:{}", param->size(), param.value()) : "|null";
+    }
+    return key;
+}
 std::optional<jsoncons::json> DatabaseController::executeQuery(const std::string &query, bool &isSqlInjection)
 {
+    readRouter_->noteWrite();
     return executer<jsoncons::json>(&Database::executeQuery<jsoncons::json, pqxx::work>, query, isSqlInjection);
 }
 
 std::optional<jsoncons::json> DatabaseController::executeReadQuery(const std::string &query, bool &isSqlInjection)
 {
-    return executer<jsoncons::json>(&Database::executeQuery<jsoncons::json, pqxx::nontransaction>, query, isSqlInjection);
+    return readExecuter<jsoncons::json>(flightKey(query), &Database::executeQuery<jsoncons::json, pqxx::nontransaction>, query, isSqlInjection);
 }
 
 std::optional<jsoncons::json ::array> DatabaseController::executeSearchQuery(const std::string &query, bool &isSqlInjection)
 {
-    return executer<jsoncons::json::array>(&Database::executeQuery<jsoncons::json::array, pqxx::nontransaction>, query, isSqlInjection);
+    return readExecuter<jsoncons::json::array>(flightKey(query), &Database::executeQuery<jsoncons::json::array, pqxx::nontransaction>, query, isSqlInjection);
 }
 
 std::optional<std::string> DatabaseController::doReadQuery(const std::string &query, bool &isSqlInjection)
 {
-    return executer<std::string>(&Database::doSimpleQuery<std::string>, query, isSqlInjection);
+    return readExecuter<std::string>(flightKey(query), &Database::doSimpleQuery<std::string>, query, isSqlInjection);
 }
 
 std::optional<bool> DatabaseController::checkItemExists(const std::string &table, const std::string &column, const std::string &value, bool &isSqlInjection)
@@ -52,14 +153,228 @@ std::optional<uint64_t> DatabaseController::findIfUserID(const std::string &user
     return executer<uint64_t>(&Database::doSimpleQuery<uint64_t>, query, isSqlInjection);
 }
 
-std::optional<std::unordered_set<api::v2::ColumnInfo>> DatabaseController::getTableSchema(const std::string &tableName)
+std::optional<std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>> DatabaseController::getSchema()
 {
-    return executer<std::unordered_set<api::v2::ColumnInfo>>(&Database::getTableSchema, tableName);
+    return executer<std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>>(&Database::getSchema);
 }
 
-std::optional<std::unordered_set<std::string>> DatabaseController::getAllTables() { return executer<std::unordered_set<std::string>>(&Database::getAllTables); }
-
 std::optional<jsoncons::json> DatabaseController::getPermissions(const std::string &query, bool &isSqlInjection)
 {
-    return executer<jsoncons::json>(&Database::executeQuery<jsoncons::json, pqxx::nontransaction>, query, isSqlInjection);
+    return readExecuter<jsoncons::json>(flightKey(query), &Database::executeQuery<jsoncons::json, pqxx::nontransaction>, query, isSqlInjection);
+}
+
+std::optional<jsoncons::json> DatabaseController::executePrepared(const PreparedStatement &statement)
+{
+    readRouter_->noteWrite();
+    return executer<jsoncons::json>(&Database::executePrepared<jsoncons::json, pqxx::work>, statement);
+}
+
+std::optional<jsoncons::json> DatabaseController::executeReadPrepared(const PreparedStatement &statement)
+{
+    return readExecuter<jsoncons::json>(flightKey(statement), &Database::executePrepared<jsoncons::json, pqxx::nontransaction>, statement);
+}
+
+std::optional<jsoncons::json::array> DatabaseController::executeSearchPrepared(const PreparedStatement &statement)
+{
+    return readExecuter<jsoncons::json::array>(flightKey(statement), &Database::executePrepared<jsoncons::json::array, pqxx::nontransaction>, statement);
+}
+
+std::optional<ResultDecoder> DatabaseController::executeReadPreparedRows(const PreparedStatement &statement)
+{
+    return readExecuter<ResultDecoder>(flightKey(statement), &Database::executePrepared<ResultDecoder, pqxx::nontransaction>, statement);
+}
+
+void DatabaseController::executeQueryAsync(const std::string &query, bool &isSqlInjection, JsonCallback &&callback)
+{
+    readRouter_->noteWrite();
+    asyncExecuter<jsoncons::json>(query, isSqlInjection, &DatabaseController::executeQuery, false, std::move(callback));
+}
+
+void DatabaseController::executeReadQueryAsync(const std::string &query, bool &isSqlInjection, JsonCallback &&callback)
+{
+    asyncExecuter<jsoncons::json>(query, isSqlInjection, &DatabaseController::executeReadQuery, true, std::move(callback));
+}
+
+void DatabaseController::executeSearchQueryAsync(const std::string &query, bool &isSqlInjection, ArrayCallback &&callback)
+{
+    asyncExecuter<jsoncons::json::array>(query, isSqlInjection, &DatabaseController::executeSearchQuery, true, std::move(callback));
+}
+
+template <typename jsonType>
+void DatabaseController::asyncExecuter(const std::string &query, bool &isSqlInjection,
+    std::optional<jsonType> (DatabaseController::*fallback)(const std::string &, bool &), bool readOnly,
+    std::function<void(std::optional<jsonType> &&)> &&callback)
+{
+    isSqlInjection = api::v2::GateKeeper::isQuerySqlInjection(query);
+
+    if (isSqlInjection)
+    {
+        return;
+    }
+
+    std::shared_ptr<AsyncDatabase> async_db = asyncTarget(readOnly);
+
+    // not called from an IO thread, run it on a pooled connection instead
+    if (async_db == nullptr)
+    {
+        bool fallbackSqlInjection = false;
+        callback((this->*fallback)(query, fallbackSqlInjection));
+        return;
+    }
+
+    // the result arrives after the request's frame is gone, the callback runs with its lease bound again
+    ResultCallback deliver = RequestLease::bind(
+        [callback = std::move(callback)](AsyncDatabase::ResultPtr &&result)
+        {
+            if (result == nullptr)
+            {
+                callback(std::nullopt);
+                return;
+            }
+
+            std::optional<jsonType> reply;
+            try
+            {
+                reply = ResultDecoder(std::move(result)).to<jsonType>();
+            }
+            catch (const std::exception &e)
+            {
+                Message::CriticalMessage(fmt::format("Failed to decode query result: {}", e.what()));
+            }
+            callback(std::move(reply));
+        });
+
+    if (!readOnly)
+    {
+        async_db->execute(query, std::move(deliver));
+        return;
+    }
+
+    coalesce(fmt::format("{}|{}", async_db->host(), flightKey(query)), std::move(deliver),
+        [async_db, query](ResultCallback &&land) { async_db->execute(query, std::move(land)); });
+}
+
+void DatabaseController::executePreparedAsync(const PreparedStatement &statement, JsonCallback &&callback)
+{
+    readRouter_->noteWrite();
+    asyncPreparedExecuter<jsoncons::json>(statement, &DatabaseController::executePrepared, false, std::move(callback));
+}
+
+void DatabaseController::executeReadPreparedAsync(const PreparedStatement &statement, JsonCallback &&callback)
+{
+    asyncPreparedExecuter<jsoncons::json>(statement, &DatabaseController::executeReadPrepared, true, std::move(callback));
+}
+
+void DatabaseController::executeSearchPreparedAsync(const PreparedStatement &statement, ArrayCallback &&callback)
+{
+    asyncPreparedExecuter<jsoncons::json::array>(statement, &DatabaseController::executeSearchPrepared, true, std::move(callback));
+}
+
+void DatabaseController::executeReadPreparedRowsAsync(const PreparedStatement &statement, RowsCallback &&callback)
+{
+    asyncPreparedExecuter<ResultDecoder>(statement, &DatabaseController::executeReadPreparedRows, true, std::move(callback));
+}
+
+std::optional<std::vector<jsoncons::json>> DatabaseController::executeBatch(const std::vector<PreparedStatement> &statements, std::string &sqlstate)
+{
+    readRouter_->noteWrite();
+    return executer<std::vector<jsoncons::json>>(&Database::executeBatch, statements, sqlstate);
+}
+
+std::optional<size_t> DatabaseController::copyRows(const std::vector<CopyRows> &groups, std::string &error)
+{
+    readRouter_->noteWrite();
+    return executer<size_t>(&Database::copyRows, groups, error);
+}
+
+void DatabaseController::executeBatchAsync(std::vector<PreparedStatement> &&statements, BatchCallback &&callback)
+{
+    readRouter_->noteWrite();
+
+    std::shared_ptr<AsyncDatabase> async_db = asyncTarget(false);
+
+    if (async_db == nullptr)
+    {
+        std::string                                sqlstate;
+        std::optional<std::vector<jsoncons::json>> replies = executeBatch(statements, sqlstate);
+        callback(std::move(replies), sqlstate);
+        return;
+    }
+
+    // a pipeline is one implicit transaction only until its sync, the explicit block keeps the batch atomic regardless
+    statements.insert(statements.begin(), PreparedStatement("BEGIN;", {}));
+    statements.emplace_back("COMMIT;", PreparedStatement::Params{});
+
+    async_db->executeBatch(std::move(statements),
+        RequestLease::bind(
+            [callback = std::move(callback)](std::optional<std::vector<AsyncDatabase::ResultPtr>> &&results, const std::string &sqlstate)
+            {
+                if (!results.has_value())
+                {
+                    callback(std::nullopt, sqlstate);
+                    return;
+                }
+
+                std::optional<std::vector<jsoncons::json>> replies = std::vector<jsoncons::json>{};
+                try
+                {
+                    // the results of BEGIN and COMMIT carry no rows
+                    replies->reserve(results->size() - 2);
+                    for (std::size_t index = 1; index + 1 < results->size(); ++index)
+                    {
+                        replies->push_back(ResultDecoder(std::move(results->at(index))).to<jsoncons::json>().value_or(jsoncons::json()));
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    Message::CriticalMessage(fmt::format("Failed to decode query result: {}", e.what()));
+                    replies.reset();
+                }
+                callback(std::move(replies), sqlstate);
+            }));
+}
+
+template <typename jsonType>
+void DatabaseController::asyncPreparedExecuter(const PreparedStatement &statement,
+    std::optional<jsonType> (DatabaseController::*fallback)(const PreparedStatement &), bool readOnly,
+    std::function<void(std::optional<jsonType> &&)> &&callback)
+{
+    std::shared_ptr<AsyncDatabase> async_db = asyncTarget(readOnly);
+
+    if (async_db == nullptr)
+    {
+        callback((this->*fallback)(statement));
+        return;
+    }
+
+    // the result arrives after the request's frame is gone, the callback runs with its lease bound again
+    ResultCallback deliver = RequestLease::bind(
+        [callback = std::move(callback)](AsyncDatabase::ResultPtr &&result)
+        {
+            if (result == nullptr)
+            {
+                callback(std::nullopt);
+                return;
+            }
+
+            std::optional<jsonType> reply;
+            try
+            {
+                reply = ResultDecoder(std::move(result)).to<jsonType>();
+            }
+            catch (const std::exception &e)
+            {
+                Message::CriticalMessage(fmt::format("Failed to decode query result: {}", e.what()));
+            }
+            callback(std::move(reply));
+        });
+
+    if (!readOnly)
+    {
+        async_db->executePrepared(statement, std::move(deliver));
+        return;
+    }
+
+    coalesce(fmt::format("{}|{}", async_db->host(), flightKey(statement)), std::move(deliver),
+        [async_db, &statement](ResultCallback &&land) { async_db->executePrepared(statement, std::move(land)); });
 }
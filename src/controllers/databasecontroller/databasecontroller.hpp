@@ -1,25 +1,39 @@
 #pragma once
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <trantor/net/EventLoop.h>
 
 #include <cstdint>
 #include <exception>
+#include <functional>
 #include <jsoncons/basic_json.hpp>
 #include <jsoncons/json.hpp>
 #include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
+#include "database/copyrows.hpp"
 #include "database/databasehandler.hpp"
+#include "database/preparedstatement.hpp"
+#include "database/requestlease.hpp"
+#include "database/resultdecoder.hpp"
+#include "store/store.hpp"
 #include "utils/global/types.hpp"
 #include "utils/message/message.hpp"
+#include "utils/singleflight/singleflight.hpp"
+class AsyncDatabase;
 class Case;
 class Service;
 class Appointment;
 class Database;
 class WatchDog;
+class ReplicaConnectionPool;
+class ReadRouter;
 class DatabaseController
 {
    public:
@@ -30,6 +44,11 @@ class DatabaseController
     DatabaseController &operator=(DatabaseController &&)      = delete;
     virtual ~DatabaseController()                             = default;
 
+    using JsonCallback  = std::function<void(std::optional<jsoncons::json> &&)>;
+    using ArrayCallback = std::function<void(std::optional<jsoncons::json::array> &&)>;
+    using RowsCallback  = std::function<void(std::optional<ResultDecoder> &&)>;
+    using BatchCallback = std::function<void(std::optional<std::vector<jsoncons::json>> &&, const std::string &sqlstate)>;
+
     std::optional<jsoncons::json>        executeQuery(const std::string &query, bool &isSqlInjection);
     std::optional<jsoncons::json>        executeReadQuery(const std::string &query, bool &isSqlInjection);
     std::optional<jsoncons::json::array> executeSearchQuery(const std::string &query, bool &isSqlInjection);
@@ -38,13 +57,119 @@ class DatabaseController
     std::optional<jsoncons::json>        getPasswordHashForUserName(const std::string &username, const std::string &tablename, bool &isSqlInjection);
     std::optional<uint64_t>              findIfUserID(
                      const std::string &username, const std::string &tablename, bool &isSqlInjection);  // check if user found and return 0 if not
-    std::optional<std::unordered_set<api::v2::ColumnInfo>> getTableSchema(const std::string &tableName);
-    std::optional<std::unordered_set<std::string>>         getAllTables();
+    std::optional<std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>> getSchema();
     std::optional<jsoncons::json>                          getPermissions(const std::string &query, bool &isSqlInjection);
 
+    // Non-blocking variants, the query runs on the event loop of the calling IO thread and the callback is invoked on
+    // that loop once the result arrives. The callback is not invoked if isSqlInjection is set.
+    void executeQueryAsync(const std::string &query, bool &isSqlInjection, JsonCallback &&callback);
+    void executeReadQueryAsync(const std::string &query, bool &isSqlInjection, JsonCallback &&callback);
+    void executeSearchQueryAsync(const std::string &query, bool &isSqlInjection, ArrayCallback &&callback);
+
+    // Prepared statements carry their values as bind parameters, so they skip the sql injection scan.
+    std::optional<jsoncons::json>        executePrepared(const PreparedStatement &statement);
+    std::optional<jsoncons::json>        executeReadPrepared(const PreparedStatement &statement);
+    std::optional<jsoncons::json::array> executeSearchPrepared(const PreparedStatement &statement);
+    std::optional<ResultDecoder>         executeReadPreparedRows(const PreparedStatement &statement);
+
+    // when set, read paths let Postgres build the json text (see PreparedStatement::asJsonArray) instead of decoding rows
+    [[nodiscard]] bool jsonPassThrough() const { return jsonPassThrough_; }
+
+    void executePreparedAsync(const PreparedStatement &statement, JsonCallback &&callback);
+    void executeReadPreparedAsync(const PreparedStatement &statement, JsonCallback &&callback);
+    void executeSearchPreparedAsync(const PreparedStatement &statement, ArrayCallback &&callback);
+    // hands over the undecoded rows so the caller can write them straight into the response body
+    void executeReadPreparedRowsAsync(const PreparedStatement &statement, RowsCallback &&callback);
+
+    // Sends a group of statements in one pipeline, i.e. one network round trip, inside one transaction and yields the
+    // first row of every statement in order. The batch applies as a whole or not at all, sqlstate tells why it did not
+    // (see Database::executeBatch).
+    std::optional<std::vector<jsoncons::json>> executeBatch(const std::vector<PreparedStatement> &statements, std::string &sqlstate);
+    void                                       executeBatchAsync(std::vector<PreparedStatement> &&statements, BatchCallback &&callback);
+
+    // bulk load with COPY, all groups in one transaction on a pooled connection (see Database::copyRows)
+    std::optional<size_t> copyRows(const std::vector<CopyRows> &groups, std::string &error);
+
    private:
     std::shared_ptr<DatabaseConnectionPool> databaseConnectionPool_;
     std::shared_ptr<WatchDog>               watchDog_;
+    std::shared_ptr<ReadRouter>             readRouter_;
+    std::shared_ptr<ReplicaConnectionPool>  replicaPool_;  // nullptr when no replica is configured
+    bool                                    jsonPassThrough_;
+
+    using ResultCallback = std::function<void(std::shared_ptr<PGresult> &&)>;
+
+    // identical async reads in flight against the same host share one raw result, every caller decodes its own copy
+    std::shared_ptr<SingleFlight<std::shared_ptr<PGresult>>> asyncFlights_;
+
+    // one flight table per result type of the blocking reads
+    std::tuple<std::shared_ptr<SingleFlight<std::optional<jsoncons::json>>>, std::shared_ptr<SingleFlight<std::optional<jsoncons::json::array>>>,
+        std::shared_ptr<SingleFlight<std::optional<std::string>>>, std::shared_ptr<SingleFlight<std::optional<ResultDecoder>>>>
+        readFlights_;
+
+    // a lease on a healthy replica, nullptr if there is none
+    std::unique_ptr<DatabaseHanndler> leaseReplica();
+    // the event loop connection reads or writes are sent to
+    std::shared_ptr<AsyncDatabase> asyncTarget(bool readOnly);
+
+    template <typename jsonType>
+    void asyncExecuter(const std::string &query, bool &isSqlInjection, std::optional<jsonType> (DatabaseController::*fallback)(const std::string &, bool &),
+        bool readOnly, std::function<void(std::optional<jsonType> &&)> &&callback);
+
+    template <typename jsonType>
+    void asyncPreparedExecuter(const PreparedStatement &statement, std::optional<jsonType> (DatabaseController::*fallback)(const PreparedStatement &),
+        bool readOnly, std::function<void(std::optional<jsonType> &&)> &&callback);
+
+    // sends the read unless an identical one is already in flight to the same host, the result reaches every caller on its own loop
+    void coalesce(const std::string &key, ResultCallback &&deliver, const std::function<void(ResultCallback &&)> &send);
+
+    // what makes two reads identical, the sql text or the prepared statement with its bind parameters
+    static const std::string &flightKey(const std::string &query) { return query; }
+    static std::string        flightKey(const PreparedStatement &statement);
+
+    // reads go to a replica when one may serve them and to the primary otherwise,
+    // concurrent identical reads to the same target share a single execution.
+    // Inside a request transaction the read has to see its writes, so it runs on the leased connection alone,
+    // and within the read-your-writes window it runs on its own, a flight in progress may have started before the write.
+    // A follower waits for the leader's thread, so an event loop never joins a flight, it runs the read itself
+    template <typename Result, typename Func, typename... Args>
+    std::optional<Result> readExecuter(const std::string &key, const Func &func, Args &&...args)
+    {
+        if (RequestLease::inTransaction())
+        {
+            return executer<Result>(func, std::forward<Args>(args)...);
+        }
+
+        bool replica = replicaPool_ != nullptr && readRouter_->mayReadFromReplica();
+
+        auto read = [&]() -> std::optional<Result>
+        {
+            try
+            {
+                std::unique_ptr<DatabaseHanndler> dbHandler = replica ? leaseReplica() : nullptr;
+
+                if (dbHandler != nullptr)
+                {
+                    return std::invoke(func, dbHandler->get_connection().get(), std::forward<Args>(args)...);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                Message::CriticalMessage(fmt::format("Exception occurred during replica query execution: {}", e.what()));
+                return std::nullopt;
+            }
+
+            return executer<Result>(func, std::forward<Args>(args)...);
+        };
+
+        if (readRouter_->inWriteWindow() || trantor::EventLoop::getEventLoopOfCurrentThread() != nullptr)
+        {
+            return read();
+        }
+
+        return std::get<std::shared_ptr<SingleFlight<std::optional<Result>>>>(readFlights_)->run(
+            fmt::format("{}|{}", replica ? "replica" : "primary", key), read);
+    }
 
     template <typename Result, typename Func, typename... Args>
     std::optional<Result> executer(const Func &func, Args &&...args)
@@ -1,22 +1,34 @@
 #include "controllers/entitycontroller/entitycontroller.hpp"
 
 #include <fmt/core.h>
+#include <fmt/ranges.h>
 
 #include <cstdint>
 #include <exception>
 #include <format>
 #include <jsoncons/basic_json.hpp>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "controllers/base/controller/controller.hpp"
 #include "controllers/entitycontroller/entitycontrollerbase.hpp"
+#include "database/copyrows.hpp"
+#include "database/readrouter.hpp"
+#include "database/requestlease.hpp"
 #include "entities/base/types.hpp"
 #include "utils/global/callback.hpp"
+#include "utils/global/concepts.hpp"
 #include "utils/global/http.hpp"
+#include "utils/rowreader/rowreader.hpp"
+#include "utils/searchfilter/searchfilter.hpp"
+#include "validator/databaseschema/databaseschema.hpp"
 #include "validator/validator.hpp"
 
 using HttpError = api::v2::Http::Error;
@@ -33,7 +45,6 @@ inline void __attribute((always_inline)) EntityController<T>::Create(CALLBACK_ &
         bool            success = false;
         HttpError       error;
         Validator::Rule rule((Validator::Rule::Action::IGNORE_IF_NOT_NULLABLE_IN_SCHEMA | Validator::Rule::Action::IGNORE_IF_MISSING_FROM_SCHEMA), {"id"});
-        auto            next_id = this->template getNextID<T>(error);
 
         std::optional<jsoncons::json> request_j = jsoncons::json::parse(data);
 
@@ -51,23 +62,19 @@ inline void __attribute((always_inline)) EntityController<T>::Create(CALLBACK_ &
             return;
         }
 
-        if (!gateKeeper->canCreate<T>(requester, request_j, error))
+        if constexpr (Case_t<T>)
         {
-            std::move(callback)(error.code, error.message);
+            createAfterPermissionCheck(std::move(callback), requester, std::move(request_j.value()));
             return;
         }
 
-        if (!next_id.has_value())
+        if (!gateKeeper->canCreate<T>(requester, request_j, error))
         {
-            std::move(callback)(error.code, fmt::format("Failed to generate next ID, {}.", error.message));
+            std::move(callback)(error.code, error.message);
             return;
         }
 
-        Create_t entity_data = Create_t(request_j.value(), next_id.value());
-
-        T entity(entity_data);
-
-        Controller::Create(entity, std::move(callback));
+        createWithNextID(std::move(callback), requester, std::move(request_j.value()));
     }
     catch (const std::exception &e)
     {
@@ -75,6 +82,70 @@ inline void __attribute((always_inline)) EntityController<T>::Create(CALLBACK_ &
     }
 }
 
+template <typename T>
+void EntityController<T>::createAfterPermissionCheck(CALLBACK_ &&callback, const Requester &requester, jsoncons::json &&request_j)
+{
+    std::optional<PreparedStatement> permissions = T::getPermissionsStatementForCreate(request_j);
+
+    if (!permissions.has_value())
+    {
+        std::move(callback)(api::v2::Http::Status::BAD_REQUEST, fmt::format("Failed to read {} from request body.", T::getCreateKey()));
+        return;
+    }
+
+    // the id is taken once the check passed, a refused create does not burn one
+    this->databaseController->executeReadPreparedAsync(permissions.value(),
+        [this, callback = std::move(callback), requester, request_j = std::move(request_j)](std::optional<jsoncons::json> &&permissions_j) mutable
+        {
+            try
+            {
+                HttpError error;
+
+                if (!permissions_j.has_value())
+                {
+                    std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, "Failed to check permissions.");
+                    return;
+                }
+
+                if (!gateKeeper->canCreateWithPermissions<T>(requester, permissions_j, error))
+                {
+                    std::move(callback)(error.code, error.message);
+                    return;
+                }
+
+                createWithNextID(std::move(callback), requester, std::move(request_j));
+            }
+            catch (const std::exception &e)
+            {
+                CRITICALMESSAGERESPONSE
+            }
+        });
+}
+
+template <typename T>
+void EntityController<T>::createWithNextID(CALLBACK_ &&callback, const Requester &requester, jsoncons::json &&request_j)
+{
+    this->template withNextIDs<T>(1, std::move(callback),
+        [this, requester, request_j = std::move(request_j)](CALLBACK_ &&callback, std::vector<uint64_t> &&ids)
+        {
+            try
+            {
+                Create_t entity_data = Create_t(request_j, ids.front());
+
+                T entity(entity_data);
+
+                // the ids may have arrived after the dispatching frame is gone, restore the client so the insert counts as its write
+                ReadRouter::Scope scope(requester);
+
+                Controller::Create(entity, std::move(callback));
+            }
+            catch (const std::exception &e)
+            {
+                CRITICALMESSAGERESPONSE
+            }
+        });
+}
+
 template <typename T>
 inline void __attribute((always_inline)) EntityController<T>::Read(CALLBACK_ &&callback, const Requester &&requester, std::string_view data)
 {
@@ -84,12 +155,6 @@ inline void __attribute((always_inline)) EntityController<T>::Read(CALLBACK_ &&c
         uint64_t       _id       = request_j.at("id").as<uint64_t>();
         HttpError      error;
 
-        if (!gateKeeper->canRead<T>(requester, _id, error))
-        {
-            std::move(callback)(error.code, error.message);
-            return;
-        }
-
         std::unordered_set<std::string> schema = request_j.at("schema").as<std::unordered_set<std::string>>();
 
         Validator::Rule rule(Validator::Rule::Action::ASSERT_NOT_PRESENT, {"id", "username", "password", "created_at", "updated_at"});
@@ -102,7 +167,44 @@ inline void __attribute((always_inline)) EntityController<T>::Read(CALLBACK_ &&c
 
         T entity((Read_t(schema, _id)));
 
-        Controller::Read(entity, std::move(callback));
+        if constexpr (Case_t<T>)
+        {
+            // a cached row is served after the plain permission check, the fused statement only pays off on a miss
+            if (fusedCaseRead && !Controller::isCached(entity))
+            {
+                // one round trip, the permission columns come with the row
+                Controller::ReadWithPermissions(
+                    entity,
+                    [this, requester](const jsoncons::json &permissions_j, HttpError &read_error)
+                    { return gateKeeper->canReadWithPermissions<T>(requester, permissions_j, read_error); },
+                    std::move(callback));
+                return;
+            }
+        }
+
+        gateKeeper->canRead<T>(requester, _id,
+            [this, callback = std::move(callback), requester, schema = std::move(schema), _id](bool allowed, const HttpError &error) mutable
+            {
+                try
+                {
+                    if (!allowed)
+                    {
+                        std::move(callback)(error.code, error.message);
+                        return;
+                    }
+
+                    T entity((Read_t(schema, _id)));
+
+                    // the permissions may have arrived after the dispatching frame is gone, restore the client for the read
+                    ReadRouter::Scope scope(requester);
+
+                    Controller::Read(entity, std::move(callback));
+                }
+                catch (const std::exception &e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception &e)
     {
@@ -141,17 +243,32 @@ inline void __attribute((always_inline)) EntityController<T>::Update(
             return;
         }
 
-        if (!gateKeeper->canUpdate<T>(requester, _id.value(), error))
-        {
-            std::move(callback)(error.code, error.message);
-            return;
-        }
-
-        Update_t entity_data = Update_t(request_json.value(), _id.value());
-
-        T entity(entity_data);
-
-        Controller::Update(entity, std::move(callback));
+        gateKeeper->canUpdate<T>(requester, _id.value(),
+            [this, callback = std::move(callback), requester, request_j = std::move(request_json.value()), id = _id.value()](
+                bool allowed, const HttpError &error) mutable
+            {
+                try
+                {
+                    if (!allowed)
+                    {
+                        std::move(callback)(error.code, error.message);
+                        return;
+                    }
+
+                    Update_t entity_data = Update_t(request_j, id);
+
+                    T entity(entity_data);
+
+                    // the permissions may have arrived after the dispatching frame is gone, restore the client so the update counts as its write
+                    ReadRouter::Scope scope(requester);
+
+                    Controller::Update(entity, std::move(callback));
+                }
+                catch (const std::exception &e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception &e)
     {
@@ -170,17 +287,29 @@ inline void __attribute((always_inline)) EntityController<T>::Delete(CALLBACK_ &
             return;
         }
 
-        HttpError error;
-
-        if (!gateKeeper->canDelete<T>(requester, _id.value(), error))
-        {
-            std::move(callback)(error.code, error.message);
-            return;
-        }
-
-        T entity(Delete_t(_id.value()));
-
-        Controller::Delete(entity, std::move(callback));
+        gateKeeper->canDelete<T>(requester, _id.value(),
+            [this, callback = std::move(callback), requester, id = _id.value()](bool allowed, const HttpError &error) mutable
+            {
+                try
+                {
+                    if (!allowed)
+                    {
+                        std::move(callback)(error.code, error.message);
+                        return;
+                    }
+
+                    T entity((Delete_t(id)));
+
+                    // the permissions may have arrived after the dispatching frame is gone, restore the client so the delete counts as its write
+                    ReadRouter::Scope scope(requester);
+
+                    Controller::Delete(entity, std::move(callback));
+                }
+                catch (const std::exception &e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception &e)
     {
@@ -195,11 +324,31 @@ inline void __attribute((always_inline)) EntityController<T>::Search(CALLBACK_ &
     try
     {
         request_json = jsoncons::json::parse(data);
-        bool success = false;
-        T    entity((Search_t(request_json, success)));
+        bool                 success = false;
+        api::v2::Http::Error search_error{};
+        Search_t             searchdata(request_json, search_error, success);
+
+        if (!success && search_error.code != 0)
+        {
+            std::move(callback)(search_error.code, search_error.message);
+            return;
+        }
+
+        if (success && searchdata.where.has_value())
+        {
+            std::string                           error;
+            std::optional<SearchFilter::Compiled> compiled = SearchFilter(searchdata.where.value(), T::getTableName()).compile(error);
+            if (!compiled.has_value())
+            {
+                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, error);
+                return;
+            }
+            searchdata.compiled = std::make_shared<const SearchFilter::Compiled>(std::move(compiled.value()));
+        }
 
         if (success)
         {
+            T entity(searchdata);
             Controller::Search(entity, std::move(callback));
         }
         else
@@ -213,6 +362,203 @@ inline void __attribute((always_inline)) EntityController<T>::Search(CALLBACK_ &
     }
 }
 
+template <typename T>
+void EntityController<T>::Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType)
+{
+    // the rows are copied in chunks, each committed on its own by the import worker, which runs outside the request lease
+    if (RequestLease::inTransaction())
+    {
+        std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Import commits per chunk and cannot run inside a request transaction.");
+        return;
+    }
+
+    // the task outlives the handler, so it owns a copy of the body rather than borrowing the request's
+    importQueue->runTaskInQueue(
+        [this, callback = std::move(callback), requester, body = std::string(data), contentType = std::string(contentType)]() mutable
+        { runImport(std::move(callback), requester, body, contentType); });
+}
+
+template <typename T>
+void EntityController<T>::runImport(CALLBACK_ &&callback, const Requester &requester, std::string_view data, std::string_view contentType)
+{
+    try
+    {
+        // the dispatching frame is gone, restore the client so the copies count as its writes
+        ReadRouter::Scope scope(requester);
+
+        std::optional<RowReader::Format> format = RowReader::formatOf(contentType);
+
+        if (!format.has_value())
+        {
+            std::move(callback)(api::v2::Http::Status::UNSUPPORTED_MEDIA_TYPE, "Import expects application/x-ndjson or text/csv.");
+            return;
+        }
+
+        std::shared_ptr<const SCHEMA_t> schema       = DatabaseSchema::getDatabaseSchema();
+        auto                            table_schema = schema->find(T::getTableName());
+
+        if (table_schema == schema->end())
+        {
+            std::move(callback)(api::v2::Http::Status::INTERNAL_SERVER_ERROR, fmt::format("No schema found for {}.", T::getTableName()));
+            return;
+        }
+
+        Validator::Rule rule((Validator::Rule::Action::IGNORE_IF_NOT_NULLABLE_IN_SCHEMA | Validator::Rule::Action::IGNORE_IF_MISSING_FROM_SCHEMA), {"id"});
+        RowReader       reader(data, format.value(), table_schema->second);
+        ImportReport    report;
+        ImportRows      chunk;
+
+        // rows of the same parent share one permission check, nullopt if it passed or the reason it failed
+        std::unordered_map<uint64_t, std::optional<std::string>> permissions;
+
+        chunk.reserve(importChunk);
+
+        jsoncons::json    row;
+        std::string       reason;
+        RowReader::Result result = RowReader::Result::END;
+
+        while ((result = reader.next(row, reason)) != RowReader::Result::END)
+        {
+            if (result == RowReader::Result::INVALID)
+            {
+                report.reject(reader.row(), reason);
+                continue;
+            }
+
+            HttpError error;
+            if (!Validator::validateDatabaseCreateSchema(T::getTableName(), row, error, rule))
+            {
+                report.reject(reader.row(), error.message);
+                continue;
+            }
+
+            if (!row.contains(T::getCreateKey()) || !row.at(T::getCreateKey()).is_uint64())
+            {
+                report.reject(reader.row(), fmt::format("Missing {}.", T::getCreateKey()));
+                continue;
+            }
+
+            auto [permission, unchecked] = permissions.try_emplace(row.at(T::getCreateKey()).as<uint64_t>());
+            if (unchecked && !gateKeeper->canCreate<T>(requester, row, error))
+            {
+                permission->second = error.message;
+            }
+
+            if (permission->second.has_value())
+            {
+                report.reject(reader.row(), permission->second.value());
+                continue;
+            }
+
+            chunk.emplace_back(reader.row(), std::move(row));
+
+            if (chunk.size() >= importChunk)
+            {
+                importRows(chunk, report);
+                chunk.clear();
+            }
+        }
+
+        importRows(chunk, report);
+
+        jsoncons::json response;
+        response["imported"] = report.imported;
+        response["failed"]   = report.failed;
+        response["errors"]   = std::move(report.errors);
+
+        std::move(callback)(api::v2::Http::Status::OK, response.to_string());
+    }
+    catch (const std::exception &e)
+    {
+        CRITICALMESSAGERESPONSE
+    }
+}
+
+template <typename T>
+void EntityController<T>::importRows(ImportRows &rows, ImportReport &report)
+{
+    if (rows.empty())
+    {
+        return;
+    }
+
+    HttpError                            error;
+    std::optional<std::vector<uint64_t>> ids = this->template getNextIDs<T>(rows.size(), error);
+
+    if (!ids.has_value())
+    {
+        for (const auto &row : rows)
+        {
+            report.reject(row.first, error.message);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        rows[i].second["id"] = ids->at(i);
+    }
+
+    copyImportRows(rows, 0, rows.size(), report);
+}
+
+template <typename T>
+void EntityController<T>::copyImportRows(const ImportRows &rows, size_t first, size_t last, ImportReport &report)
+{
+    // COPY takes one column list, rows leaving out different columns go into separate streams
+    std::map<std::string, CopyRows> groups;
+
+    for (size_t i = first; i < last; ++i)
+    {
+        std::vector<std::string>  columns;
+        PreparedStatement::Params values;
+
+        for (const auto &column : rows[i].second.object_range())
+        {
+            columns.push_back(column.key());
+            values.push_back(column.value().is_null() ? std::nullopt : std::optional<std::string>(column.value().as<std::string>()));
+        }
+
+        CopyRows &group = groups[fmt::format("{}", fmt::join(columns, ","))];
+        if (group.columns.empty())
+        {
+            group.table   = T::getTableName();
+            group.columns = std::move(columns);
+        }
+        group.rows.push_back(std::move(values));
+    }
+
+    std::vector<CopyRows> streams;
+    streams.reserve(groups.size());
+    for (auto &group : groups)
+    {
+        streams.push_back(std::move(group.second));
+    }
+
+    std::string           reason;
+    std::optional<size_t> copied = Controller::copyRows(streams, reason);
+
+    if (copied.has_value())
+    {
+        report.imported += copied.value();
+        return;
+    }
+
+    // an open request transaction is aborted by the failure, retrying parts of the range cannot succeed
+    if (last - first == 1 || RequestLease::inTransaction())
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            report.reject(rows[i].first, reason.empty() ? "Failed to load row." : reason);
+        }
+        return;
+    }
+
+    size_t middle = first + ((last - first) / 2);
+    copyImportRows(rows, first, middle, report);
+    copyImportRows(rows, middle, last, report);
+}
+
 #define INSTANTIATE_ENTITY_CONTROLLER(TYPE) /*NOLINT*/                                                                                                  \
     template void EntityController<TYPE>::Create(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                             \
     template void EntityController<TYPE>::Read(CALLBACK_ &&callback, const Requester &&requester, std::string_view data);                               \
@@ -241,3 +587,7 @@ INSTANTIATE_ENTITY_CONTROLLER(ClinicAppointment)
 INSTANTIATE_ENTITY_CONTROLLER(PharmacyAppointment)
 INSTANTIATE_ENTITY_CONTROLLER(LaboratoryAppointment)
 INSTANTIATE_ENTITY_CONTROLLER(RadiologyCenterAppointment)
+
+// bulk import is offered for the entities clinics bring over from other systems
+template void EntityController<Patient>::Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType);
+template void EntityController<Visits>::Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType);
@@ -1,13 +1,19 @@
 
 #pragma once
 #include <fmt/format.h>
+#include <trantor/utils/ConcurrentTaskQueue.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <jsoncons/json.hpp>
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
+#include "configurator/configurator.hpp"
 #include "controllers/base/controller/controller.hpp"
 #include "controllers/entitycontroller/entitycontrollerbase.hpp"
 #include "gatekeeper/gatekeeper.hpp"
@@ -20,7 +26,8 @@ template <typename T>
 class EntityController : public Controller, public EntityControllerBase
 {
    public:
-    EntityController()                                    = default;
+    // the first block of ids is reserved now, while the routes are set up, not on the first create
+    EntityController() { idAllocator->prepare(T::getTableName()); }
     EntityController(const EntityController &)            = default;
     EntityController(EntityController &&)                 = default;
     EntityController &operator=(const EntityController &) = default;
@@ -34,6 +41,51 @@ class EntityController : public Controller, public EntityControllerBase
     void Delete(CALLBACK_ &&callback, const Requester &&requester, std::optional<uint64_t> _id) override;
     void Search(CALLBACK_ &&callback, const Requester &&requester, std::string_view data) override;
 
+    // Loads NDJSON or CSV rows in chunks with COPY. Every row is validated and permission checked like a create,
+    // the answer reports how many rows were imported and why the others were not. The import runs on the import
+    // workers, not on the IO thread, and outside the request lease, so every chunk commits on its own and a request
+    // transaction is refused.
+    void Import(CALLBACK_ &&callback, const Requester &&requester, std::string_view data, std::string_view contentType);
+
    private:
-    std::shared_ptr<GateKeeper> gateKeeper = Store::getObject<GateKeeper>();
+    struct ImportReport
+    {
+        size_t                imported = 0;
+        size_t                failed   = 0;
+        jsoncons::json::array errors;
+
+        void reject(size_t row, const std::string &reason)
+        {
+            ++failed;
+            if (errors.size() < MAX_IMPORT_ERRORS)
+            {
+                jsoncons::json error;
+                error["row"]   = row;
+                error["error"] = reason;
+                errors.push_back(std::move(error));
+            }
+        }
+    };
+
+    using ImportRows = std::vector<std::pair<size_t, jsoncons::json>>;  // row number, row
+
+    std::shared_ptr<GateKeeper> gateKeeper    = Store::getObject<GateKeeper>();
+    bool                        fusedCaseRead = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().fused_case_read;
+    size_t                      importChunk   = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().import_chunk;
+
+    std::shared_ptr<trantor::ConcurrentTaskQueue> importQueue = Store::getObject<trantor::ConcurrentTaskQueue>(IMPORT_WORKERS, "import");
+
+    // cases read their create permissions without blocking the loop and create once they passed
+    void createAfterPermissionCheck(CALLBACK_ &&callback, const Requester &requester, jsoncons::json &&request_j);
+    // takes an id from IdAllocator and inserts request_j with it
+    void createWithNextID(CALLBACK_ &&callback, const Requester &requester, jsoncons::json &&request_j);
+
+    void runImport(CALLBACK_ &&callback, const Requester &requester, std::string_view data, std::string_view contentType);
+    // gives the rows their ids and copies them
+    void importRows(ImportRows &rows, ImportReport &report);
+    // copies rows [first, last) in one transaction, a rejected range is split until the offending rows are found
+    void copyImportRows(const ImportRows &rows, size_t first, size_t last, ImportReport &report);
+
+    static constexpr size_t MAX_IMPORT_ERRORS = 1000;  // errors listed in an import report, the rest are only counted
+    static constexpr size_t IMPORT_WORKERS    = 2;     // imports running at once, later ones queue
 };
@@ -61,19 +61,30 @@ void StaffController<T>::RemoveStaffFromEntity(CALLBACK_&& callback, const Reque
 {
     try
     {
-        HttpError      error;
         jsoncons::json staff_j = jsoncons::json::parse(data);
         jsoncons::json payload = staff_j.at("payload");
         uint64_t       _id     = staff_j.at("id").as<uint64_t>();
-        StaffData      staffData(payload);
 
-        T staff(staffData);
-        if (!gateKeeper->canManageStaff<T>(requester, _id, error))
-        {
-            std::move(callback)(error.code, error.message);
-            return;
-        }
-        Controller::removeStaff(staff, std::move(callback));
+        gateKeeper->canManageStaff<T>(requester, _id,
+            [this, callback = std::move(callback), payload = std::move(payload)](bool allowed, const HttpError& error) mutable
+            {
+                try
+                {
+                    if (!allowed)
+                    {
+                        std::move(callback)(error.code, error.message);
+                        return;
+                    }
+
+                    StaffData staffData(payload);
+                    T         staff(staffData);
+                    Controller::removeStaff(staff, std::move(callback));
+                }
+                catch (const std::exception& e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception& e)
     {
@@ -85,37 +96,47 @@ void StaffController<T>::InviteStaffToEntity(CALLBACK_&& callback, const Request
 {
     try
     {
-        HttpError                  error;
-        jsoncons::json             staff_j = jsoncons::json::parse(data);
-        uint64_t                   _id     = staff_j.at("nominee_id").as<uint64_t>();
-        StaffData                  staffData(staff_j);
-        std::optional<std::string> response;
-        T                          staff(staffData);
-
-        if (!gateKeeper->canManageStaff<T>(requester, _id, error))
-        {
-            std::move(callback)(error.code, error.message);
-            return;
-        }
-
-        if (staffData.parse_status && staffData.toInviteJson(staff_j))
-        {
-            response = Communicate::sendRequest(email_sender_daemon_config_.host, email_sender_daemon_config_.port,
-                email_sender_daemon_config_.message_queue_path, drogon::HttpMethod::Post, staff_j.to_string());
-
-            if (response.has_value())
-            {
-                std::move(callback)(api::v2::Http::Status::OK, response.value());
-            }
-            else
+        jsoncons::json staff_j = jsoncons::json::parse(data);
+        uint64_t       _id     = staff_j.at("nominee_id").as<uint64_t>();
+
+        gateKeeper->canManageStaff<T>(requester, _id,
+            [this, callback = std::move(callback), staff_j = std::move(staff_j)](bool allowed, const HttpError& error) mutable
             {
-                std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to send invite.");
-            }
-        }
-        else
-        {
-            std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to create invite json.");
-        }
+                try
+                {
+                    if (!allowed)
+                    {
+                        std::move(callback)(error.code, error.message);
+                        return;
+                    }
+
+                    StaffData                  staffData(staff_j);
+                    std::optional<std::string> response;
+
+                    if (staffData.parse_status && staffData.toInviteJson(staff_j))
+                    {
+                        response = Communicate::sendRequest(email_sender_daemon_config_.host, email_sender_daemon_config_.port,
+                            email_sender_daemon_config_.message_queue_path, drogon::HttpMethod::Post, staff_j.to_string());
+
+                        if (response.has_value())
+                        {
+                            std::move(callback)(api::v2::Http::Status::OK, response.value());
+                        }
+                        else
+                        {
+                            std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to send invite.");
+                        }
+                    }
+                    else
+                    {
+                        std::move(callback)(api::v2::Http::Status::BAD_REQUEST, "Failed to create invite json.");
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    CRITICALMESSAGERESPONSE
+                }
+            });
     }
     catch (const std::exception& e)
     {
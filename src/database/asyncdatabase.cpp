@@ -0,0 +1,577 @@
+#include "database/asyncdatabase.hpp"
+
+#include <fmt/core.h>
+#include <libpq-fe.h>
+#include <trantor/net/Channel.h>
+#include <trantor/net/EventLoop.h>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "configurator/configurator.hpp"
+#include "store/store.hpp"
+#include "utils/message/message.hpp"
+
+AsyncDatabase::AsyncDatabase(trantor::EventLoop *loop, std::string host, std::string connection_info)
+    : loop_(loop), host_(std::move(host)), connection_info_(std::move(connection_info))
+{
+}
+
+AsyncDatabase::~AsyncDatabase()
+{
+    if (connecting_ && loop_->isInLoopThread())
+    {
+        loop_->invalidateTimer(connectTimer_);
+    }
+
+    if (channel_ != nullptr && loop_->isInLoopThread())
+    {
+        channel_->disableAll();
+        channel_->remove();
+    }
+    channel_.reset();
+
+    if (connection_ != nullptr)
+    {
+        PQfinish(connection_);
+    }
+}
+
+std::shared_ptr<AsyncDatabase> AsyncDatabase::forCurrentLoop()
+{
+    static const std::string primary = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().host;
+
+    return forCurrentLoop(primary);
+}
+
+std::shared_ptr<AsyncDatabase> AsyncDatabase::forCurrentLoop(const std::string &host)
+{
+    trantor::EventLoop *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+
+    if (loop == nullptr)
+    {
+        return nullptr;
+    }
+
+    thread_local std::unordered_map<std::string, std::shared_ptr<AsyncDatabase>> instances;
+
+    std::shared_ptr<AsyncDatabase> &instance = instances[host];
+
+    if (instance == nullptr)
+    {
+        const Configurator::DatabaseConfig &config = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>();
+
+        instance = std::make_shared<AsyncDatabase>(loop, host,
+            fmt::format("host={} dbname={} user={} password={} connect_timeout={}", host, config.name, config.user, config.pass, TIMEOUT));
+    }
+
+    return instance;
+}
+
+void AsyncDatabase::execute(const std::string &query, QueryCallback &&callback)
+{
+    loop_->assertInLoopThread();
+
+    if (connection_ == nullptr && !connect())
+    {
+        callback(nullptr);
+        return;
+    }
+
+    queue_.push_back(Task{.query = query, .callback = std::move(callback)});
+
+    sendNext();
+}
+
+void AsyncDatabase::executePrepared(const PreparedStatement &statement, QueryCallback &&callback)
+{
+    loop_->assertInLoopThread();
+
+    if (connection_ == nullptr && !connect())
+    {
+        callback(nullptr);
+        return;
+    }
+
+    queue_.push_back(Task{.query = statement.sql, .callback = std::move(callback), .statement = statement});
+
+    sendNext();
+}
+
+void AsyncDatabase::executeBatch(std::vector<PreparedStatement> &&statements, BatchCallback &&callback)
+{
+    loop_->assertInLoopThread();
+
+    if (statements.empty())
+    {
+        callback(std::vector<ResultPtr>{}, "");
+        return;
+    }
+
+    if (connection_ == nullptr && !connect())
+    {
+        callback(std::nullopt, "");
+        return;
+    }
+
+    queue_.push_back(Task{.query = statements.front().sql, .callback = nullptr, .batch = std::move(statements), .batchCallback = std::move(callback)});
+
+    sendNext();
+}
+
+bool AsyncDatabase::connect()
+{
+    // the handshake is driven by the socket events, the loop never waits for it
+    connection_ = PQconnectStart(connection_info_.c_str());
+
+    if (connection_ == nullptr || PQstatus(connection_) == CONNECTION_BAD || PQsetnonblocking(connection_, 1) != 0)
+    {
+        Message::CriticalMessage(
+            fmt::format("Failed to open async database connection: {}", connection_ != nullptr ? PQerrorMessage(connection_) : "out of memory"));
+        PQfinish(connection_);
+        connection_ = nullptr;
+        return false;
+    }
+
+    connecting_ = true;
+    watch(PQsocket(connection_));
+
+    // PQconnectPoll does not honor connect_timeout, the attempt is abandoned here instead
+    loop_->invalidateTimer(connectTimer_);
+    connectTimer_ = loop_->runAfter(static_cast<double>(TIMEOUT),
+        [this]()
+        {
+            if (connecting_)
+            {
+                fail("timed out connecting");
+            }
+        });
+
+    // libpq expects the first poll once the socket is writable
+    channel_->enableWriting();
+    return true;
+}
+
+void AsyncDatabase::watch(int socket)
+{
+    if (channel_ != nullptr && channel_->fd() == socket)
+    {
+        return;
+    }
+
+    // libpq may open another socket while connecting, e.g. when it tries the next address of the host
+    releaseChannel();
+
+    channel_ = std::make_unique<trantor::Channel>(loop_, socket);
+    channel_->setReadCallback([this]() { connecting_ ? poll() : handleRead(); });
+    channel_->setWriteCallback([this]() { connecting_ ? poll() : handleWrite(); });
+}
+
+void AsyncDatabase::poll()
+{
+    PostgresPollingStatusType status = PQconnectPoll(connection_);
+
+    if (status == PGRES_POLLING_FAILED)
+    {
+        fail(PQerrorMessage(connection_));
+        return;
+    }
+
+    watch(PQsocket(connection_));
+
+    if (status == PGRES_POLLING_READING)
+    {
+        channel_->disableWriting();
+        channel_->enableReading();
+        return;
+    }
+
+    if (status == PGRES_POLLING_WRITING)
+    {
+        channel_->disableReading();
+        channel_->enableWriting();
+        return;
+    }
+
+    // PGRES_POLLING_OK
+    connecting_ = false;
+    loop_->invalidateTimer(connectTimer_);
+    channel_->disableWriting();
+    channel_->enableReading();
+
+    Message::InfoMessage(
+        fmt::format("Async database connection {} is bound to event loop {}.", static_cast<const void *>(this), static_cast<const void *>(loop_)));
+    sendNext();
+}
+
+void AsyncDatabase::releaseChannel()
+{
+    if (channel_ == nullptr)
+    {
+        return;
+    }
+
+    if (loop_->isInLoopThread())
+    {
+        channel_->disableAll();
+        channel_->remove();
+    }
+    // the channel may be the one dispatching the current event, destroy it once the loop is done with it
+    trantor::Channel *channel = channel_.release();
+    loop_->queueInLoop([channel]() { delete channel; }); /*NOLINT*/
+}
+
+void AsyncDatabase::disconnect()
+{
+    releaseChannel();
+    loop_->invalidateTimer(connectTimer_);
+    connecting_ = false;
+
+    if (connection_ != nullptr)
+    {
+        PQfinish(connection_);
+        connection_ = nullptr;
+    }
+    busy_ = false;
+    result_.reset();
+    prepared_.clear();
+    steps_.clear();
+    batchResults_.clear();
+    batchState_.clear();
+}
+
+void AsyncDatabase::sendNext()
+{
+    // a callback run by finish may already have sent the next task, and nothing is sent before the connection is up
+    if (busy_ || connecting_ || connection_ == nullptr || queue_.empty())
+    {
+        return;
+    }
+
+    busy_ = true;
+
+    if (queue_.front().batch.empty())
+    {
+        send(queue_.front());
+    }
+    else
+    {
+        sendBatch(queue_.front());
+    }
+}
+
+void AsyncDatabase::send(Task &task)
+{
+    int sent = 0;
+
+    if (!task.statement.has_value())
+    {
+        sent = PQsendQuery(connection_, task.query.c_str());
+    }
+    else if (!prepared_.contains(task.statement->name))
+    {
+        task.preparing = true;
+        sent           = PQsendPrepare(connection_, task.statement->name.c_str(), task.statement->sql.c_str(), 0, nullptr);
+    }
+    else
+    {
+        std::vector<const char *> values;
+        values.reserve(task.statement->params.size());
+        for (const auto &param : task.statement->params)
+        {
+            values.push_back(param.has_value() ? param->c_str() : nullptr);
+        }
+
+        sent = PQsendQueryPrepared(
+            connection_, task.statement->name.c_str(), static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0);
+    }
+
+    if (sent == 0)
+    {
+        fail(PQerrorMessage(connection_));
+        return;
+    }
+
+    flush();
+}
+
+void AsyncDatabase::sendBatch(Task &task)
+{
+    if (PQenterPipelineMode(connection_) == 0)
+    {
+        fail(PQerrorMessage(connection_));
+        return;
+    }
+
+    steps_.clear();
+    step_        = 0;
+    batchFailed_ = false;
+    batchState_.clear();
+    batchResults_.assign(task.batch.size(), nullptr);
+
+    // a statement may appear more than once in a batch, it is prepared only for its first occurrence
+    std::unordered_set<std::string> preparing;
+
+    for (std::size_t index = 0; index < task.batch.size(); ++index)
+    {
+        const PreparedStatement &statement = task.batch[index];
+
+        if (!prepared_.contains(statement.name) && preparing.insert(statement.name).second)
+        {
+            if (PQsendPrepare(connection_, statement.name.c_str(), statement.sql.c_str(), 0, nullptr) == 0)
+            {
+                fail(PQerrorMessage(connection_));
+                return;
+            }
+            steps_.push_back(Step{.statement = index, .prepare = true});
+        }
+
+        std::vector<const char *> values;
+        values.reserve(statement.params.size());
+        for (const auto &param : statement.params)
+        {
+            values.push_back(param.has_value() ? param->c_str() : nullptr);
+        }
+
+        if (PQsendQueryPrepared(connection_, statement.name.c_str(), static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0) == 0)
+        {
+            fail(PQerrorMessage(connection_));
+            return;
+        }
+        steps_.push_back(Step{.statement = index, .prepare = false});
+    }
+
+    if (PQpipelineSync(connection_) == 0)
+    {
+        fail(PQerrorMessage(connection_));
+        return;
+    }
+
+    flush();
+}
+
+void AsyncDatabase::flush()
+{
+    int status = PQflush(connection_);
+
+    if (status == 1)
+    {
+        // output buffer is not drained yet, wait for the socket to become writable
+        if (!channel_->isWriting())
+        {
+            channel_->enableWriting();
+        }
+        return;
+    }
+
+    if (channel_->isWriting())
+    {
+        channel_->disableWriting();
+    }
+
+    if (status == -1)
+    {
+        fail(PQerrorMessage(connection_));
+    }
+}
+
+void AsyncDatabase::handleWrite() { flush(); }
+
+void AsyncDatabase::handleRead()
+{
+    if (PQconsumeInput(connection_) == 0)
+    {
+        fail(PQerrorMessage(connection_));
+        return;
+    }
+
+    while (busy_ && PQisBusy(connection_) == 0)
+    {
+        PGresult *result = PQgetResult(connection_);
+
+        if (!queue_.front().batch.empty())
+        {
+            collect(result);
+            continue;
+        }
+
+        if (result == nullptr)
+        {
+            // all results of the current query are consumed
+            finish(std::move(result_));
+            continue;
+        }
+
+        // keep only the last result, as the pqxx based path does
+        result_ = ResultPtr(result, PQclear);
+    }
+}
+
+void AsyncDatabase::finish(ResultPtr &&result)
+{
+    Task &front = queue_.front();
+
+    if (front.preparing)
+    {
+        front.preparing = false;
+
+        if (result != nullptr && PQresultStatus(result.get()) == PGRES_COMMAND_OK)
+        {
+            // statement is now known to this connection, run it
+            prepared_.insert(front.statement->name);
+            send(front);
+            return;
+        }
+    }
+
+    Task task = std::move(front);
+    queue_.pop_front();
+    busy_ = false;
+
+    if (result != nullptr)
+    {
+        ExecStatusType status = PQresultStatus(result.get());
+        if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK)
+        {
+            Message::ErrorMessage("Error executing query:");
+            Message::InfoMessage(task.query);
+            Message::CriticalMessage(PQresultErrorMessage(result.get()));
+            result.reset();
+        }
+    }
+
+    try
+    {
+        task.callback(std::move(result));
+    }
+    catch (const std::exception &e)
+    {
+        Message::CriticalMessage(fmt::format("Exception caught in async query callback: {}", e.what()));
+    }
+
+    sendNext();
+}
+
+void AsyncDatabase::collect(PGresult *result)
+{
+    if (result == nullptr)
+    {
+        // all results of the current command are consumed
+        if (step_ < steps_.size())
+        {
+            finishStep(steps_[step_++], std::move(result_));
+        }
+        result_.reset();
+        return;
+    }
+
+    if (PQresultStatus(result) == PGRES_PIPELINE_SYNC)
+    {
+        PQclear(result);
+        finishBatch();
+        return;
+    }
+
+    result_ = ResultPtr(result, PQclear);
+}
+
+void AsyncDatabase::finishStep(const Step &step, ResultPtr &&result)
+{
+    const PreparedStatement &statement = queue_.front().batch[step.statement];
+    ExecStatusType           status    = result != nullptr ? PQresultStatus(result.get()) : PGRES_FATAL_ERROR;
+
+    if (status == PGRES_PIPELINE_ABORTED)
+    {
+        // an earlier command of the batch failed and is already reported
+        batchFailed_ = true;
+        return;
+    }
+
+    if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK)
+    {
+        batchFailed_ = true;
+        if (result != nullptr && PQresultErrorField(result.get(), PG_DIAG_SQLSTATE) != nullptr)
+        {
+            batchState_ = PQresultErrorField(result.get(), PG_DIAG_SQLSTATE);
+        }
+        Message::ErrorMessage(step.prepare ? "Error preparing pipelined statement:" : "Error executing pipelined statement:");
+        Message::InfoMessage(statement.sql);
+        Message::CriticalMessage(result != nullptr ? PQresultErrorMessage(result.get()) : PQerrorMessage(connection_));
+        return;
+    }
+
+    if (step.prepare)
+    {
+        prepared_.insert(statement.name);
+        return;
+    }
+
+    batchResults_[step.statement] = std::move(result);
+}
+
+void AsyncDatabase::finishBatch()
+{
+    if (PQexitPipelineMode(connection_) == 0)
+    {
+        Message::WarningMessage(fmt::format("Failed to leave pipeline mode: {}", PQerrorMessage(connection_)));
+    }
+
+    Task task = std::move(queue_.front());
+    queue_.pop_front();
+    busy_ = false;
+
+    // an explicit transaction the batch opened stays open, and failed, when a statement inside it failed
+    if (PQtransactionStatus(connection_) != PQTRANS_IDLE)
+    {
+        queue_.push_front(Task{.query = "ROLLBACK;", .callback = [](ResultPtr &&) {}});
+    }
+
+    std::optional<std::vector<ResultPtr>> results;
+    if (!batchFailed_)
+    {
+        results = std::move(batchResults_);
+    }
+    std::string state = std::move(batchState_);
+    steps_.clear();
+    batchResults_.clear();
+    batchState_.clear();
+
+    try
+    {
+        task.batchCallback(std::move(results), state);
+    }
+    catch (const std::exception &e)
+    {
+        Message::CriticalMessage(fmt::format("Exception caught in async batch callback: {}", e.what()));
+    }
+
+    sendNext();
+}
+
+void AsyncDatabase::fail(const std::string &reason)
+{
+    Message::CriticalMessage(fmt::format("Async database connection {} failed: {}", static_cast<const void *>(this), reason));
+
+    std::deque<Task> pending = std::move(queue_);
+    queue_.clear();
+
+    // drop the broken link, it is re-established on the next execute
+    disconnect();
+
+    for (auto &task : pending)
+    {
+        if (task.batchCallback)
+        {
+            task.batchCallback(std::nullopt, "");
+            continue;
+        }
+        task.callback(nullptr);
+    }
+}
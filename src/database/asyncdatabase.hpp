@@ -0,0 +1,115 @@
+#pragma once
+
+#include <libpq-fe.h>
+#include <trantor/net/Channel.h>
+#include <trantor/net/EventLoop.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+
+/// Non-blocking libpq connection bound to a single trantor event loop.
+/// The connection is opened with PQconnectStart and its handshake is driven by
+/// the socket events, queries queued meanwhile are sent once it completes.
+/// Queries are sent with PQsendQuery and their results are collected when the
+/// socket becomes readable, so the owning IO thread never waits on Postgres.
+/// A batch of prepared statements is sent in libpq pipeline mode, so the whole
+/// group costs a single network round trip.
+/// All methods must be called from the owning loop thread.
+class AsyncDatabase
+{
+   public:
+    using ResultPtr     = std::shared_ptr<PGresult>;
+    using QueryCallback = std::function<void(ResultPtr &&)>;
+    // sqlstate is the SQLSTATE of the statement that failed, empty if none did or the connection failed
+    using BatchCallback = std::function<void(std::optional<std::vector<ResultPtr>> &&, const std::string &sqlstate)>;
+
+    AsyncDatabase(trantor::EventLoop *loop, std::string host, std::string connection_info);
+    AsyncDatabase(const AsyncDatabase &)            = delete;
+    AsyncDatabase(AsyncDatabase &&)                 = delete;
+    AsyncDatabase &operator=(const AsyncDatabase &) = delete;
+    AsyncDatabase &operator=(AsyncDatabase &&)      = delete;
+    virtual ~AsyncDatabase();
+
+    // callback receives nullptr on failure
+    void execute(const std::string &query, QueryCallback &&callback);
+    // prepares the statement on first use on this connection, then executes it with its bind parameters
+    void executePrepared(const PreparedStatement &statement, QueryCallback &&callback);
+    // pipelines the statements and hands over one result per statement, nullopt if any of them failed.
+    // A transaction the batch opened and left failed is rolled back before the next task is sent.
+    void executeBatch(std::vector<PreparedStatement> &&statements, BatchCallback &&callback);
+
+    // returns the connection of the calling IO thread, nullptr if not called from an event loop
+    static std::shared_ptr<AsyncDatabase> forCurrentLoop();
+    // same, to the given host, e.g. a read replica
+    static std::shared_ptr<AsyncDatabase> forCurrentLoop(const std::string &host);
+
+    [[nodiscard]] const std::string &host() const { return host_; }
+
+   private:
+    struct Task
+    {
+        std::string                      query;
+        QueryCallback                    callback;
+        std::optional<PreparedStatement> statement = std::nullopt;
+        bool                             preparing = false;
+        std::vector<PreparedStatement>   batch     = {};
+        BatchCallback                    batchCallback;
+    };
+
+    // one command of a pipelined batch, either the preparation or the execution of a statement
+    struct Step
+    {
+        std::size_t statement;
+        bool        prepare;
+    };
+
+    // starts a non-blocking connect, the queue is sent once poll sees it complete
+    bool connect();
+    void poll();
+    // (re)binds the channel to the socket libpq currently uses
+    void watch(int socket);
+    void releaseChannel();
+    void disconnect();
+    void sendNext();
+    void send(Task &task);
+    void sendBatch(Task &task);
+    void flush();
+    void handleRead();
+    void handleWrite();
+    void finish(ResultPtr &&result);
+    void collect(PGresult *result);
+    void finishStep(const Step &step, ResultPtr &&result);
+    void finishBatch();
+    void fail(const std::string &reason);
+
+    trantor::EventLoop               *loop_;
+    std::string                       host_;
+    std::string                       connection_info_;
+    PGconn                           *connection_ = nullptr;
+    std::unique_ptr<trantor::Channel> channel_;
+    std::deque<Task>                  queue_;
+    std::unordered_set<std::string>   prepared_;
+    ResultPtr                         result_;
+    bool                              busy_       = false;
+    bool                              connecting_ = false;
+    trantor::TimerId                  connectTimer_{};
+
+    // state of the batch in flight
+    std::vector<Step>      steps_;
+    std::size_t            step_ = 0;
+    std::vector<ResultPtr> batchResults_;
+    bool                   batchFailed_ = false;
+    std::string            batchState_;
+
+    static constexpr std::uint16_t TIMEOUT = 2;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+
+/// Rows loaded into a table in one COPY stream, every row carrying the values of columns in that order.
+struct CopyRows
+{
+    std::string                            table;
+    std::vector<std::string>               columns;
+    std::vector<PreparedStatement::Params> rows;
+};
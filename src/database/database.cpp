@@ -1,8 +1,11 @@
 #include "database.hpp"
 
 #include <fmt/core.h>
+#include <fmt/ranges.h>
 #include <trantor/utils/Logger.h>
 
+#include <chrono>
+#include <cstddef>
 #include <cstdlib>
 #include <exception>
 #include <jsoncons/basic_json.hpp>
@@ -11,11 +14,13 @@
 #include <optional>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "controllers/staffcontroller/staffcontroller.hpp"
-#include "database/inuseguard.hpp"  // IWYU pragma: keep
+#include "database/resultdecoder.hpp"
 #include "utils/global/types.hpp"
 #include "utils/message/message.hpp"
 
@@ -51,14 +56,8 @@ bool Database::checkExists(const std::string &table, const std::string &column,
             return false;
         }
 
-        pqxx::result result;
-        {
-            IUGUARD
-
-            pqxx::nontransaction txn(*connection);
+        pqxx::result result = run<pqxx::nontransaction>([&](pqxx::transaction_base &txn) { return txn.exec(query); });
 
-            result = txn.exec(query);
-        }
         return result[0][0].as<bool>();
     }
     catch (const std::exception &e)
@@ -76,7 +75,6 @@ bool Database::check_connection()
     }
     try
     {
-        IUGUARD
         pqxx::nontransaction ntxn(*connection);
         ntxn.exec("SELECT 1");
     }
@@ -91,10 +89,9 @@ bool Database::reconnect()
 {
     try
     {
-        {
-            IUGUARD
-            connection = std::make_shared<pqxx::connection>(connection_info);
-        }
+        requestTxn_.reset();
+        connection = std::make_shared<pqxx::connection>(connection_info);
+        prepared_.clear();
         return check_connection();
     }
     catch (const std::exception &e)
@@ -104,62 +101,120 @@ bool Database::reconnect()
     }
 }
 
-std::optional<std::unordered_set<api::v2::ColumnInfo>> Database::getTableSchema(const std::string &tableName)
+bool Database::listen(const std::string &channel)
 {
     try
     {
-        pqxx::result result;
+        pqxx::nontransaction ntxn(*connection);
+        ntxn.exec(fmt::format("LISTEN {};", connection->quote_name(channel)));
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        Message::CriticalMessage(fmt::format("Failed to listen on {}: {}", channel, e.what()));
+        return false;
+    }
+}
 
-        {
-            IUGUARD
-            pqxx::nontransaction ntxn(*connection);
-            std::string          query = fmt::format(
-                "SELECT column_name, data_type, column_default, is_nullable FROM "
-                         "information_schema.columns WHERE table_name = '{}' AND column_name != 'id';",
-                tableName);
+std::optional<size_t> Database::awaitNotifications(std::chrono::microseconds timeout)
+{
+    try
+    {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        return static_cast<size_t>(connection->await_notification(seconds.count(), static_cast<long>((timeout - seconds).count())));
+    }
+    catch (const std::exception &e)
+    {
+        Message::CriticalMessage(fmt::format("Failed to wait for notifications: {}", e.what()));
+        return std::nullopt;
+    }
+}
 
-            result = ntxn.exec(query);
-        }
+bool Database::beginRequestTransaction()
+{
+    try
+    {
+        requestTxn_ = std::make_unique<pqxx::work>(*connection);
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        Message::CriticalMessage(fmt::format("Failed to begin request transaction: {}", e.what()));
+        return false;
+    }
+}
 
-        std::unordered_set<api::v2::ColumnInfo> schema;
+bool Database::endRequestTransaction(bool commit)
+{
+    if (requestTxn_ == nullptr)
+    {
+        return true;
+    }
 
-        for (const auto &row : result)
+    std::unique_ptr<pqxx::work> txn = std::move(requestTxn_);
+
+    try
+    {
+        if (commit)
         {
-            api::v2::ColumnInfo column;
-            column.Name       = row["column_name"].as<std::string>();
-            column.DataType   = row["data_type"].as<std::string>();
-            column.Constraint = row["column_default"].is_null() ? "None" : row["column_default"].as<std::string>();
-            column.isNullable = row["is_nullable"].as<std::string>() == "YES";
-            schema.insert(column);
+            txn->commit();
+            return true;
         }
-        return schema;
+        txn->abort();
+        return true;
     }
     catch (const std::exception &e)
     {
-        Message::CriticalMessage(fmt::format("Error executing query: {}", e.what()));
-        return std::nullopt;
+        Message::CriticalMessage(fmt::format("Failed to {} request transaction: {}", commit ? "commit" : "roll back", e.what()));
     }
+    return false;
+}
+
+std::string Database::host() const
+{
+    const char *hostname = connection != nullptr ? connection->hostname() : nullptr;
+    return hostname != nullptr ? hostname : "";
 }
 
-std::optional<std::unordered_set<std::string>> Database::getAllTables()
+std::optional<std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>> Database::getSchema()
 {
     try
     {
         pqxx::result result;
 
         {
-            IUGUARD
-            pqxx::work txn(*connection);
-            result = txn.exec("SELECT table_name FROM information_schema.tables WHERE table_schema = 'public';");
+            // every column of every table and view in one catalog read, data_type is spelled the way
+            // information_schema.columns spells it
+            pqxx::nontransaction ntxn(*connection);
+            result = ntxn.exec(
+                "SELECT c.relname AS table_name, a.attname AS column_name, "
+                "CASE WHEN t.typelem <> 0 AND t.typlen = -1 THEN 'ARRAY' "
+                "WHEN t.typtype = 'd' THEN format_type(t.typbasetype, NULL) "
+                "WHEN t.typnamespace = 'pg_catalog'::regnamespace THEN format_type(a.atttypid, NULL) "
+                "ELSE 'USER-DEFINED' END AS data_type, "
+                "pg_get_expr(d.adbin, d.adrelid) AS column_default, NOT a.attnotnull AS is_nullable "
+                "FROM pg_class c "
+                "JOIN pg_namespace n ON n.oid = c.relnamespace "
+                "JOIN pg_attribute a ON a.attrelid = c.oid AND a.attnum > 0 AND NOT a.attisdropped "
+                "JOIN pg_type t ON t.oid = a.atttypid "
+                "LEFT JOIN pg_attrdef d ON d.adrelid = c.oid AND d.adnum = a.attnum "
+                "WHERE n.nspname = 'public' AND c.relkind IN ('r', 'p', 'v', 'f');");
         }
 
-        std::unordered_set<std::string> tables;
+        std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>> schema;
 
         for (const auto &row : result)
         {
-            tables.insert(row["table_name"].as<std::string>());
+            std::unordered_set<api::v2::ColumnInfo> &columns = schema[row["table_name"].as<std::string>()];
+
+            api::v2::ColumnInfo column;
+            column.Name       = row["column_name"].as<std::string>();
+            column.DataType   = row["data_type"].as<std::string>();
+            column.Constraint = row["column_default"].is_null() ? "None" : row["column_default"].as<std::string>();
+            column.isNullable = row["is_nullable"].as<bool>();
+            columns.insert(column);
         }
-        return tables;
+        return schema;
     }
     catch (const std::exception &e)
     {
@@ -182,84 +237,135 @@ std::optional<jsonType> Database::executeQuery(const std::string &query, bool &i
             return std::nullopt;
         }
 
-        pqxx::result results;
+        pqxx::result results = run<TransactionType>([&](pqxx::transaction_base &txn) { return txn.exec(query); });
 
+        return ResultDecoder(std::move(results)).to<jsonType>();
+    }
+    catch (const std::exception &e)
+    {
+        Message::ErrorMessage("Error executing query:");
+        Message::InfoMessage(query);
+        Message::CriticalMessage(e.what());
+        return std::nullopt;
+        // throw;  // Rethrow the exception to indicate failure
+    }
+    return std::nullopt;
+}
+
+template <typename jsonType, typename TransactionType>
+std::optional<jsonType> Database::executePrepared(const PreparedStatement &statement)
+{
+    try
+    {
+        if (!prepared_.contains(statement.name))
         {
-            IUGUARD
+            connection->prepare(statement.name, statement.sql);
+            prepared_.insert(statement.name);
+        }
 
-            TransactionType txn(*connection);
+        pqxx::params params;
+        for (const auto &param : statement.params)
+        {
+            params.append(param);
+        }
 
-            results = txn.exec(query);
+        pqxx::result results = run<TransactionType>([&](pqxx::transaction_base &txn) { return txn.exec(pqxx::prepped{statement.name}, params); });
 
-            if constexpr (std::is_same_v<TransactionType, pqxx::work>)
-            {
-                txn.commit();
-            }
-        }
+        return ResultDecoder(std::move(results)).to<jsonType>();
+    }
+    catch (const std::exception &e)
+    {
+        Message::ErrorMessage("Error executing prepared statement:");
+        Message::InfoMessage(statement.sql);
+        Message::CriticalMessage(e.what());
+        return std::nullopt;
+    }
+}
 
-        jsonType       reply;
-        jsoncons::json object;
+std::optional<std::vector<jsoncons::json>> Database::executeBatch(const std::vector<PreparedStatement> &statements, std::string &sqlstate)
+{
+    try
+    {
+        std::vector<jsoncons::json> replies;
+        replies.reserve(statements.size());
 
-        for (const auto &row : results)
-        {
-            for (const auto &field : row)
+        run<pqxx::work>(
+            [&](pqxx::transaction_base &txn)
             {
-                std::string  field_name = field.name();
-                unsigned int field_type = field.type();
-
-                if (field.is_null())
+                for (const auto &statement : statements)
                 {
-                    object[field_name] = nullptr;
-                    LOG_WARN << "Field " << field_name << " is null";
+                    if (!prepared_.contains(statement.name))
+                    {
+                        connection->prepare(statement.name, statement.sql);
+                        prepared_.insert(statement.name);
+                    }
+
+                    pqxx::params params;
+                    for (const auto &param : statement.params)
+                    {
+                        params.append(param);
+                    }
+
+                    std::optional<jsoncons::json> reply = ResultDecoder(txn.exec(pqxx::prepped{statement.name}, params)).to<jsoncons::json>();
+                    replies.push_back(reply.value_or(jsoncons::json()));
                 }
-                else
+            });
+
+        return replies;
+    }
+    catch (const pqxx::sql_error &e)
+    {
+        sqlstate = e.sqlstate();
+        Message::ErrorMessage("Error executing statement batch:");
+        Message::CriticalMessage(e.what());
+        return std::nullopt;
+    }
+    catch (const std::exception &e)
+    {
+        Message::ErrorMessage("Error executing statement batch:");
+        Message::CriticalMessage(e.what());
+        return std::nullopt;
+    }
+}
+
+std::optional<size_t> Database::copyRows(const std::vector<CopyRows> &groups, std::string &error)
+{
+    try
+    {
+        return run<pqxx::work>(
+            [&](pqxx::transaction_base &txn)
+            {
+                size_t copied = 0;
+
+                for (const auto &group : groups)
                 {
-                    switch (field_type)
+                    std::vector<std::string> columns;
+                    columns.reserve(group.columns.size());
+                    for (const auto &column : group.columns)
                     {
-                        case TEXT:  // TEXT or VARCHAR
-                            object[field_name] = field.as<std::string>();
-                            break;
-
-                        case INTEGER:  // INTEGER
-                            object[field_name] = field.as<int>();
-                            break;
-
-                        case BOOLEAN:  // BOOLEAN
-                            object[field_name] = field.as<bool>();
-                            break;
-
-                        case JSON:   // JSON
-                        case JSONB:  // JSONB
-                            object[field_name] = jsoncons::json::parse(field.as<std::string>());
-                            break;
-
-                        default:                                 // Handle unknown or unhandled types
-                            object[field_name] = field.c_str();  // Default to string
-                                                                 // representation
-                            break;
+                        columns.push_back(PreparedStatement::quoteIdentifier(column));
                     }
+
+                    pqxx::stream_to stream =
+                        pqxx::stream_to::raw_table(txn, PreparedStatement::quoteIdentifier(group.table), fmt::format("{}", fmt::join(columns, ",")));
+
+                    for (const auto &row : group.rows)
+                    {
+                        stream.write_row(row);
+                    }
+                    stream.complete();
+
+                    copied += group.rows.size();
                 }
-            }
-            if constexpr (std::is_same_v<jsonType, jsoncons::json::array>)
-            {
-                reply.push_back(object);
-            }
-            else
-            {
-                return object;
-            }
-        }
-        return reply;
+                return copied;
+            });
     }
     catch (const std::exception &e)
     {
-        Message::ErrorMessage("Error executing query:");
-        Message::InfoMessage(query);
-        Message::CriticalMessage(e.what());
+        error = e.what();
+        Message::ErrorMessage(fmt::format("Error copying rows: {}", e.what()));
         return std::nullopt;
-        // throw;  // Rethrow the exception to indicate failure
     }
-    return std::nullopt;
 }
 
 template <typename T>
@@ -274,15 +380,7 @@ std::optional<T> Database::doSimpleQuery(const std::string &query, bool &isSqlIn
             return std::nullopt;
         }
 
-        pqxx::result result;
-
-        {
-            IUGUARD
-
-            pqxx::nontransaction txn(*connection);
-
-            result = txn.exec(query);
-        }
+        pqxx::result result = run<pqxx::nontransaction>([&](pqxx::transaction_base &txn) { return txn.exec(query); });
 
         return result.empty() ? std::nullopt : result[0][0].as<std::optional<T>>();
     }
@@ -301,3 +399,7 @@ template std::optional<std::string>           Database::doSimpleQuery<std::strin
 template std::optional<jsoncons::json>        Database::executeQuery<jsoncons::json, pqxx::nontransaction>(const std::string &, bool &);
 template std::optional<jsoncons::json>        Database::executeQuery<jsoncons::json, pqxx::work>(const std::string &, bool &);
 template std::optional<jsoncons::json::array> Database::executeQuery<jsoncons::json::array, pqxx::nontransaction>(const std::string &, bool &);
+template std::optional<jsoncons::json>        Database::executePrepared<jsoncons::json, pqxx::nontransaction>(const PreparedStatement &);
+template std::optional<jsoncons::json>        Database::executePrepared<jsoncons::json, pqxx::work>(const PreparedStatement &);
+template std::optional<jsoncons::json::array> Database::executePrepared<jsoncons::json::array, pqxx::nontransaction>(const PreparedStatement &);
+template std::optional<ResultDecoder>         Database::executePrepared<ResultDecoder, pqxx::nontransaction>(const PreparedStatement &);
@@ -4,22 +4,25 @@
 #include <fmt/format.h>
 #include <trantor/utils/Logger.h>
 
-#include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <jsoncons/basic_json.hpp>
 #include <jsoncons/json.hpp>
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <pqxx/pqxx>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "database/copyrows.hpp"
+#include "database/preparedstatement.hpp"
 #include "utils/global/types.hpp"
 
-#define IUGUARD InUseGuard connection_guard(isConnectionInUse_, mtx_, cv_);
-
 class Database
 {
    public:
@@ -37,25 +40,78 @@ class Database
     template <typename jsonType, typename TransactionType>
     std::optional<jsonType> executeQuery(const std::string &query, bool &isSqlInjection);
 
+    template <typename jsonType, typename TransactionType>
+    std::optional<jsonType> executePrepared(const PreparedStatement &statement);
+
+    // runs the statements in order inside one transaction on this connection, one first-row object per statement.
+    // When a statement fails sqlstate holds its SQLSTATE, it stays empty if the connection failed
+    std::optional<std::vector<jsoncons::json>> executeBatch(const std::vector<PreparedStatement> &statements, std::string &sqlstate);
+
+    // streams the groups with COPY FROM STDIN inside one transaction, returns the number of rows written.
+    // Nothing is written if any row is rejected, error then holds the reason given by the database
+    std::optional<size_t> copyRows(const std::vector<CopyRows> &groups, std::string &error);
+
     template <typename T>
     std::optional<T> doSimpleQuery(const std::string &query, bool &isSqlInjection);
 
-    std::optional<std::unordered_set<api::v2::ColumnInfo>> getTableSchema(const std::string &tableName);
-    std::optional<std::unordered_set<std::string>>         getAllTables();
+    // the columns of every table and view of the public schema, keyed by table name
+    std::optional<std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>> getSchema();
+
+    // A transaction spanning a whole request (see RequestLease), every statement runs inside it while it is open.
+    bool beginRequestTransaction();
+    // commits or rolls back, returns false if that failed
+    bool endRequestTransaction(bool commit);
+    [[nodiscard]] bool inRequestTransaction() const { return requestTxn_ != nullptr; }
+
+    // subscribes this connection to channel, what is notified on it is then counted by awaitNotifications
+    bool listen(const std::string &channel);
+    // waits up to timeout for notifications, returns how many arrived, nullopt if the connection broke
+    std::optional<size_t> awaitNotifications(std::chrono::microseconds timeout);
+
+    // host this connection talks to
+    [[nodiscard]] std::string host() const;
+
+    // bookkeeping for the pool, only touched by whoever holds the connection
+    void                                                touch() { lastUsed_ = std::chrono::steady_clock::now(); }
+    [[nodiscard]] std::chrono::steady_clock::time_point lastUsed() const { return lastUsed_; }
 
    private:
+    // runs func on the open request transaction if there is one, on its own TransactionType otherwise
+    template <typename TransactionType, typename Func>
+    auto run(Func &&func)
+    {
+        if (requestTxn_ != nullptr)
+        {
+            return std::forward<Func>(func)(static_cast<pqxx::transaction_base &>(*requestTxn_));
+        }
+
+        TransactionType txn(*connection);
+
+        if constexpr (std::is_void_v<std::invoke_result_t<Func, pqxx::transaction_base &>>)
+        {
+            std::forward<Func>(func)(static_cast<pqxx::transaction_base &>(txn));
+            if constexpr (std::is_same_v<TransactionType, pqxx::work>)
+            {
+                txn.commit();
+            }
+        }
+        else
+        {
+            auto result = std::forward<Func>(func)(static_cast<pqxx::transaction_base &>(txn));
+            if constexpr (std::is_same_v<TransactionType, pqxx::work>)
+            {
+                txn.commit();
+            }
+            return result;
+        }
+    }
+
     std::shared_ptr<pqxx::connection> connection;
     std::string                       connection_info;  // Store connection parameters
+    std::unordered_set<std::string>   prepared_;        // statements prepared on the current connection
+    std::unique_ptr<pqxx::work>       requestTxn_;      // open request transaction, if any
 
-    std::atomic<bool>       isConnectionInUse_;
-    std::mutex              mtx_;
-    std::condition_variable cv_;
-
-    static const std::uint16_t TEXT    = 1043;
-    static const std::uint16_t INTEGER = 23;
-    static const std::uint16_t BOOLEAN = 16;
-    static const std::uint16_t JSON    = 114;
-    static const std::uint16_t JSONB   = 3802;
+    std::chrono::steady_clock::time_point lastUsed_ = std::chrono::steady_clock::now();
 };
 
 #endif  // DATABASE_HPP
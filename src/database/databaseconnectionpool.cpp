@@ -1,19 +1,21 @@
 #include "databaseconnectionpool.hpp"
 
 #include <fmt/core.h>
+#include <trantor/net/EventLoop.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <cstdlib>
 #include <exception>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <pqxx/pqxx>
-#include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -23,12 +25,12 @@
 #include "store/store.hpp"
 #include "utils/message/message.hpp"
 
-std::shared_ptr<Database> DatabaseConnectionPool::createDatabaseConnection(const auto& config)
+std::shared_ptr<Database> DatabaseConnectionPool::createDatabaseConnection(const auto& config, const std::string& host)
 {
     try
     {
         auto conn = std::make_shared<pqxx::connection>(
-            fmt::format("host={} dbname={} user={} password={} connect_timeout={}", config.host, config.name, config.user, config.pass, TIMEOUT).c_str());
+            fmt::format("host={} dbname={} user={} password={} connect_timeout={}", host, config.name, config.user, config.pass, TIMEOUT).c_str());
 
         if (conn->is_open())
         {
@@ -44,130 +46,475 @@ std::shared_ptr<Database> DatabaseConnectionPool::createDatabaseConnection(const
     return nullptr;
 }
 
-DatabaseConnectionPool::DatabaseConnectionPool() : configurator_(Store::getObject<Configurator>())
+std::atomic<size_t> DatabaseConnectionPool::threadCounter_{0};
+
+DatabaseConnectionPool::DatabaseConnectionPool()
+    : DatabaseConnectionPool(std::vector<std::string>{Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().host})
 {
-    try
+}
+
+DatabaseConnectionPool::DatabaseConnectionPool(std::vector<std::string> hosts) : configurator_(Store::getObject<Configurator>()), hosts_(std::move(hosts))
+{
+    const Configurator::DatabaseConfig& config    = configurator_->get<Configurator::DatabaseConfig>();
+    const Configurator::ServerConfig&   servercfg = configurator_->get<Configurator::ServerConfig>();
+
+    minConnections_ = config.min_conn;
+    maxConnections_ = config.max_conn;
+    idleTimeout_    = config.idle_timeout;
+    growWait_       = config.grow_wait;
+    ioLeaseWait_    = config.io_lease_wait;
+
+    // one slice per IO thread, each able to hold every connection so a return never fails
+    size_t slices = std::max<size_t>(1, servercfg.threads);
+    slices_.reserve(slices);
+    for (size_t i = 0; i < slices; ++i)
     {
-        const Configurator::DatabaseConfig& config = configurator_->get<Configurator::DatabaseConfig>();
+        slices_.push_back(std::make_unique<Slice>(maxConnections_));
+    }
 
-        std::vector<std::future<std::shared_ptr<Database>>> futures;
+    std::vector<std::future<std::shared_ptr<Database>>> futures;
 
-        futures.reserve(config.max_conn);
-        for (uint16_t i = 0; i < config.max_conn; ++i)
-        {
-            futures.push_back(std::async(std::launch::async,
-                [this, config]() -> std::shared_ptr<Database>
+    futures.reserve(minConnections_);
+    for (uint16_t i = 0; i < minConnections_; ++i)
+    {
+        openConnections_.fetch_add(1);
+        futures.push_back(std::async(std::launch::async,
+            [this, config, host = nextHost()]() -> std::shared_ptr<Database>
+            {
+                unsigned int retryCount = 0;
+                while (retryCount < MAX_RETRIES)
                 {
-                    unsigned int retryCount = 0;
-                    while (retryCount < MAX_RETRIES)
+                    auto conn = createDatabaseConnection(config, host);
+                    if (conn)
                     {
-                        auto conn = createDatabaseConnection(config);
-                        if (conn)
-                        {
-                            return conn;
-                        }
-                        std::this_thread::sleep_for(std::chrono::seconds(1U << retryCount));
-                        Message::WarningMessage(fmt::format("Failed to create a database connection. Attempt {}/{}...", ++retryCount, MAX_RETRIES));
+                        return conn;
                     }
-                    return nullptr;
-                }));
+                    std::this_thread::sleep_for(std::chrono::seconds(1U << retryCount));
+                    Message::WarningMessage(fmt::format("Failed to create a database connection. Attempt {}/{}...", ++retryCount, MAX_RETRIES));
+                }
+                return nullptr;
+            }));
+    }
+
+    // Wait for all futures
+    size_t created = 0;
+    for (auto& future : futures)
+    {
+        auto conn = future.get();  // Blocks only on completion of the individual task
+        if (conn != nullptr)
+        {
+            // deal the connections round robin over the slices
+            conn->touch();
+            slices_[created % slices_.size()]->try_push(std::move(conn));
+            Message::InitMessage(fmt::format("Connection {}/{} created successfully.", ++created, minConnections_));
+        }
+        else
+        {
+            // the maintenance thread keeps trying in the background
+            openConnections_.fetch_sub(1);
+            Message::ErrorMessage("Failed to establish a database connection after maximum retries, it will be retried in the background.");
         }
+    }
+
+    maintenanceThread_ = std::thread(&DatabaseConnectionPool::maintain, this);
+    // SqlInjectionDetector::initialize();
+}
+
+DatabaseConnectionPool::~DatabaseConnectionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex_);
+        stopMaintenance_ = true;
+    }
+    maintenanceCv_.notify_all();
+
+    if (maintenanceThread_.joinable())
+    {
+        maintenanceThread_.join();
+    }
+}
+
+const std::string& DatabaseConnectionPool::nextHost()
+{
+    // spread the connections evenly over the hosts
+    return hosts_[nextHost_.fetch_add(1, std::memory_order_relaxed) % hosts_.size()];
+}
+
+size_t DatabaseConnectionPool::homeSlice() const
+{
+    // an IO thread owns the slice of its loop, any other thread is handed one in order of arrival
+    trantor::EventLoop *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (loop != nullptr && loop->index() < slices_.size())
+    {
+        return loop->index();
+    }
+
+    thread_local const size_t ordinal = threadCounter_.fetch_add(1, std::memory_order_relaxed);
+    return ordinal % slices_.size();
+}
+
+std::shared_ptr<Database> DatabaseConnectionPool::tryAcquire()
+{
+    std::shared_ptr<Database> db_ptr;
+    size_t                    home = homeSlice();
 
-        // Wait for all futures
-        for (auto& future : futures)
+    // own slice first, then steal from the neighbours
+    for (size_t i = 0; i < slices_.size(); ++i)
+    {
+        if (slices_[(home + i) % slices_.size()]->try_pop(db_ptr))
         {
-            auto conn = future.get();  // Blocks only on completion of the individual task
-            if (conn != nullptr)
-            {
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    databaseConnections_.push_back(conn);
-                }
-                Message::InitMessage(fmt::format("Connection {}/{} created successfully.", databaseConnections_.size(), config.max_conn));
-            }
-            else
-            {
-                Message::ErrorMessage("Failed to establish one or more connections after maximum retries.");
-                throw std::runtime_error("Database connection pool initialization failure.");
-            }
+            return db_ptr;
         }
     }
-    catch (const std::exception& e)
+    return nullptr;
+}
+
+void DatabaseConnectionPool::release(std::shared_ptr<Database>&& db_ptr)
+{
+    size_t home = homeSlice();
+
+    for (size_t i = 0; i < slices_.size(); ++i)
     {
-        std::string what = e.what();
-        Message::CriticalMessage(fmt::format("Failed to initialize database connection pool: {}", what.substr(0, -4)));
-        Message::ErrorMessage("Exiting...");
-        exit(EXIT_FAILURE); /*NOLINT*/
+        if (slices_[(home + i) % slices_.size()]->try_push(std::move(db_ptr)))
+        {
+            // pairs with the fence in get_connection, either the waiter sees the connection or this sees the waiter
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) != 0)
+            {
+                std::lock_guard<std::mutex> lock(leaseMutex_);
+                leaseCv_.notify_one();
+            }
+            return;
+        }
     }
-    // SqlInjectionDetector::initialize();
+    Message::CriticalMessage("No room left in the connection pool, dropping connection.");
 }
 
 std::shared_ptr<Database> DatabaseConnectionPool::get_connection()
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::shared_ptr<Database> db_ptr = tryAcquire();
 
-    if (!cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !databaseConnections_.empty(); }))
+    if (db_ptr != nullptr)
     {
-        Message::CriticalMessage("Timeout while waiting for a connection");
-        return nullptr;
+        return db_ptr;
+    }
+
+    // an IO thread holds up every other connection of its loop while it waits, so it only rides out a short spike
+    // and asks for growth at once, any other thread sleeps until a connection comes back, growing the pool once it
+    // waited growWait_
+    const bool                      ioThread = trantor::EventLoop::getEventLoopOfCurrentThread() != nullptr;
+    const std::chrono::milliseconds wait     = ioThread ? ioLeaseWait_ : std::chrono::seconds(LEASE_TIMEOUT_S);
+    const auto                      start    = std::chrono::steady_clock::now();
+    const auto                      deadline = start + wait;
+    bool                            growing  = ioThread;
+
+    if (ioThread)
+    {
+        requestGrowth();
     }
 
-    std::shared_ptr<Database> db_ptr = std::move(databaseConnections_.front());
+    std::unique_lock<std::mutex> lock(leaseMutex_);
+    waiters_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    while ((db_ptr = tryAcquire()) == nullptr)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            break;
+        }
+
+        if (!growing && now - start >= growWait_)
+        {
+            growing = true;
+            requestGrowth();
+        }
+        leaseCv_.wait_until(lock, growing ? deadline : start + growWait_);
+    }
+    waiters_.fetch_sub(1);
+    lock.unlock();
 
-    databaseConnections_.pop_front();
+    if (ioThread)
+    {
+        ioWaited_.fetch_add(1, std::memory_order_relaxed);
+        ioWaitMicros_.fetch_add(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        if (db_ptr == nullptr)
+        {
+            ioFailed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 
+    if (db_ptr == nullptr)
+    {
+        Message::CriticalMessage("Timeout while waiting for a connection");
+    }
     return db_ptr;
 }
 
+DatabaseConnectionPool::IoLeaseStats DatabaseConnectionPool::ioLeaseStats() const
+{
+    return IoLeaseStats{
+        .waited   = ioWaited_.load(std::memory_order_relaxed),
+        .failed   = ioFailed_.load(std::memory_order_relaxed),
+        .waitTime = std::chrono::microseconds(ioWaitMicros_.load(std::memory_order_relaxed)),
+    };
+}
+
 void DatabaseConnectionPool::return_connection(std::shared_ptr<Database>&& db_ptr)
 {
     if (db_ptr != nullptr)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        databaseConnections_.push_back(std::move(db_ptr));
-        cv_.notify_one();
+        db_ptr->touch();
+        release(std::move(db_ptr));
     }
 }
 
-void DatabaseConnectionPool::reconnect_all()
+void DatabaseConnectionPool::discard_connection(std::shared_ptr<Database>&& db_ptr)
 {
-    const Configurator::DatabaseConfig& config = configurator_->get<Configurator::DatabaseConfig>();
+    if (db_ptr != nullptr)
+    {
+        Message::WarningMessage(fmt::format("Database connection {} is discarded from the pool.", static_cast<void*>(db_ptr.get())));
+        db_ptr.reset();
+        openConnections_.fetch_sub(1);
+        maintenanceCv_.notify_one();
+    }
+}
+
+std::shared_ptr<Database> DatabaseConnectionPool::open_connection()
+{
+    return createDatabaseConnection(configurator_->get<Configurator::DatabaseConfig>(), hosts_.front());
+}
+
+size_t DatabaseConnectionPool::validate_idle(std::chrono::milliseconds idleFor)
+{
+    // checks that outlived an earlier sweep are forgotten once they are done
+    std::erase_if(stragglers_, [](const std::future<void>& check) { return check.wait_for(std::chrono::seconds::zero()) == std::future_status::ready; });
 
-    std::vector<std::future<void>> futures;
-    futures.reserve(config.max_conn);
+    const auto now     = std::chrono::steady_clock::now();
+    const auto due     = now + std::chrono::seconds(PROBE_TIMEOUT_S);
+    auto       swapped = std::make_shared<std::atomic<size_t>>(0);
 
+    struct Check
     {
-        // Lock the database connections during the iteration
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::future<void>                  done;
+        std::shared_ptr<std::atomic<bool>> settled;  // set by whichever of the check and the sweep gets to it first
+    };
+    std::vector<Check>                  checks;
+    std::unordered_set<const Database*> seen;  // a checked connection may come back into a slice not walked yet
 
-        for (auto& connection : databaseConnections_)
+    // only idle connections are touched, leased ones are owned by their lessee, and one is out of its slice at a time
+    for (auto& slice : slices_)
+    {
+        size_t                    idle = slice->size();
+        std::shared_ptr<Database> connection;
+
+        for (size_t i = 0; i < idle && slice->try_pop(connection); ++i)
         {
-            // Launch reconnection tasks asynchronously
-            futures.push_back(std::async(std::launch::async,
-                [&connection]()
+            // a connection that just came back was working a moment ago, it goes straight back to work
+            if (now - connection->lastUsed() < idleFor || !seen.insert(connection.get()).second)
+            {
+                if (!slice->try_push(std::move(connection)))
                 {
-                    try
-                    {
-                        if (connection->reconnect())
-                        {
-                            Message::InfoMessage(fmt::format("Database connection {} is re-established successfully", static_cast<void*>(connection.get())));
-                        }
-                        else
-                        {
-                            Message::ErrorMessage(fmt::format("Database connection {} failed to be re-established", static_cast<void*>(connection.get())));
-                        }
-                    }
-                    catch (const std::exception& e)
-                    {
-                        Message::CriticalMessage(fmt::format("Reconnect exception: {}", e.what()));
-                    }
-                }));
+                    release(std::move(connection));
+                }
+                continue;
+            }
+
+            // every check runs on its own and hands its connection back as soon as it is done,
+            // a dead connection waiting on its timeout holds up nobody else
+            auto settled = std::make_shared<std::atomic<bool>>(false);
+            auto done    = std::async(std::launch::async, &DatabaseConnectionPool::validate, this, std::move(connection), settled, swapped);
+            checks.push_back({.done = std::move(done), .settled = std::move(settled)});
         }
     }
 
-    // Wait for all futures to complete
-    for (auto& future : futures)
+    for (auto& check : checks)
+    {
+        if (check.done.wait_until(due) == std::future_status::ready)
+        {
+            continue;
+        }
+
+        // the probe hangs on a dead link, its slot is freed for a replacement
+        // and the connection is dropped once libpq gives up
+        if (!check.settled->exchange(true))
+        {
+            Message::WarningMessage(fmt::format("Database connection check timed out after {} seconds, replacing it.", PROBE_TIMEOUT_S));
+            openConnections_.fetch_sub(1);
+            maintenanceCv_.notify_one();
+        }
+        stragglers_.push_back(std::move(check.done));
+    }
+
+    return swapped->load();
+}
+
+void DatabaseConnectionPool::validate(
+    std::shared_ptr<Database> connection, std::shared_ptr<std::atomic<bool>> settled, std::shared_ptr<std::atomic<size_t>> swapped)
+{
+    try
+    {
+        bool alive = connection->check_connection();
+
+        // the sweep gave up on this one and already counted it as lost
+        if (settled->exchange(true))
+        {
+            return;
+        }
+
+        if (alive)
+        {
+            release(std::move(connection));
+            return;
+        }
+
+        Message::WarningMessage(fmt::format("Database connection {} link is lost, replacing it.", static_cast<void*>(connection.get())));
+        const std::string         host        = connection->host().empty() ? hosts_.front() : connection->host();
+        std::shared_ptr<Database> replacement = createDatabaseConnection(configurator_->get<Configurator::DatabaseConfig>(), host);
+
+        if (replacement == nullptr)
+        {
+            // no replacement could be opened, the maintenance thread keeps trying
+            discard_connection(std::move(connection));
+            return;
+        }
+
+        // a checked connection keeps its idle time so the reaper still sees it, a fresh one starts anew
+        Message::InfoMessage(
+            fmt::format("Database connection {} is swapped for {}.", static_cast<void*>(connection.get()), static_cast<void*>(replacement.get())));
+        connection.reset();
+        replacement->touch();
+        swapped->fetch_add(1);
+        release(std::move(replacement));
+    }
+    catch (const std::exception& e)
+    {
+        Message::CriticalMessage(fmt::format("Connection validation exception: {}", e.what()));
+        discard_connection(std::move(connection));
+    }
+}
+
+void DatabaseConnectionPool::requestGrowth()
+{
+    if (openConnections_.load() < maxConnections_ && !growthRequested_.exchange(true))
+    {
+        maintenanceCv_.notify_one();
+    }
+}
+
+void DatabaseConnectionPool::reportIoLeases()
+{
+    IoLeaseStats now    = ioLeaseStats();
+    uint64_t     waited = now.waited - ioReported_.waited;
+
+    // quiet while the IO threads find their connections at once
+    if (waited == 0)
     {
-        future.wait();
+        return;
+    }
+
+    uint64_t failed   = now.failed - ioReported_.failed;
+    auto     waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(now.waitTime - ioReported_.waitTime);
+    ioReported_       = now;
+
+    Message::WarningMessage(fmt::format(
+        "IO threads waited {} times for a database connection, {} ms in total, {} of them got none.", waited, waitTime.count(), failed));
+}
+
+bool DatabaseConnectionPool::grow()
+{
+    // reserve a slot first so concurrent growth never exceeds max_conn
+    uint16_t open = openConnections_.load();
+    do
+    {
+        if (open >= maxConnections_)
+        {
+            return false;
+        }
+    } while (!openConnections_.compare_exchange_weak(open, open + 1));
+
+    std::shared_ptr<Database> conn = createDatabaseConnection(configurator_->get<Configurator::DatabaseConfig>(), nextHost());
+
+    if (conn == nullptr)
+    {
+        openConnections_.fetch_sub(1);
+        return false;
+    }
+
+    Message::InfoMessage(fmt::format("Database connection pool grew to {} connections.", open + 1));
+    conn->touch();
+    release(std::move(conn));
+    return true;
+}
+
+void DatabaseConnectionPool::refill()
+{
+    while (!stopMaintenance_ && openConnections_.load() < minConnections_)
+    {
+        if (!grow())
+        {
+            Message::WarningMessage("Failed to refill the database connection pool, retrying later.");
+            return;
+        }
+    }
+}
+
+void DatabaseConnectionPool::reap()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    // one connection is out of its slice at a time, a concurrent lease never finds the pool drained by the reaper
+    for (auto& slice : slices_)
+    {
+        size_t                    idle = slice->size();
+        std::shared_ptr<Database> connection;
+
+        for (size_t i = 0; i < idle && openConnections_.load() > minConnections_ && slice->try_pop(connection); ++i)
+        {
+            if (now - connection->lastUsed() > idleTimeout_)
+            {
+                connection.reset();
+                Message::InfoMessage(fmt::format("Database connection pool shrank to {} connections.", openConnections_.fetch_sub(1) - 1));
+                continue;
+            }
+            // back to the tail of its own slice, the rotation brings the next candidate to the head
+            if (!slice->try_push(std::move(connection)))
+            {
+                release(std::move(connection));
+            }
+        }
+    }
+}
+
+void DatabaseConnectionPool::maintain()
+{
+    while (!stopMaintenance_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(maintenanceMutex_);
+            maintenanceCv_.wait_for(lock, std::chrono::seconds(MAINTENANCE_PERIOD_S), [this] { return stopMaintenance_ || growthRequested_.load(); });
+        }
+
+        if (stopMaintenance_)
+        {
+            break;
+        }
+
+        try
+        {
+            if (growthRequested_.exchange(false))
+            {
+                grow();
+            }
+            refill();
+            reap();
+            reportIoLeases();
+        }
+        catch (const std::exception& e)
+        {
+            Message::CriticalMessage(fmt::format("Database connection pool maintenance exception: {}", e.what()));
+        }
     }
 }
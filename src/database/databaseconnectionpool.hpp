@@ -1,14 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/mpmcqueue/mpmcqueue.hpp"
 
 class Database;
 class Configurator;
 
+/// Idle connections are spread over one slice per IO thread. A thread leases from and
+/// returns to its own slice and steals from the other slices when it runs dry, every
+/// slice being a lock-free MPMC queue so neither path takes a lock. An IO thread finding
+/// every slice empty asks for growth at once and waits at most io_lease_wait for a connection,
+/// other threads wait up to LEASE_TIMEOUT_S. How often and how long IO threads waited is
+/// counted and logged by the maintenance thread, so the wait can be dropped once the blocking
+/// callers on the loops are gone.
+/// The pool keeps between min_conn and max_conn connections open: a maintenance thread
+/// opens more when leases start waiting, closes connections idle for longer than
+/// idle_timeout and refills the pool in the background when connections are lost.
 class DatabaseConnectionPool
 {
    public:
@@ -17,20 +35,90 @@ class DatabaseConnectionPool
     DatabaseConnectionPool(DatabaseConnectionPool &&)                 = delete;
     DatabaseConnectionPool &operator=(const DatabaseConnectionPool &) = delete;
     DatabaseConnectionPool &operator=(DatabaseConnectionPool &&)      = delete;
-    virtual ~DatabaseConnectionPool()                                 = default;
+    virtual ~DatabaseConnectionPool();
+
+    // how often IO threads found the pool empty since the start, and how it went
+    struct IoLeaseStats
+    {
+        uint64_t                  waited;    // leases that had to wait
+        uint64_t                  failed;    // of those, the ones that got no connection
+        std::chrono::microseconds waitTime;  // spent waiting in total
+    };
 
     [[nodiscard]] std::shared_ptr<Database> get_connection();
     void                                    return_connection(std::shared_ptr<Database> &&db_ptr);
-    void                                    reconnect_all();
+
+    // drops a connection that cannot be recovered, the maintenance thread opens a replacement
+    void discard_connection(std::shared_ptr<Database> &&db_ptr);
+
+    [[nodiscard]] IoLeaseStats ioLeaseStats() const;
+
+    // a connection to the pool's first host that is not part of the pool, nullptr if it cannot be opened
+    [[nodiscard]] std::shared_ptr<Database> open_connection();
+
+    // checks the connections that sat idle for at least idleFor in parallel, leased ones are left alone.
+    // Each goes back as soon as its own check is done, a broken one swapped for a freshly opened one.
+    // A check that does not answer within PROBE_TIMEOUT_S is given up on and its slot refilled.
+    // Returns how many were swapped by the time the sweep is over
+    size_t validate_idle(std::chrono::milliseconds idleFor);
+
+   protected:
+    // connections are spread round robin over the given hosts
+    explicit DatabaseConnectionPool(std::vector<std::string> hosts);
 
    private:
-    std::shared_ptr<Database> createDatabaseConnection(const auto &config_);
+    using Slice = MPMCQueue<std::shared_ptr<Database>>;
+
+    std::shared_ptr<Database> createDatabaseConnection(const auto &config_, const std::string &host);
+    const std::string        &nextHost();
+    std::shared_ptr<Database> tryAcquire();
+    void                      release(std::shared_ptr<Database> &&db_ptr);
+    [[nodiscard]] size_t      homeSlice() const;
+
+    bool grow();  // opens one connection if below max_conn
+    void maintain();
+    void refill();
+    void reap();
+    void requestGrowth();
+    void reportIoLeases();
+    // one check of validate_idle, it owns the connection until it hands it (or its replacement) back
+    void validate(std::shared_ptr<Database> connection, std::shared_ptr<std::atomic<bool>> settled, std::shared_ptr<std::atomic<size_t>> swapped);
+
+    std::shared_ptr<Configurator>       configurator_;
+    std::vector<std::string>            hosts_;
+    std::atomic<size_t>                 nextHost_{0};
+    std::vector<std::unique_ptr<Slice>> slices_;
+
+    uint16_t                  minConnections_;
+    uint16_t                  maxConnections_;
+    std::chrono::seconds      idleTimeout_;
+    std::chrono::milliseconds growWait_;
+    std::chrono::milliseconds ioLeaseWait_;
+
+    std::atomic<uint16_t> openConnections_{0};  // open plus currently opening
+    std::atomic<bool>     growthRequested_{false};
+
+    std::mutex              leaseMutex_;  // only taken by threads waiting for a lease and by returns while one waits
+    std::condition_variable leaseCv_;
+    std::atomic<size_t>     waiters_{0};
+
+    std::atomic<uint64_t> ioWaited_{0};
+    std::atomic<uint64_t> ioFailed_{0};
+    std::atomic<uint64_t> ioWaitMicros_{0};
+    IoLeaseStats          ioReported_{};  // what the last report covered, only touched by the maintenance thread
+
+    std::atomic<bool>       stopMaintenance_{false};
+    std::mutex              maintenanceMutex_;
+    std::condition_variable maintenanceCv_;
+    std::thread             maintenanceThread_;
+
+    std::vector<std::future<void>> stragglers_;  // checks validate_idle gave up on, only touched by its caller
 
-    std::shared_ptr<Configurator>         configurator_;
-    std::deque<std::shared_ptr<Database>> databaseConnections_;
-    std::mutex                            mutex_;  // protects databaseConnections
-    std::condition_variable               cv_;
+    static std::atomic<size_t> threadCounter_;  // hands every thread its slice ordinal
 
-    static constexpr std::uint16_t TIMEOUT     = 2;
-    static constexpr unsigned int  MAX_RETRIES = 5;
+    static constexpr std::uint16_t TIMEOUT              = 2;
+    static constexpr unsigned int  MAX_RETRIES          = 5;
+    static constexpr std::uint16_t LEASE_TIMEOUT_S      = 1;
+    static constexpr std::uint16_t MAINTENANCE_PERIOD_S = 1;
+    static constexpr std::uint16_t PROBE_TIMEOUT_S      = 5;
 };
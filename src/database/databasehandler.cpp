@@ -4,18 +4,41 @@
 #include <utility>
 
 #include "database/databaseconnectionpool.hpp"
+#include "database/requestlease.hpp"
 #include "store/store.hpp"
 
-DatabaseHanndler::DatabaseHanndler() : databaseConnectionPool(Store::getObject<DatabaseConnectionPool>()) { db_ptr = databaseConnectionPool->get_connection(); }
+DatabaseHanndler::DatabaseHanndler() : databaseConnectionPool(Store::getObject<DatabaseConnectionPool>())
+{
+    std::shared_ptr<RequestLease> lease = RequestLease::current();
+    if (lease != nullptr)
+    {
+        db_ptr   = lease->connection();
+        borrowed = db_ptr != nullptr;
+
+        // a query of a request transaction never slips out of it onto another connection, it fails instead
+        if (!borrowed && lease->transactional())
+        {
+            return;
+        }
+    }
+
+    if (!borrowed)
+    {
+        db_ptr = databaseConnectionPool->get_connection();
+    }
+}
+
+DatabaseHanndler::DatabaseHanndler(std::shared_ptr<DatabaseConnectionPool> pool) : databaseConnectionPool(std::move(pool))
+{
+    db_ptr = databaseConnectionPool->get_connection();
+}
 
 DatabaseHanndler::~DatabaseHanndler()
 {
-    if (db_ptr != nullptr)
+    if (db_ptr != nullptr && !borrowed)
     {
         databaseConnectionPool->return_connection(std::move(db_ptr));
     }
 }
 
 std::shared_ptr<Database> DatabaseHanndler::get_connection() { return db_ptr; }
-
-void DatabaseHanndler::reconnect_all() { databaseConnectionPool->reconnect_all(); }
@@ -8,7 +8,11 @@ class Database;
 class DatabaseHanndler
 {
    public:
+    // borrows the connection of the request lease of the calling thread if there is one,
+    // get_connection is nullptr when a transactional lease has none to lend
     DatabaseHanndler();
+    // leases from the given pool instead of the primary one
+    explicit DatabaseHanndler(std::shared_ptr<DatabaseConnectionPool> pool);
     DatabaseHanndler(const DatabaseHanndler &)            = default;
     DatabaseHanndler(DatabaseHanndler &&)                 = delete;
     DatabaseHanndler &operator=(const DatabaseHanndler &) = default;
@@ -16,9 +20,9 @@ class DatabaseHanndler
     virtual ~DatabaseHanndler();
 
     std::shared_ptr<Database> get_connection();
-    void                      reconnect_all();
 
    private:
     std::shared_ptr<DatabaseConnectionPool> databaseConnectionPool;
     std::shared_ptr<Database>               db_ptr;
+    bool                                    borrowed = false;  // owned by the request lease, not returned here
 };
\ No newline at end of file
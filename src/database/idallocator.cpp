@@ -0,0 +1,356 @@
+#include "database/idallocator.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "configurator/configurator.hpp"
+#include "controllers/databasecontroller/databasecontroller.hpp"
+#include "store/store.hpp"
+#include "utils/message/message.hpp"
+
+IdAllocator::IdAllocator()
+    : databaseController(Store::getObject<DatabaseController>()), block_(Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().id_block)
+{
+}
+
+void IdAllocator::prepare(const std::string &table)
+{
+    const std::string sequence = fmt::format("{}_id_seq", table);
+
+    std::optional<jsoncons::json> found = databaseController->executeReadPrepared(
+        PreparedStatement("SELECT seqincrement AS step FROM pg_sequence WHERE seqrelid = to_regclass($1);", {sequence}));
+
+    if (!found.has_value() || !found->contains("step"))
+    {
+        return;
+    }
+
+    Pool   &pool = poolOf(table);
+    int64_t step = found->at("step").as<int64_t>();
+
+    if (step > 0)
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.step = static_cast<uint64_t>(step);
+    }
+
+    std::optional<std::vector<Range>> reserved = reserve(table, block_, pool);
+    if (reserved.has_value())
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        add(pool, reserved.value());
+    }
+}
+
+void IdAllocator::next(const std::string &table, std::size_t count, Callback &&callback)
+{
+    Pool                        &pool = poolOf(table);
+    std::unique_lock<std::mutex> lock(pool.mutex);
+
+    // earlier waiters go first, a large request is not overtaken for good by small ones
+    if (pool.waiters.empty() && pool.available >= count)
+    {
+        std::vector<uint64_t> ids = take(pool.ranges, count);
+        pool.available -= count;
+
+        bool low = runsLow(pool);
+        lock.unlock();
+
+        if (low)
+        {
+            refill(table, &pool, block_);
+        }
+        callback(std::move(ids));
+        return;
+    }
+
+    pool.waiters.push_back(Waiter{.count = count, .callback = std::move(callback), .loop = trantor::EventLoop::getEventLoopOfCurrentThread()});
+
+    std::size_t wanted = block_;
+    for (const Waiter &waiter : pool.waiters)
+    {
+        wanted += waiter.count;
+    }
+    wanted -= std::min(wanted - block_, pool.available);
+
+    bool start     = !pool.refilling;
+    pool.refilling = true;
+    lock.unlock();
+
+    // a reservation in flight serves this waiter too, or starts the next one when it falls short
+    if (start)
+    {
+        refill(table, &pool, wanted);
+    }
+}
+
+std::optional<std::vector<uint64_t>> IdAllocator::nextBlocking(const std::string &table, std::size_t count)
+{
+    Pool                        &pool = poolOf(table);
+    std::unique_lock<std::mutex> lock(pool.mutex);
+
+    // a request needing more than is in memory reserves the rest plus a block for the requests after it
+    while (pool.available < count)
+    {
+        std::size_t missing = count - pool.available;
+        lock.unlock();
+
+        std::optional<std::vector<Range>> reserved = reserve(table, missing + block_, pool);
+        if (!reserved.has_value())
+        {
+            return std::nullopt;
+        }
+
+        lock.lock();
+        add(pool, reserved.value());
+    }
+
+    std::vector<uint64_t> ids = take(pool.ranges, count);
+    pool.available -= count;
+
+    bool low = runsLow(pool);
+    lock.unlock();
+
+    if (low)
+    {
+        refill(table, &pool, block_);
+    }
+    return ids;
+}
+
+uint64_t IdAllocator::callsFor(std::size_t count, uint64_t step) { return std::max<uint64_t>((count + step - 1) / step, 1); }
+
+std::vector<IdAllocator::Range> IdAllocator::rangesOf(const std::vector<uint64_t> &firsts, uint64_t step)
+{
+    std::vector<Range> ranges;
+    ranges.reserve(firsts.size());
+    for (uint64_t first : firsts)
+    {
+        ranges.push_back(Range{.first = first, .end = first + step});
+    }
+    return ranges;
+}
+
+std::vector<uint64_t> IdAllocator::take(std::deque<Range> &ranges, std::size_t count)
+{
+    std::vector<uint64_t> ids;
+    ids.reserve(count);
+    while (ids.size() < count)
+    {
+        Range &range = ranges.front();
+        ids.push_back(range.first++);
+        if (range.first == range.end)
+        {
+            ranges.pop_front();
+        }
+    }
+    return ids;
+}
+
+IdAllocator::Pool &IdAllocator::poolOf(const std::string &table)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_ptr<Pool>      &pool = pools_[table];
+    if (pool == nullptr)
+    {
+        pool = std::make_unique<Pool>();
+    }
+    return *pool;
+}
+
+std::optional<std::vector<IdAllocator::Range>> IdAllocator::reserve(const std::string &table, std::size_t count, Pool &pool)
+{
+    uint64_t step = 1;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        step = pool.step;
+    }
+
+    try
+    {
+        return ranges(table, databaseController->executePrepared(statement(table, count, step)), pool);
+    }
+    catch (const std::exception &e)
+    {
+        Message::ErrorMessage(fmt::format("Failed to reserve ids of {}.", table));
+        Message::CriticalMessage(e.what());
+        return std::nullopt;
+    }
+}
+
+void IdAllocator::refill(const std::string &table, Pool *pool, std::size_t count)
+{
+    uint64_t step = 1;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        step = pool->step;
+    }
+
+    // the allocator is a Store singleton and outlives every query
+    auto send = [this, table, pool, count, step]()
+    {
+        databaseController->executePreparedAsync(statement(table, count, step),
+            [this, table, pool](std::optional<jsoncons::json> &&reserved)
+            {
+                std::optional<std::vector<Range>> refilled;
+                try
+                {
+                    refilled = ranges(table, reserved, *pool);
+                }
+                catch (const std::exception &e)
+                {
+                    Message::ErrorMessage(fmt::format("Failed to reserve ids of {}.", table));
+                    Message::CriticalMessage(e.what());
+                }
+                landed(table, pool, std::move(refilled));
+            });
+    };
+
+    // next is often called from the callback of another query, the reservation is not sent from inside it
+    trantor::EventLoop *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (loop != nullptr)
+    {
+        loop->queueInLoop(std::move(send));
+    }
+    else
+    {
+        send();
+    }
+}
+
+void IdAllocator::landed(const std::string &table, Pool *pool, std::optional<std::vector<Range>> &&refilled)
+{
+    std::vector<std::pair<Waiter, std::optional<std::vector<uint64_t>>>> served;
+    std::size_t                                                          wanted = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+
+        if (refilled.has_value())
+        {
+            add(*pool, refilled.value());
+        }
+
+        while (!pool->waiters.empty() && (!refilled.has_value() || pool->available >= pool->waiters.front().count))
+        {
+            Waiter waiter = std::move(pool->waiters.front());
+            pool->waiters.pop_front();
+
+            if (refilled.has_value())
+            {
+                std::vector<uint64_t> ids = take(pool->ranges, waiter.count);
+                pool->available -= waiter.count;
+                served.emplace_back(std::move(waiter), std::move(ids));
+            }
+            else
+            {
+                served.emplace_back(std::move(waiter), std::nullopt);
+            }
+        }
+
+        // the next reservation follows at once when the waiters need more than arrived or the pool runs low again
+        pool->refilling = false;
+        if (refilled.has_value() && (!pool->waiters.empty() || runsLow(*pool)))
+        {
+            pool->refilling = true;
+            wanted          = block_;
+            for (const Waiter &waiter : pool->waiters)
+            {
+                wanted += waiter.count;
+            }
+            wanted -= std::min(wanted - block_, pool->available);
+        }
+    }
+
+    for (auto &[waiter, ids] : served)
+    {
+        if (waiter.loop == nullptr)
+        {
+            waiter.callback(std::move(ids));
+            continue;
+        }
+        waiter.loop->queueInLoop([callback = std::move(waiter.callback), ids = std::move(ids)]() mutable { callback(std::move(ids)); });
+    }
+
+    if (wanted != 0)
+    {
+        refill(table, pool, wanted);
+    }
+}
+
+bool IdAllocator::runsLow(Pool &pool) const
+{
+    if (pool.refilling || pool.available >= (block_ + 1) / 2)
+    {
+        return false;
+    }
+    pool.refilling = true;
+    return true;
+}
+
+PreparedStatement IdAllocator::statement(const std::string &table, std::size_t count, uint64_t step)
+{
+    // every NEXTVAL reserves step ids, so count ids take count / step calls rounded up
+    uint64_t calls = callsFor(count, step);
+
+    return PreparedStatement(
+        "SELECT json_agg(q.n)::text AS firsts, max(s.seqincrement) AS step "
+        "FROM (SELECT NEXTVAL($1::regclass) AS n FROM generate_series(1, $2::bigint)) q CROSS JOIN pg_sequence s WHERE s.seqrelid = $1::regclass;",
+        {fmt::format("{}_id_seq", table), std::to_string(calls)});
+}
+
+std::optional<std::vector<IdAllocator::Range>> IdAllocator::ranges(
+    const std::string &table, const std::optional<jsoncons::json> &reserved, Pool &pool) const
+{
+    if (!reserved.has_value() || !reserved->contains("firsts") || !reserved->contains("step") || reserved->at("firsts").is_null())
+    {
+        Message::ErrorMessage(fmt::format("Failed to reserve ids of {}.", table));
+        return std::nullopt;
+    }
+
+    int64_t step = reserved->at("step").as<int64_t>();
+    if (step < 1)
+    {
+        Message::ErrorMessage(fmt::format("{}_id_seq counts down, ids of {} cannot be reserved.", table, table));
+        return std::nullopt;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.step = static_cast<uint64_t>(step);
+
+        if (pool.step < block_ && !pool.advised)
+        {
+            pool.advised = true;
+            Message::InfoMessage(fmt::format("{0}_id_seq increments by {1}, ALTER SEQUENCE {0}_id_seq INCREMENT BY {2}; reserves a block with one NEXTVAL.",
+                table, pool.step, block_));
+        }
+    }
+
+    std::vector<uint64_t> firsts;
+    for (const auto &first : jsoncons::json::parse(reserved->at("firsts").as<std::string>()).array_range())
+    {
+        firsts.push_back(first.as<uint64_t>());
+    }
+    return rangesOf(firsts, static_cast<uint64_t>(step));
+}
+
+void IdAllocator::add(Pool &pool, const std::vector<Range> &ranges)
+{
+    for (const Range &range : ranges)
+    {
+        pool.ranges.push_back(range);
+        pool.available += range.end - range.first;
+    }
+}
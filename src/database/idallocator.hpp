@@ -0,0 +1,105 @@
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+
+class DatabaseController;
+
+/// Hands out entity ids from blocks reserved ahead on the {table}_id_seq sequences, so a create does not wait
+/// for a NEXTVAL of its own. Every NEXTVAL reserves INCREMENT BY consecutive ids, which keeps the ids unique across
+/// server processes sharing the database. The server works with whatever step a sequence has and never alters it,
+/// a sequence incrementing by less than a block takes several NEXTVALs per block until an operator runs
+/// migrations/0001_id_sequence_blocks.sql. prepare reserves the first block before requests are served. When a
+/// table runs below half a block the next one is reserved in the background, a request only waits, without
+/// blocking its loop, if the ids it needs are not in memory yet. Reserved ids that are never handed out are lost on
+/// shutdown, like the ids of failed inserts.
+class IdAllocator
+{
+   public:
+    using Callback = std::function<void(std::optional<std::vector<uint64_t>> &&)>;
+
+    // ids first to end - 1 of one NEXTVAL
+    struct Range
+    {
+        uint64_t first;
+        uint64_t end;
+    };
+
+    IdAllocator();
+    IdAllocator(const IdAllocator &)            = delete;
+    IdAllocator(IdAllocator &&)                 = delete;
+    IdAllocator &operator=(const IdAllocator &) = delete;
+    IdAllocator &operator=(IdAllocator &&)      = delete;
+    virtual ~IdAllocator()                      = default;
+
+    // Reads the step of the sequence of table and reserves the first block. It blocks, so it runs while the
+    // controllers are set up. A table without a sequence is left alone.
+    void prepare(const std::string &table);
+
+    // hands count ids of table to callback, at once if they are in memory and otherwise on the calling loop once
+    // a block arrived, nullopt if the reservation failed
+    void next(const std::string &table, std::size_t count, Callback &&callback);
+    // count ids of table, waits for a reservation when they are not in memory, for threads that are not an event loop
+    std::optional<std::vector<uint64_t>> nextBlocking(const std::string &table, std::size_t count);
+
+    // the NEXTVAL calls reserving at least count ids of a sequence incrementing by step
+    static uint64_t callsFor(std::size_t count, uint64_t step);
+    // the ranges reserved by the NEXTVAL calls that returned firsts
+    static std::vector<Range> rangesOf(const std::vector<uint64_t> &firsts, uint64_t step);
+    // takes count ids off the front of ranges, which hold at least count
+    static std::vector<uint64_t> take(std::deque<Range> &ranges, std::size_t count);
+
+   private:
+    // a request waiting for ids, answered on its own loop
+    struct Waiter
+    {
+        std::size_t         count;
+        Callback            callback;
+        trantor::EventLoop *loop;
+    };
+
+    struct Pool
+    {
+        std::mutex         mutex;
+        std::deque<Range>  ranges;
+        std::size_t        available = 0;
+        uint64_t           step      = 1;  // INCREMENT BY of the sequence, learned from the first reservation
+        bool               refilling = false;
+        bool               advised   = false;  // the INCREMENT BY hint was logged
+        std::deque<Waiter> waiters;            // served in order once a reservation arrives
+    };
+
+    Pool &poolOf(const std::string &table);
+
+    // reserves at least count ids of table on the calling thread
+    std::optional<std::vector<Range>> reserve(const std::string &table, std::size_t count, Pool &pool);
+    // reserves at least count ids of table in the background, the query leaves after the running callback returned
+    void refill(const std::string &table, Pool *pool, std::size_t count);
+    // adds a background reservation to pool and serves the waiters it covers, all of them fail with it
+    void landed(const std::string &table, Pool *pool, std::optional<std::vector<Range>> &&refilled);
+    // whether pool runs low and should be refilled, marks it refilling if so, pool.mutex held
+    bool runsLow(Pool &pool) const;
+
+    static PreparedStatement          statement(const std::string &table, std::size_t count, uint64_t step);
+    std::optional<std::vector<Range>> ranges(const std::string &table, const std::optional<jsoncons::json> &reserved, Pool &pool) const;
+
+    static void add(Pool &pool, const std::vector<Range> &ranges);
+
+    std::shared_ptr<DatabaseController>                    databaseController;
+    std::size_t                                            block_;
+    std::mutex                                             mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Pool>> pools_;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <fmt/core.h>
+#include <xxhash.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// A parameterized SQL statement. The statement name is derived from the SQL
+/// text, so every (table, operation, column-set) shape maps to one name and is
+/// prepared only once per database connection. Values travel as bind
+/// parameters and are never spliced into the SQL text.
+struct PreparedStatement
+{
+    using Params = std::vector<std::optional<std::string>>;
+
+    PreparedStatement(std::string _sql, Params &&_params) : name(makeName(_sql)), sql(std::move(_sql)), params(std::move(_params)) {}
+
+    std::string name;
+    std::string sql;
+    Params      params;
+    std::string order;  // the ORDER BY list of sql if it has one, the page wrappers keep the rows in that order
+
+    // quote a column name so it can be part of the statement shape
+    static std::string quoteIdentifier(std::string_view identifier)
+    {
+        std::string quoted;
+        quoted.reserve(identifier.size() + 2);
+        quoted.push_back('"');
+        for (char character : identifier)
+        {
+            if (character == '"')
+            {
+                quoted.push_back('"');
+            }
+            quoted.push_back(character);
+        }
+        quoted.push_back('"');
+        return quoted;
+    }
+
+    // quote a string constant, for the few spots where a name has to be passed as a value in the statement shape
+    static std::string quoteLiteral(std::string_view literal)
+    {
+        std::string quoted;
+        quoted.reserve(literal.size() + 2);
+        quoted.push_back('\'');
+        for (char character : literal)
+        {
+            if (character == '\'')
+            {
+                quoted.push_back('\'');
+            }
+            quoted.push_back(character);
+        }
+        quoted.push_back('\'');
+        return quoted;
+    }
+
+    static std::string placeholder(std::size_t index) { return fmt::format("${}", index); }
+
+    // JSON pass-through wrappers, Postgres builds the json text and the server forwards it untouched.
+
+    // one text column holding the first row as a json object, no row if the statement yields none
+    [[nodiscard]] PreparedStatement asJsonObject() const
+    {
+        return PreparedStatement(fmt::format("SELECT row_to_json(q)::text FROM ({}) q LIMIT 1;", body()), Params(params));
+    }
+
+    // one text column holding all rows as a json array
+    [[nodiscard]] PreparedStatement asJsonArray() const
+    {
+        return PreparedStatement(fmt::format("SELECT COALESCE(json_agg(row_to_json(q)), '[]'::json)::text FROM ({}) q;", body()), Params(params));
+    }
+
+    // same as asJsonArray for INSERT/UPDATE/DELETE ... RETURNING, those may only be nested in a WITH clause
+    [[nodiscard]] PreparedStatement asJsonReturning() const
+    {
+        return PreparedStatement(
+            fmt::format("WITH q AS ({}) SELECT COALESCE(json_agg(row_to_json(q)), '[]'::json)::text AS rows FROM q;", body()), Params(params));
+    }
+
+    // a boolean telling whether the statement yielded more than limit rows and a text column holding the first limit rows.
+    // A CTE scan does not keep the order of the statement, the rows are sorted by order again
+    [[nodiscard]] PreparedStatement asJsonPage(std::size_t limit) const
+    {
+        Params page_params = params;
+        page_params.emplace_back(std::to_string(limit));
+        std::string limit_placeholder = placeholder(page_params.size());
+
+        return PreparedStatement(fmt::format("WITH q AS MATERIALIZED ({0}) SELECT (SELECT count(*) FROM q) > {1}, "
+                                             "COALESCE((SELECT json_agg(row_to_json(p){2}) FROM (SELECT * FROM q{2} LIMIT {1}) p), '[]'::json)::text;",
+                                     body(), limit_placeholder, orderClause()),
+            std::move(page_params));
+    }
+
+    // asJsonPage plus the given column and the id of the last row of the page as text, the position the next page seeks past
+    [[nodiscard]] PreparedStatement asJsonSeekPage(std::size_t limit, std::string_view column) const
+    {
+        Params page_params = params;
+        page_params.emplace_back(std::to_string(limit));
+        std::string limit_placeholder = placeholder(page_params.size());
+
+        return PreparedStatement(fmt::format("WITH q AS MATERIALIZED ({0}) SELECT (SELECT count(*) FROM q) > {1}, "
+                                             "COALESCE((SELECT json_agg(row_to_json(p){3}) FROM (SELECT * FROM q{3} LIMIT {1}) p), '[]'::json)::text, "
+                                             "(SELECT {2}::text FROM q{3} OFFSET GREATEST({1}::bigint - 1, 0) LIMIT 1), "
+                                             "(SELECT id::text FROM q{3} OFFSET GREATEST({1}::bigint - 1, 0) LIMIT 1);",
+                                     body(), limit_placeholder, quoteIdentifier(column), orderClause()),
+            std::move(page_params));
+    }
+
+    // the statement without its trailing semicolon so it can be nested, its placeholders keep their numbers
+    [[nodiscard]] std::string_view body() const
+    {
+        std::string_view text = sql;
+        while (!text.empty() && (text.back() == ';' || text.back() == ' '))
+        {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+   private:
+    [[nodiscard]] std::string orderClause() const { return order.empty() ? "" : fmt::format(" ORDER BY {}", order); }
+
+    static std::string makeName(std::string_view sql) { return fmt::format("ps_{:016x}", XXH3_64bits(sql.data(), sql.size())); }
+};
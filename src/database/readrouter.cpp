@@ -0,0 +1,99 @@
+#include "database/readrouter.hpp"
+
+#include <fmt/core.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "configurator/configurator.hpp"
+#include "store/store.hpp"
+
+thread_local std::optional<std::string> ReadRouter::client_;
+
+ReadRouter::ReadRouter()
+    : replicas_(!Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().replica_hosts.empty()),
+      window_(Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().read_your_writes)
+{
+}
+
+ReadRouter::Scope::Scope(const api::v2::Requester &requester) : previous_(std::move(client_))
+{
+    client_ = fmt::format("{}:{}", requester.getGroup(), requester.getId());
+}
+
+ReadRouter::Scope::~Scope() { client_ = std::move(previous_); }
+
+void ReadRouter::noteWrite()
+{
+    if (!client_.has_value())
+    {
+        return;
+    }
+
+    TimePoint now   = Clock::now();
+    TimePoint end   = now + window_;
+    Shard    &shard = shardOf(client_.value());
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.writers.size() >= MAX_WRITERS_PER_SHARD)
+        {
+            std::erase_if(shard.writers, [now](const auto &writer) { return writer.second <= now; });
+        }
+        if (shard.writers.size() < MAX_WRITERS_PER_SHARD || shard.writers.contains(client_.value()))
+        {
+            shard.writers.insert_or_assign(client_.value(), end);
+        }
+    }
+
+    // a failed exchange reloads latest, stop once a later window is already published
+    Clock::rep latest = lastWindowEnd_.load(std::memory_order_relaxed);
+    Clock::rep ends   = end.time_since_epoch().count();
+    while (latest < ends && !lastWindowEnd_.compare_exchange_weak(latest, ends, std::memory_order_release))
+    {
+    }
+}
+
+bool ReadRouter::mayReadFromReplica()
+{
+    if (!replicas_)
+    {
+        return false;
+    }
+
+    return !inWriteWindow();
+}
+
+bool ReadRouter::inWriteWindow()
+{
+    // reads outside of a request have no client to keep consistent with
+    return client_.has_value() && wroteRecently(client_.value());
+}
+
+ReadRouter::Shard &ReadRouter::shardOf(const std::string &client) { return shards_[std::hash<std::string>{}(client) % shards_.size()]; }
+
+bool ReadRouter::wroteRecently(const std::string &client)
+{
+    TimePoint now = Clock::now();
+
+    // nobody wrote within the window, there is nothing to look up
+    if (lastWindowEnd_.load(std::memory_order_acquire) <= now.time_since_epoch().count())
+    {
+        return false;
+    }
+
+    Shard                      &shard = shardOf(client);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto                        writer = shard.writers.find(client);
+    if (writer == shard.writers.end())
+    {
+        return false;
+    }
+    if (writer->second <= now)
+    {
+        shard.writers.erase(writer);
+        return false;
+    }
+    return true;
+}
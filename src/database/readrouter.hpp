@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "utils/global/requester.hpp"
+
+/// Decides whether a read may be served by a replica or shared with identical reads in flight.
+/// Writes are remembered per client for the read-your-writes window, reads of that
+/// client stay on the primary and run on their own until the window has passed so they
+/// see their own writes.
+/// The client is taken from the Scope opened by the request on the calling thread.
+/// The writers are spread over independently locked shards, a read only locks the shard
+/// of its own client, and none at all while nobody has written within the window.
+class ReadRouter
+{
+   public:
+    ReadRouter();
+    ReadRouter(const ReadRouter &)            = delete;
+    ReadRouter(ReadRouter &&)                 = delete;
+    ReadRouter &operator=(const ReadRouter &) = delete;
+    ReadRouter &operator=(ReadRouter &&)      = delete;
+    virtual ~ReadRouter()                     = default;
+
+    // binds the requester to the calling thread for the lifetime of the scope
+    class Scope
+    {
+       public:
+        explicit Scope(const api::v2::Requester &requester);
+        Scope(const Scope &)            = delete;
+        Scope(Scope &&)                 = delete;
+        Scope &operator=(const Scope &) = delete;
+        Scope &operator=(Scope &&)      = delete;
+        virtual ~Scope();
+
+       private:
+        std::optional<std::string> previous_;
+    };
+
+    void               noteWrite();
+    [[nodiscard]] bool mayReadFromReplica();
+    // the client of the calling thread wrote within the window, a read started before may miss that write
+    [[nodiscard]] bool inWriteWindow();
+
+   private:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    struct Shard
+    {
+        std::mutex                                 mutex;
+        std::unordered_map<std::string, TimePoint> writers;  // client -> end of its window
+    };
+
+    [[nodiscard]] Shard &shardOf(const std::string &client);
+    [[nodiscard]] bool   wroteRecently(const std::string &client);
+
+    static thread_local std::optional<std::string> client_;
+
+    bool                    replicas_;
+    std::chrono::seconds    window_;
+    std::atomic<Clock::rep> lastWindowEnd_{0};  // end of the latest window of any client
+    std::array<Shard, 64>   shards_;
+
+    static constexpr std::size_t MAX_WRITERS_PER_SHARD = 100000 / 64;
+};
@@ -0,0 +1,134 @@
+#include "database/replicaconnectionpool.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "configurator/configurator.hpp"
+#include "store/store.hpp"
+#include "utils/message/message.hpp"
+
+namespace
+{
+    std::vector<std::string> replicaHosts()
+    {
+        const auto &hosts = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().replica_hosts;
+
+        std::vector<std::string> sorted(hosts.begin(), hosts.end());
+        std::ranges::sort(sorted);
+        return sorted;
+    }
+}  // namespace
+
+ReplicaConnectionPool::ReplicaConnectionPool()
+    : DatabaseConnectionPool(replicaHosts()), maxLag_(Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().replica_max_lag)
+{
+    for (auto &host : replicaHosts())
+    {
+        auto replica  = std::make_unique<Replica>();
+        replica->host = std::move(host);
+        replica->healthy.store(measure(*replica));
+        replicas_.push_back(std::move(replica));
+    }
+
+    monitorThread_ = std::thread(&ReplicaConnectionPool::monitor, this);
+}
+
+ReplicaConnectionPool::~ReplicaConnectionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex_);
+        stopMonitor_ = true;
+    }
+    monitorCv_.notify_all();
+
+    if (monitorThread_.joinable())
+    {
+        monitorThread_.join();
+    }
+}
+
+bool ReplicaConnectionPool::isHealthy(const std::string &host) const
+{
+    auto replica = std::ranges::find_if(replicas_, [&host](const auto &entry) { return entry->host == host; });
+    return replica != replicas_.end() && (*replica)->healthy.load();
+}
+
+std::optional<std::string> ReplicaConnectionPool::pickHealthyHost()
+{
+    std::size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < replicas_.size(); ++i)
+    {
+        const auto &replica = replicas_[(start + i) % replicas_.size()];
+        if (replica->healthy.load())
+        {
+            return replica->host;
+        }
+    }
+    return std::nullopt;
+}
+
+bool ReplicaConnectionPool::measure(Replica &replica)
+{
+    try
+    {
+        if (replica.probe == nullptr || !replica.probe->is_open())
+        {
+            const Configurator::DatabaseConfig &config = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>();
+
+            replica.probe = std::make_unique<pqxx::connection>(
+                fmt::format("host={} dbname={} user={} password={} connect_timeout={}", replica.host, config.name, config.user, config.pass, TIMEOUT));
+        }
+
+        pqxx::nontransaction ntxn(*replica.probe);
+
+        // an idle primary does not replay anything, so a replica that has replayed all it received is not lagging
+        auto lag = ntxn.query_value<double>(
+            "SELECT CASE WHEN NOT pg_is_in_recovery() OR pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+            "ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) * 1000, 0) END;");
+
+        return lag <= static_cast<double>(maxLag_.count());
+    }
+    catch (const std::exception &e)
+    {
+        Message::WarningMessage(fmt::format("Replica {} could not be probed: {}", replica.host, e.what()));
+        replica.probe.reset();
+        return false;
+    }
+}
+
+void ReplicaConnectionPool::monitor()
+{
+    while (!stopMonitor_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(monitorMutex_);
+            monitorCv_.wait_for(lock, std::chrono::seconds(CHECK_INTERVAL_S), [this] { return stopMonitor_.load(); });
+        }
+
+        for (auto &replica : replicas_)
+        {
+            if (stopMonitor_)
+            {
+                break;
+            }
+
+            bool healthy = measure(*replica);
+
+            if (replica->healthy.exchange(healthy) != healthy)
+            {
+                Message::WarningMessage(fmt::format("Replica {} is now {}.", replica->host, healthy ? "serving reads" : "bypassed, reads go to the primary"));
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "database/databaseconnectionpool.hpp"
+
+/// Pool of connections to the read replicas listed in DB_REPLICA_HOSTS.
+/// A monitor thread measures the replication lag of every replica over its own probe
+/// connection; replicas lagging more than DB_REPLICA_MAX_LAG, or unreachable, are
+/// reported unhealthy and reads meant for them go to the primary instead.
+class ReplicaConnectionPool : public DatabaseConnectionPool
+{
+   public:
+    ReplicaConnectionPool();
+    ReplicaConnectionPool(const ReplicaConnectionPool &)            = delete;
+    ReplicaConnectionPool(ReplicaConnectionPool &&)                 = delete;
+    ReplicaConnectionPool &operator=(const ReplicaConnectionPool &) = delete;
+    ReplicaConnectionPool &operator=(ReplicaConnectionPool &&)      = delete;
+    ~ReplicaConnectionPool() override;
+
+    [[nodiscard]] bool isHealthy(const std::string &host) const;
+
+    // a healthy replica, round robin, nullopt if all of them lag behind
+    [[nodiscard]] std::optional<std::string> pickHealthyHost();
+
+   private:
+    struct Replica
+    {
+        std::string                       host;
+        std::atomic<bool>                 healthy{false};
+        std::unique_ptr<pqxx::connection> probe;
+    };
+
+    void monitor();
+    bool measure(Replica &replica);
+
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::chrono::milliseconds             maxLag_;
+    std::atomic<std::size_t>              next_{0};
+
+    std::atomic<bool>       stopMonitor_{false};
+    std::mutex              monitorMutex_;
+    std::condition_variable monitorCv_;
+    std::thread             monitorThread_;
+
+    static constexpr std::uint16_t CHECK_INTERVAL_S = 1;
+    static constexpr std::uint16_t TIMEOUT          = 2;
+};
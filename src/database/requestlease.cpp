@@ -0,0 +1,77 @@
+#include "database/requestlease.hpp"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "database/database.hpp"
+#include "database/databaseconnectionpool.hpp"
+#include "database/databasehandler.hpp"
+#include "store/store.hpp"
+
+thread_local std::shared_ptr<RequestLease> RequestLease::current_;
+
+RequestLease::RequestLease(bool transactional) : transactional_(transactional) {}
+
+RequestLease::~RequestLease() { finish(false); }
+
+RequestLease::Scope::Scope(std::shared_ptr<RequestLease> lease) : lease_(std::move(lease)), previous_(std::move(current_)) { current_ = lease_; }
+
+RequestLease::Scope::~Scope() { current_ = std::move(previous_); }
+
+std::shared_ptr<RequestLease> RequestLease::current() { return current_; }
+
+bool RequestLease::inTransaction() { return current_ != nullptr && current_->transactional_; }
+
+std::shared_ptr<Database> RequestLease::connection()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (finished_)
+    {
+        failed_ = transactional_;
+        return nullptr;
+    }
+
+    if (handler_ == nullptr)
+    {
+        // leased straight from the pool, a plain DatabaseHanndler would come back here
+        handler_ = std::make_unique<DatabaseHanndler>(Store::getObject<DatabaseConnectionPool>());
+
+        std::shared_ptr<Database> database = handler_->get_connection();
+        if (database == nullptr || (transactional_ && !database->beginRequestTransaction()))
+        {
+            handler_.reset();
+            failed_ = transactional_;
+            return nullptr;
+        }
+    }
+
+    return handler_->get_connection();
+}
+
+bool RequestLease::finish(bool commit)
+{
+    std::unique_ptr<DatabaseHanndler> handler;
+    bool                              failed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (finished_)
+        {
+            return true;
+        }
+        finished_ = true;
+        failed    = failed_;
+        handler   = std::move(handler_);
+    }
+
+    if (handler == nullptr || !transactional_)
+    {
+        return !failed;
+    }
+
+    // the handler hands the connection back to the pool once the transaction is closed,
+    // a query that missed the transaction leaves the request half done, so it is rolled back
+    return handler->get_connection()->endRequestTransaction(commit && !failed) && !failed;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+class Database;
+class DatabaseHanndler;
+
+/// One pool connection shared by every blocking query of a request.
+/// The connection is leased on the first query and handed back when the request is done, so
+/// the permission check and the final statement no longer lease one each. A
+/// transactional lease runs the whole request in one transaction, committed only if the
+/// request succeeds; while it is open the queries of the request bypass the async
+/// connections, read replicas, caches and shared in-flight reads so they all see the transaction.
+/// A plain lease only serves the blocking queries, those sent on the loop's async connection are not part of it.
+/// The lease is finished by the response, continuations that run after dispatching re-enter it with bind.
+class RequestLease
+{
+   public:
+    explicit RequestLease(bool transactional);
+    RequestLease(const RequestLease &)            = delete;
+    RequestLease(RequestLease &&)                 = delete;
+    RequestLease &operator=(const RequestLease &) = delete;
+    RequestLease &operator=(RequestLease &&)      = delete;
+    virtual ~RequestLease();
+
+    // binds the lease to the calling thread for the lifetime of the scope. Ending the scope does not finish the lease,
+    // a continuation answering later still finds the transaction open
+    class Scope
+    {
+       public:
+        explicit Scope(std::shared_ptr<RequestLease> lease);
+        Scope(const Scope &)            = delete;
+        Scope(Scope &&)                 = delete;
+        Scope &operator=(const Scope &) = delete;
+        Scope &operator=(Scope &&)      = delete;
+        virtual ~Scope();
+
+       private:
+        std::shared_ptr<RequestLease> lease_;
+        std::shared_ptr<RequestLease> previous_;
+    };
+
+    // the lease of the request handled by the calling thread, nullptr if there is none
+    static std::shared_ptr<RequestLease> current();
+    // whether the calling thread runs inside a request transaction
+    static bool inTransaction();
+
+    // wraps func so it runs with the lease of the calling thread bound, for callbacks that run after this frame is gone
+    template <typename Func>
+    static auto bind(Func &&func)
+    {
+        return [lease = current(), func = std::forward<Func>(func)](auto &&...args) mutable
+        {
+            Scope scope(lease);
+            return func(std::forward<decltype(args)>(args)...);
+        };
+    }
+
+    // leases the connection on first use, nullptr once the lease is finished or if the pool has none.
+    // A transactional lease that cannot hand out its connection is failed, it rolls back when finished
+    std::shared_ptr<Database> connection();
+
+    // commits (or rolls back) the transaction and hands the connection back, later calls do nothing.
+    // Returns false if the commit failed or the lease failed before.
+    bool finish(bool commit);
+
+    [[nodiscard]] bool transactional() const { return transactional_; }
+
+   private:
+    static thread_local std::shared_ptr<RequestLease> current_;
+
+    const bool                        transactional_;
+    bool                              finished_ = false;
+    bool                              failed_   = false;  // a query of the transaction found no connection to run on
+    std::mutex                        mutex_;
+    std::unique_ptr<DatabaseHanndler> handler_;
+};
@@ -0,0 +1,489 @@
+#include "database/resultdecoder.hpp"
+
+#include <fmt/core.h>
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <jsoncons/json.hpp>
+#include <memory>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // pg_type OIDs
+    constexpr std::uint32_t BOOL        = 16;
+    constexpr std::uint32_t INT8        = 20;
+    constexpr std::uint32_t INT2        = 21;
+    constexpr std::uint32_t INT4        = 23;
+    constexpr std::uint32_t OID         = 26;
+    constexpr std::uint32_t JSON        = 114;
+    constexpr std::uint32_t FLOAT4      = 700;
+    constexpr std::uint32_t FLOAT8      = 701;
+    constexpr std::uint32_t NUMERIC     = 1700;
+    constexpr std::uint32_t JSONB       = 3802;
+    constexpr std::uint32_t BOOL_ARR    = 1000;
+    constexpr std::uint32_t INT2_ARR    = 1005;
+    constexpr std::uint32_t INT4_ARR    = 1007;
+    constexpr std::uint32_t TEXT_ARR    = 1009;
+    constexpr std::uint32_t BPCHAR_ARR  = 1014;
+    constexpr std::uint32_t VARCHAR_ARR = 1015;
+    constexpr std::uint32_t INT8_ARR    = 1016;
+    constexpr std::uint32_t FLOAT4_ARR  = 1021;
+    constexpr std::uint32_t FLOAT8_ARR  = 1022;
+    constexpr std::uint32_t TS_ARR      = 1115;
+    constexpr std::uint32_t DATE_ARR    = 1182;
+    constexpr std::uint32_t TSTZ_ARR    = 1185;
+    constexpr std::uint32_t NUMERIC_ARR = 1231;
+    constexpr std::uint32_t UUID_ARR    = 2951;
+    constexpr std::uint32_t JSON_ARR    = 199;
+    constexpr std::uint32_t JSONB_ARR   = 3807;
+
+    // Postgres prints NaN and the infinities as words, json has no representation for them
+    bool isFinite(std::string_view value) { return !value.empty() && (value[0] == '-' || (value[0] >= '0' && value[0] <= '9')) && value != "-Infinity"; }
+}  // namespace
+
+ResultDecoder::ResultDecoder(pqxx::result result) : pqxx_result_(std::move(result)), rows_(pqxx_result_->size())
+{
+    plan(static_cast<std::size_t>(pqxx_result_->columns()));
+}
+
+ResultDecoder::ResultDecoder(std::shared_ptr<PGresult> result) : pg_result_(std::move(result))
+{
+    rows_ = static_cast<std::size_t>(PQntuples(pg_result_.get()));
+    plan(static_cast<std::size_t>(PQnfields(pg_result_.get())));
+}
+
+void ResultDecoder::plan(std::size_t columns)
+{
+    columns_.reserve(columns);
+
+    for (std::size_t column = 0; column < columns; ++column)
+    {
+        Column plan{.name = std::string(columnName(column)), .key = {}, .kind = Kind::TEXT, .element = Kind::TEXT};
+        plan.kind = kindOf(columnType(column), plan.element);
+        writeString(plan.key, plan.name);
+        plan.key.push_back(':');
+        columns_.push_back(std::move(plan));
+    }
+}
+
+std::optional<std::string_view> ResultDecoder::cell(std::size_t row, std::size_t column) const
+{
+    if (pg_result_ != nullptr)
+    {
+        int pg_row    = static_cast<int>(row);
+        int pg_column = static_cast<int>(column);
+
+        if (PQgetisnull(pg_result_.get(), pg_row, pg_column) != 0)
+        {
+            return std::nullopt;
+        }
+        return std::string_view(PQgetvalue(pg_result_.get(), pg_row, pg_column), static_cast<std::size_t>(PQgetlength(pg_result_.get(), pg_row, pg_column)));
+    }
+
+    pqxx::field field = (*pqxx_result_)[static_cast<pqxx::result::size_type>(row)][static_cast<pqxx::row::size_type>(column)];
+
+    if (field.is_null())
+    {
+        return std::nullopt;
+    }
+    return field.view();
+}
+
+std::optional<std::size_t> ResultDecoder::columnIndex(std::string_view name) const
+{
+    for (std::size_t column = 0; column < columns_.size(); ++column)
+    {
+        if (columns_[column].name == name)
+        {
+            return column;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view ResultDecoder::columnName(std::size_t column) const
+{
+    if (pg_result_ != nullptr)
+    {
+        return PQfname(pg_result_.get(), static_cast<int>(column));
+    }
+    return pqxx_result_->column_name(static_cast<pqxx::row::size_type>(column));
+}
+
+std::uint32_t ResultDecoder::columnType(std::size_t column) const
+{
+    if (pg_result_ != nullptr)
+    {
+        return PQftype(pg_result_.get(), static_cast<int>(column));
+    }
+    return pqxx_result_->column_type(static_cast<pqxx::row::size_type>(column));
+}
+
+ResultDecoder::Kind ResultDecoder::kindOf(std::uint32_t oid, Kind &element)
+{
+    element = Kind::TEXT;
+
+    switch (oid)
+    {
+        case BOOL:
+            return Kind::BOOLEAN;
+
+        case INT2:
+        case INT4:
+        case INT8:
+        case OID:
+            return Kind::INTEGER;
+
+        case FLOAT4:
+        case FLOAT8:
+            return Kind::FLOAT;
+
+        case NUMERIC:
+            return Kind::NUMERIC;
+
+        case JSON:
+        case JSONB:
+            return Kind::JSON;
+
+        case BOOL_ARR:
+            element = Kind::BOOLEAN;
+            return Kind::ARRAY;
+
+        case INT2_ARR:
+        case INT4_ARR:
+        case INT8_ARR:
+            element = Kind::INTEGER;
+            return Kind::ARRAY;
+
+        case FLOAT4_ARR:
+        case FLOAT8_ARR:
+            element = Kind::FLOAT;
+            return Kind::ARRAY;
+
+        case NUMERIC_ARR:
+            element = Kind::NUMERIC;
+            return Kind::ARRAY;
+
+        case JSON_ARR:
+        case JSONB_ARR:
+            element = Kind::JSON;
+            return Kind::ARRAY;
+
+        case TEXT_ARR:
+        case BPCHAR_ARR:
+        case VARCHAR_ARR:
+        case TS_ARR:
+        case DATE_ARR:
+        case TSTZ_ARR:
+        case UUID_ARR:
+            return Kind::ARRAY;
+
+        // text, varchar, bpchar, uuid, date, time, timestamp(tz) and anything unknown keep the Postgres text form
+        default:
+            return Kind::TEXT;
+    }
+}
+
+jsoncons::json ResultDecoder::rowToJson(std::size_t row) const
+{
+    jsoncons::json object(jsoncons::json_object_arg);
+    object.reserve(columns_.size());
+
+    for (std::size_t column = 0; column < columns_.size(); ++column)
+    {
+        const Column                   &plan  = columns_[column];
+        std::optional<std::string_view> value = cell(row, column);
+
+        object.insert_or_assign(plan.name, value.has_value() ? toJson(plan.kind, plan.element, value.value()) : jsoncons::json::null());
+    }
+    return object;
+}
+
+jsoncons::json ResultDecoder::toJson(Kind kind, Kind element, std::string_view value)
+{
+    switch (kind)
+    {
+        case Kind::BOOLEAN:
+            return jsoncons::json(value == "t");
+
+        case Kind::INTEGER:
+        {
+            std::int64_t number = 0;
+            auto [ptr, ec]      = std::from_chars(value.data(), value.data() + value.size(), number);
+            if (ec == std::errc() && ptr == value.data() + value.size())
+            {
+                return jsoncons::json(number);
+            }
+            return jsoncons::json(jsoncons::json::string_view_type(value.data(), value.size()));
+        }
+
+        case Kind::FLOAT:
+        {
+            double number  = 0;
+            auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+            if (isFinite(value) && ec == std::errc() && ptr == value.data() + value.size())
+            {
+                return jsoncons::json(number);
+            }
+            return jsoncons::json(jsoncons::json::string_view_type(value.data(), value.size()));
+        }
+
+        case Kind::NUMERIC:
+            // keep the exact decimal digits, the encoder writes bigdec strings as json numbers
+            if (isFinite(value))
+            {
+                return jsoncons::json(jsoncons::json::string_view_type(value.data(), value.size()), jsoncons::semantic_tag::bigdec);
+            }
+            return jsoncons::json(jsoncons::json::string_view_type(value.data(), value.size()));
+
+        case Kind::JSON:
+            return jsoncons::json::parse(value);
+
+        case Kind::ARRAY:
+        {
+            std::vector<std::optional<std::string>> elements;
+            if (!splitArray(value, elements))
+            {
+                return jsoncons::json(jsoncons::json::string_view_type(value.data(), value.size()));
+            }
+
+            jsoncons::json array(jsoncons::json_array_arg);
+            array.reserve(elements.size());
+            for (const auto &item : elements)
+            {
+                array.push_back(item.has_value() ? toJson(element, Kind::TEXT, item.value()) : jsoncons::json::null());
+            }
+            return array;
+        }
+
+        case Kind::TEXT:
+        default:
+            return jsoncons::json(jsoncons::json::string_view_type(value.data(), value.size()));
+    }
+}
+
+void ResultDecoder::writeRows(std::string &out, std::size_t max_rows) const
+{
+    std::size_t count = std::min(rows_, max_rows);
+
+    out.push_back('[');
+    for (std::size_t row = 0; row < count; ++row)
+    {
+        if (row != 0)
+        {
+            out.push_back(',');
+        }
+        writeRow(out, row);
+    }
+    out.push_back(']');
+}
+
+void ResultDecoder::writeRow(std::string &out, std::size_t row) const
+{
+    out.push_back('{');
+    for (std::size_t column = 0; column < columns_.size(); ++column)
+    {
+        const Column &plan = columns_[column];
+
+        if (column != 0)
+        {
+            out.push_back(',');
+        }
+        out.append(plan.key);
+
+        std::optional<std::string_view> value = cell(row, column);
+        if (!value.has_value())
+        {
+            out.append("null");
+            continue;
+        }
+        write(out, plan.kind, plan.element, value.value());
+    }
+    out.push_back('}');
+}
+
+void ResultDecoder::write(std::string &out, Kind kind, Kind element, std::string_view value)
+{
+    switch (kind)
+    {
+        case Kind::BOOLEAN:
+            out.append(value == "t" ? "true" : "false");
+            return;
+
+        case Kind::INTEGER:
+        case Kind::FLOAT:
+        case Kind::NUMERIC:
+            if (isFinite(value))
+            {
+                out.append(value);
+                return;
+            }
+            writeString(out, value);
+            return;
+
+        case Kind::JSON:
+            // Postgres already produced valid json text
+            out.append(value);
+            return;
+
+        case Kind::ARRAY:
+        {
+            std::vector<std::optional<std::string>> elements;
+            if (!splitArray(value, elements))
+            {
+                writeString(out, value);
+                return;
+            }
+
+            out.push_back('[');
+            for (std::size_t index = 0; index < elements.size(); ++index)
+            {
+                if (index != 0)
+                {
+                    out.push_back(',');
+                }
+                if (elements[index].has_value())
+                {
+                    write(out, element, Kind::TEXT, elements[index].value());
+                }
+                else
+                {
+                    out.append("null");
+                }
+            }
+            out.push_back(']');
+            return;
+        }
+
+        case Kind::TEXT:
+        default:
+            writeString(out, value);
+            return;
+    }
+}
+
+void ResultDecoder::writeString(std::string &out, std::string_view value)
+{
+    out.push_back('"');
+    for (char character : value)
+    {
+        switch (character)
+        {
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            case '\r':
+                out.append("\\r");
+                break;
+            case '\t':
+                out.append("\\t");
+                break;
+            case '\b':
+                out.append("\\b");
+                break;
+            case '\f':
+                out.append("\\f");
+                break;
+            default:
+                if (static_cast<unsigned char>(character) < 0x20)
+                {
+                    out.append(fmt::format("\\u{:04x}", static_cast<unsigned int>(character)));
+                }
+                else
+                {
+                    out.push_back(character);
+                }
+                break;
+        }
+    }
+    out.push_back('"');
+}
+
+bool ResultDecoder::splitArray(std::string_view value, std::vector<std::optional<std::string>> &elements)
+{
+    // only plain one dimensional literals like {1,2,NULL} or {"a b","c\"d"}
+    if (value.size() < 2 || value.front() != '{' || value.back() != '}')
+    {
+        return false;
+    }
+
+    std::string_view body = value.substr(1, value.size() - 2);
+    if (body.empty())
+    {
+        return true;
+    }
+
+    std::size_t position = 0;
+    while (position <= body.size())
+    {
+        std::string item;
+        bool        quoted = false;
+
+        if (position < body.size() && body[position] == '{')
+        {
+            return false;  // nested array
+        }
+
+        if (position < body.size() && body[position] == '"')
+        {
+            quoted = true;
+            ++position;
+            while (position < body.size() && body[position] != '"')
+            {
+                if (body[position] == '\\' && position + 1 < body.size())
+                {
+                    ++position;
+                }
+                item.push_back(body[position++]);
+            }
+            if (position >= body.size())
+            {
+                return false;
+            }
+            ++position;  // closing quote
+        }
+        else
+        {
+            while (position < body.size() && body[position] != ',')
+            {
+                item.push_back(body[position++]);
+            }
+        }
+
+        if (!quoted && item == "NULL")
+        {
+            elements.emplace_back(std::nullopt);
+        }
+        else
+        {
+            elements.emplace_back(std::move(item));
+        }
+
+        if (position == body.size())
+        {
+            break;
+        }
+        if (body[position] != ',')
+        {
+            return false;
+        }
+        ++position;
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <libpq-fe.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <jsoncons/json.hpp>
+#include <memory>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Converts a query result into json.
+/// The column plan (names and a converter per column type) is computed once per
+/// result, rows are then converted without looking at the column OIDs again.
+/// Besides building a jsoncons DOM the decoder can write rows straight into a
+/// json text buffer, in which case json/jsonb columns are copied verbatim.
+class ResultDecoder
+{
+   public:
+    explicit ResultDecoder(pqxx::result result);
+    explicit ResultDecoder(std::shared_ptr<PGresult> result);
+    ResultDecoder(const ResultDecoder &)            = default;
+    ResultDecoder(ResultDecoder &&)                 = default;
+    ResultDecoder &operator=(const ResultDecoder &) = default;
+    ResultDecoder &operator=(ResultDecoder &&)      = default;
+    virtual ~ResultDecoder()                        = default;
+
+    // jsoncons::json yields the first row as an object (empty if there is none), jsoncons::json::array yields
+    // all rows and ResultDecoder hands the decoder itself to the caller.
+    template <typename Result>
+    std::optional<Result> to() &&
+    {
+        static_assert(std::is_same_v<Result, jsoncons::json> || std::is_same_v<Result, jsoncons::json::array> || std::is_same_v<Result, ResultDecoder>,
+            "Unsupported Result specialization");
+
+        if constexpr (std::is_same_v<Result, ResultDecoder>)
+        {
+            return std::move(*this);
+        }
+        else if constexpr (std::is_same_v<Result, jsoncons::json::array>)
+        {
+            jsoncons::json::array reply;
+            reply.reserve(rows_);
+            for (std::size_t row = 0; row < rows_; ++row)
+            {
+                reply.push_back(rowToJson(row));
+            }
+            return reply;
+        }
+        else
+        {
+            return rows_ == 0 ? jsoncons::json() : rowToJson(0);
+        }
+    }
+
+    [[nodiscard]] std::size_t rows() const { return rows_; }
+
+    [[nodiscard]] jsoncons::json rowToJson(std::size_t row) const;
+
+    // raw text of a cell, nullopt for SQL NULL
+    [[nodiscard]] std::optional<std::string_view> cell(std::size_t row, std::size_t column) const;
+
+    // position of the named column, nullopt if the result has none
+    [[nodiscard]] std::optional<std::size_t> columnIndex(std::string_view name) const;
+
+    // appends up to max_rows rows as a json array
+    void writeRows(std::string &out, std::size_t max_rows) const;
+    void writeRow(std::string &out, std::size_t row) const;
+
+   private:
+    enum class Kind : std::uint8_t
+    {
+        TEXT,
+        INTEGER,
+        FLOAT,
+        NUMERIC,
+        BOOLEAN,
+        JSON,
+        ARRAY,
+    };
+
+    struct Column
+    {
+        std::string name;
+        std::string key;  // name already encoded as a json key, "name":
+        Kind        kind;
+        Kind        element;  // element kind of one dimensional arrays
+    };
+
+    void plan(std::size_t columns);
+
+    [[nodiscard]] std::string_view columnName(std::size_t column) const;
+    [[nodiscard]] std::uint32_t    columnType(std::size_t column) const;
+
+    static Kind kindOf(std::uint32_t oid, Kind &element);
+
+    static jsoncons::json toJson(Kind kind, Kind element, std::string_view value);
+    static void           write(std::string &out, Kind kind, Kind element, std::string_view value);
+    static void           writeString(std::string &out, std::string_view value);
+
+    // splits a one dimensional array literal, returns false for anything it cannot handle
+    static bool splitArray(std::string_view value, std::vector<std::optional<std::string>> &elements);
+
+    std::optional<pqxx::result> pqxx_result_;
+    std::shared_ptr<PGresult>   pg_result_;
+    std::size_t                 rows_ = 0;
+    std::vector<Column>         columns_;
+};
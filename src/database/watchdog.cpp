@@ -3,16 +3,19 @@
 #include <fmt/core.h>
 #include <fmt/format.h>
 
+#include <chrono>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <stdexcept>
 #include <thread>
 
 #include "database/database.hpp"
-#include "database/databasehandler.hpp"
+#include "database/databaseconnectionpool.hpp"
+#include "store/store.hpp"
 #include "utils/message/message.hpp"
 
-WatchDog::WatchDog()
+WatchDog::WatchDog() : pool_(Store::getObject<DatabaseConnectionPool>())
 {
     if (monitor_thread.joinable())
     {
@@ -20,53 +23,7 @@ WatchDog::WatchDog()
     }
 
     // Start the monitoring thread
-    monitor_thread = std::thread(
-        [this]()
-        {
-            while (should_monitor)
-            {
-                try
-                {
-                    std::unique_ptr<DatabaseHanndler> dbHandler = std::make_unique<DatabaseHanndler>();
-                    std::shared_ptr<Database>         db_ptr    = dbHandler->get_connection();
-
-                    if (db_ptr == nullptr)
-                    {
-                        Message::WarningMessage("WatchDog could not acquire a database connection within timeout.");
-                        std::this_thread::sleep_for(check_interval);
-                        continue;
-                    }
-
-                    if (!db_ptr->check_connection())
-                    {
-                        Message::WarningMessage("Database connection lost. Attempting to reconnect...");
-                        Message::CriticalMessage(fmt::format("Database connection {} link is lost.", static_cast<const void *>(db_ptr.get())));
-                        try
-                        {
-                            if (db_ptr->reconnect())
-                            {
-                                Message::InfoMessage(fmt::format("Database connection {} is re-established successfully", static_cast<void *>(db_ptr.get())));
-                                dbHandler->reconnect_all();
-                            }
-                            else
-                            {
-                                Message::ErrorMessage("Failed to reconnect to database");
-                            }
-                        }
-                        catch (const std::exception &e)
-                        {
-                            Message::CriticalMessage(fmt::format("Reconnect exception: {}", e.what()));
-                        }
-                    }
-
-                    std::this_thread::sleep_for(check_interval);
-                }
-                catch (const std::exception &e)
-                {
-                    Message::CriticalMessage(fmt::format("Monitoring exception: {}", e.what()));
-                }
-            }
-        });
+    monitor_thread = std::thread(&WatchDog::monitor, this);
 }
 
 WatchDog::~WatchDog()
@@ -78,3 +35,59 @@ WatchDog::~WatchDog()
         monitor_thread.join();
     }
 }
+
+bool WatchDog::probe()
+{
+    if (probe_ != nullptr && probe_->check_connection())
+    {
+        return true;
+    }
+
+    // one connection retrying, however long the outage lasts
+    if (probe_ == nullptr)
+    {
+        probe_ = pool_->open_connection();
+        return probe_ != nullptr && probe_->check_connection();
+    }
+    return probe_->reconnect();
+}
+
+void WatchDog::monitor()
+{
+    std::uint16_t checks = 0;
+
+    while (should_monitor)
+    {
+        try
+        {
+            if (!probe())
+            {
+                if (reachable_)
+                {
+                    reachable_ = false;
+                    Message::CriticalMessage("Database is unreachable, pooled connections are checked once it is back.");
+                }
+            }
+            else if (!reachable_)
+            {
+                reachable_ = true;
+                checks     = 0;
+                Message::InfoMessage("Database is reachable again, checking the idle connections.");
+                size_t swapped = pool_->validate_idle(std::chrono::milliseconds(0));
+                Message::InfoMessage(fmt::format("{} idle database connections were replaced.", swapped));
+            }
+            else if (++checks >= SWEEP_EVERY)
+            {
+                checks = 0;
+                // connections handed back since the last sweep just proved themselves
+                pool_->validate_idle(std::chrono::duration_cast<std::chrono::milliseconds>(check_interval * SWEEP_EVERY));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            Message::CriticalMessage(fmt::format("Monitoring exception: {}", e.what()));
+        }
+
+        std::this_thread::sleep_for(check_interval);
+    }
+}
@@ -2,9 +2,19 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
 #include <pqxx/pqxx>
 #include <thread>
 
+class Database;
+class DatabaseConnectionPool;
+
+/// Keeps an eye on the primary through a probe connection of its own, so it never waits on the
+/// pool nor takes a connection away from a request. While the probe answers, the idle pooled
+/// connections are validated in parallel every few checks and broken ones are swapped for fresh
+/// ones before anybody leases them. While it does not, only the probe retries, nothing else is
+/// reconnected until the database is back, and then every idle connection is checked at once.
 class WatchDog
 {
    public:
@@ -16,7 +26,16 @@ class WatchDog
     virtual ~WatchDog();
 
    private:
+    bool probe();
+    void monitor();
+
+    std::shared_ptr<DatabaseConnectionPool> pool_;
+    std::shared_ptr<Database>               probe_;
+    bool                                    reachable_ = true;
+
     std::atomic<bool>    should_monitor{true};
     std::chrono::seconds check_interval{1};
     std::thread          monitor_thread;
-};
\ No newline at end of file
+
+    static constexpr std::uint16_t SWEEP_EVERY = 10;  // checks between two sweeps of the idle connections
+};
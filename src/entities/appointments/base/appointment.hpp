@@ -1,8 +1,6 @@
 #pragma once
 #include <fmt/core.h>
 
-#include <cstdint>
-#include <optional>
 #include <string>
 
 #include "entities/base/entity.hpp"
@@ -22,18 +20,9 @@ class Appointment : public Entity
 
     ~Appointment() override = default;
 
-   protected:
-    static std::optional<std::string> getServicePermissionsQueryImpl(const std::string &service_name, std::uint64_t service_id)
+    // the permissions of many services of one table at once, bound with an array of ids and keyed by id
+    static std::string getServicePermissionsBatchQuery(const std::string &service_name)
     {
-        return fmt::format(R"(
-        SELECT
-        owner_id,
-        admin_id,
-        staff
-        FROM
-        {}
-        WHERE
-        id = {};)",
-            service_name, service_id);
+        return fmt::format("SELECT id, owner_id, admin_id, staff FROM {} WHERE id = ANY($1::bigint[]);", service_name);
     }
 };
@@ -1,7 +1,5 @@
 #pragma once
 
-#include <cstdint>
-#include <optional>
 #include <string>
 
 #include "entities/appointments/base/appointment.hpp"
@@ -28,9 +26,4 @@ class ClinicAppointment : public Appointment
     static constexpr auto getOrgName() { return ORGNAME; }
 
     ~ClinicAppointment() override = default;
-
-    static std::optional<std::string> getServicePermissionsQuery(const std::string& service_name, std::uint64_t service_id)
-    {
-        return getServicePermissionsQueryImpl(service_name, service_id);
-    }
 };
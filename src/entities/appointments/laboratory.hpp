@@ -1,7 +1,5 @@
 #pragma once
 
-#include <cstdint>
-#include <optional>
 #include <string>
 
 #include "entities/appointments/base/appointment.hpp"
@@ -26,8 +24,4 @@ class LaboratoryAppointment : public Appointment
     static constexpr auto getTableName() { return TABLENAME; }
     static constexpr auto getOrgName() { return ORGNAME; }
     ~LaboratoryAppointment() override = default;
-    static std::optional<std::string> getServicePermissionsQuery(const std::string &service_name, std::uint64_t service_id)
-    {
-        return getServicePermissionsQueryImpl(service_name, service_id);
-    }
 };
@@ -1,8 +1,6 @@
 #pragma once
 
-#include <cstdint>
 #include <jsoncons/json.hpp>
-#include <optional>
 #include <string>
 
 #include "entities/appointments/base/appointment.hpp"
@@ -28,9 +26,4 @@ class RadiologyCenterAppointment : public Appointment
     static constexpr auto getOrgName() { return ORGNAME; }
 
     ~RadiologyCenterAppointment() override = default;
-
-    static std::optional<std::string> getServicePermissionsQuery(const std::string &service_name, std::uint64_t service_id)
-    {
-        return getServicePermissionsQueryImpl(service_name, service_id);
-    }
 };
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <optional>
-#include <string>
+
+#include "database/preparedstatement.hpp"
 
 /// Base class for all entities in the application.
 /// Provides common functionality for creating, reading, updating, deleting, and
@@ -14,9 +15,9 @@ class Base
     explicit Base() = default;
     virtual ~Base() = default;
 
-    virtual std::optional<std::string> getSqlCreateStatement() = 0;
-    virtual std::optional<std::string> getSqlReadStatement()   = 0;
-    virtual std::optional<std::string> getSqlUpdateStatement() = 0;
-    virtual std::optional<std::string> getSqlDeleteStatement() = 0;
-    virtual std::optional<std::string> getSqlSearchStatement() = 0;
+    virtual std::optional<PreparedStatement> getSqlCreateStatement() = 0;
+    virtual std::optional<PreparedStatement> getSqlReadStatement()   = 0;
+    virtual std::optional<PreparedStatement> getSqlUpdateStatement() = 0;
+    virtual std::optional<PreparedStatement> getSqlDeleteStatement() = 0;
+    virtual std::optional<PreparedStatement> getSqlSearchStatement() = 0;
 };
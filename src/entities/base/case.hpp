@@ -3,9 +3,12 @@
 #include <fmt/core.h>
 
 #include <cstdint>
+#include <exception>
+#include <jsoncons/json.hpp>
 #include <optional>
 #include <string>
 
+#include "database/preparedstatement.hpp"
 #include "entities/base/entity.hpp"
 #include "utils/global/global.hpp"
 class Case : public Entity
@@ -23,7 +26,70 @@ class Case : public Entity
     static constexpr auto getOrgName() { return ORGNAME; }
     ~Case() override = default;
 
+    // the read statement of the entity fused with its read permission query, one row holding the permission columns
+    // and the requested columns as a json object in "entity", no row if the entity does not exist
+    std::optional<PreparedStatement> getSqlReadWithPermissionsStatement()
+    {
+        std::optional<PreparedStatement> read = getSqlReadStatement();
+        if (!read.has_value())
+        {
+            return std::nullopt;
+        }
+
+        return PreparedStatement(fmt::format("SELECT c.owner_id, c.admin_id, c.staff, p.id AS patient_id, p.clinic_id AS clinic_id, "
+                                             "(SELECT row_to_json(q)::text FROM ({}) q) AS entity FROM {} c JOIN {} p ON c.id = p.clinic_id "
+                                             "WHERE p.id = $1;",
+                                     read->body(), ORGNAME, tablename),
+            std::move(read->params));
+    }
+
+    // the read/update/delete permission query for many rows of tablename at once, bound with an array of ids and keyed by patient_id
+    static std::string getPermissionsBatchQuery(const std::string& tablename)
+    {
+        return fmt::format("SELECT c.owner_id, c.admin_id, c.staff, p.id AS patient_id, p.clinic_id AS clinic_id FROM {} c "
+                           "JOIN {} p ON c.id = p.clinic_id WHERE p.id = ANY($1::bigint[]);",
+            ORGNAME, tablename);
+    }
+
    protected:
+    // bound variants of the create permission queries, read asynchronously before a create
+    static std::optional<PreparedStatement> getPermissionsStatementForCreatePatientImpl(const std::optional<jsoncons::json>& data_j, const std::string& key)
+    {
+        std::optional<uint64_t> id = getCreateKeyValue(data_j, key);
+        if (!id.has_value())
+        {
+            return std::nullopt;
+        }
+        return PreparedStatement(fmt::format("SELECT owner_id, admin_id, staff FROM {} WHERE id = $1;", ORGNAME), {std::to_string(id.value())});
+    }
+
+    static std::optional<PreparedStatement> getPermissionsStatementForCreateImpl(
+        const std::optional<jsoncons::json>& data_j, const std::string& key, const std::string& tablename)
+    {
+        std::optional<uint64_t> id = getCreateKeyValue(data_j, key);
+        if (!id.has_value())
+        {
+            return std::nullopt;
+        }
+        return PreparedStatement(fmt::format("SELECT c.owner_id, c.admin_id, c.staff, p.id AS patient_id, p.clinic_id AS clinic_id FROM {} c "
+                                             "LEFT JOIN {} p ON c.id = p.clinic_id WHERE p.id = $1;",
+                                     ORGNAME, tablename),
+            {std::to_string(id.value())});
+    }
+
+    // the create permission queries for many parents at once, bound with an array of parent ids and keyed by parent_id
+    static std::string getPermissionsBatchQueryForCreatePatientImpl()
+    {
+        return fmt::format("SELECT owner_id, admin_id, staff, id AS parent_id, id AS clinic_id FROM {} WHERE id = ANY($1::bigint[]);", ORGNAME);
+    }
+
+    static std::string getPermissionsBatchQueryForCreateImpl(const std::string& tablename)
+    {
+        return fmt::format("SELECT c.owner_id, c.admin_id, c.staff, p.id AS parent_id, p.clinic_id AS clinic_id FROM {} c "
+                           "JOIN {} p ON c.id = p.clinic_id WHERE p.id = ANY($1::bigint[]);",
+            ORGNAME, tablename);
+    }
+
     static std::optional<std::string> getPermissionsQueryForCreatePatientImpl(const uint64_t id)
     {
         auto query = fmt::format(R"(
@@ -59,63 +125,17 @@ class Case : public Entity
         return query;
     }
 
-    static std::optional<std::string> getPermissionsQueryForReadImp(const uint64_t id, const std::string& tablename)
+   private:
+    static std::optional<uint64_t> getCreateKeyValue(const std::optional<jsoncons::json>& data_j, const std::string& key)
     {
-        // create and return the query
-        auto query = fmt::format(R"(
-        SELECT
-        c.owner_id,
-        c.admin_id,
-        c.staff,
-        p.id AS patient_id,
-        p.clinic_id AS clinic_id
-        FROM
-        {} c
-        LEFT JOIN {} p ON c.id = p.clinic_id
-        WHERE
-        p.id = {};)",
-            ORGNAME, tablename, id);
-        // std::cout << query << std::endl;
-        return query;
-    }
-
-    static std::optional<std::string> getPermissionsQueryForUpdateImpl(const uint64_t id, const std::string& tablename)
-    {
-        // create and return the query
-        auto query = fmt::format(R"(
-        SELECT
-        c.owner_id,
-        c.admin_id,
-        c.staff,
-        p.id AS patient_id,
-        p.clinic_id AS clinic_id
-        FROM
-        {} c
-        LEFT JOIN {} p ON c.id = p.clinic_id
-        WHERE
-        p.id = {};)",
-            ORGNAME, tablename, id);
-        // std::cout << query << std::endl;
-        return query;
-    }
-
-    static std::optional<std::string> getPermissionsQueryForDeleteImp(const uint64_t id, const std::string& tablename)
-    {
-        // create and return the query
-        auto query = fmt::format(R"(
-        SELECT
-        c.owner_id,
-        c.admin_id,
-        c.staff,
-        p.id AS patient_id,
-        p.clinic_id AS clinic_id
-        FROM
-        {} c
-        LEFT JOIN {} p ON c.id = p.clinic_id
-        WHERE
-        p.id = {};)",
-            ORGNAME, tablename, id);
-        // std::cout << query << std::endl;
-        return query;
+        try
+        {
+            return data_j->at(key).as<uint64_t>();
+        }
+        catch (const std::exception& e)
+        {
+            CRITICALMESSAGE
+            return std::nullopt;
+        }
     }
 };
@@ -12,8 +12,10 @@
 #include <optional>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "database/preparedstatement.hpp"
 #include "entities/base/entity.hpp"
 #include "entities/base/types.hpp"
 #include "fmt/format.h"
@@ -43,25 +45,31 @@ namespace api
             {
             }
 
-            std::optional<std::string> getSqlCreateStatement() final
+            std::optional<PreparedStatement> getSqlCreateStatement() final
             {
                 auto clientdata = std::get<Types::CreateClient_t>(getData());
 
                 try
                 {
-                    std::vector<std::string> keys_arr;
-                    std::vector<std::string> values_arr;
+                    // data_set is unordered, sort it so the same column set always yields the same statement
+                    std::vector<std::pair<std::string, std::string>> items(clientdata.get_data_set().begin(), clientdata.get_data_set().end());
+                    std::ranges::sort(items);
 
-                    for (const auto &item : clientdata.get_data_set())
+                    std::vector<std::string>  keys_arr;
+                    std::vector<std::string>  placeholders_arr;
+                    PreparedStatement::Params values_arr;
+
+                    for (auto &item : items)
                     {
-                        keys_arr.push_back(item.first);
-                        values_arr.push_back(item.second);
+                        keys_arr.push_back(PreparedStatement::quoteIdentifier(item.first));
+                        values_arr.emplace_back(std::move(item.second));
+                        placeholders_arr.push_back(PreparedStatement::placeholder(values_arr.size()));
                     }
 
                     std::string columns = fmt::format("{}", fmt::join(keys_arr, ","));
-                    std::string values  = fmt::format("'{}'", fmt::join(values_arr, "','"));
+                    std::string values  = fmt::format("{}", fmt::join(placeholders_arr, ","));
 
-                    return fmt::format("INSERT INTO {} ({}) VALUES ({}) RETURNING id;", tablename, columns, values);
+                    return PreparedStatement(fmt::format("INSERT INTO {} ({}) VALUES ({}) RETURNING id;", tablename, columns, values), std::move(values_arr));
                 }
                 catch (const std::exception &e)
                 {
@@ -72,10 +80,8 @@ namespace api
                 return std::nullopt;
             }
 
-            std::optional<std::string> getSqlUpdateStatement() final
+            std::optional<PreparedStatement> getSqlUpdateStatement() final
             {
-                std::optional<std::string> query;
-
                 try
                 {
                     auto clientdata = std::get<Types::UpdateClient_t>(getData()).get_data_set();
@@ -85,18 +91,25 @@ namespace api
                         Message::ErrorMessage(fmt::format("Failed to update client data. No id provided."));
                         return std::nullopt;
                     }
-                    std::string update_column_values;
 
-                    for (auto it = clientdata.begin(); it != clientdata.end(); ++it)
+                    std::vector<std::pair<std::string, std::string>> items(clientdata.begin(), clientdata.end());
+                    std::ranges::sort(items);
+
+                    std::vector<std::string>  update_column_values;
+                    PreparedStatement::Params values_arr;
+
+                    for (auto &item : items)
                     {
-                        update_column_values.append(fmt::format(" {} = '{}' ", it->first, it->second));
-                        if (std::next(it) != clientdata.end())
-                        {
-                            update_column_values.append(",");
-                        }
+                        values_arr.emplace_back(std::move(item.second));
+                        update_column_values.push_back(
+                            fmt::format("{} = {}", PreparedStatement::quoteIdentifier(item.first), PreparedStatement::placeholder(values_arr.size())));
                     }
 
-                    query = fmt::format("UPDATE {} set {} WHERE id={} returning id;", tablename, update_column_values, client_id.value());
+                    values_arr.emplace_back(std::to_string(client_id.value()));
+
+                    return PreparedStatement(fmt::format("UPDATE {} SET {} WHERE id = {} RETURNING id;", tablename, fmt::join(update_column_values, ", "),
+                                                 PreparedStatement::placeholder(values_arr.size())),
+                        std::move(values_arr));
                 }
                 catch (const std::exception &e)
                 {
@@ -104,7 +117,6 @@ namespace api
                     Message::CriticalMessage(e.what());
                     return std::nullopt;
                 }
-                return query;
             }
 
             std::optional<std::string> getSqlToggleSuspendStatement(bool state)
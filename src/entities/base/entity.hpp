@@ -3,21 +3,30 @@
 #include <fmt/core.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <exception>
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/preparedstatement.hpp"
 #include "entities/base/base.hpp"
 #include "entities/base/types.hpp"
 #include "fmt/format.h"
 #include "jsoncons/basic_json.hpp"
 #include "store/store.hpp"
+#include "utils/global/types.hpp"
 #include "utils/message/message.hpp"
+#include "validator/databaseschema/databaseschema.hpp"
 
 using EntityType = api::v2::Types::EntityType;
 using Create_t   = api::v2::Types::Create_t;
@@ -41,27 +50,28 @@ class Entity : public Base
 
     ~Entity() override = default;
 
-    std::optional<std::string> getSqlCreateStatement() override
+    std::optional<PreparedStatement> getSqlCreateStatement() override
     {
-        std::optional<std::string> query;
         try
         {
-            std::vector<std::string> keys_arr;
-            std::vector<std::string> values_arr;
+            std::vector<std::string>  keys_arr;
+            std::vector<std::string>  placeholders_arr;
+            PreparedStatement::Params values_arr;
 
             jsoncons::json data_json = std::get<Create_t>(data).get_data();
             data_json["id"]          = std::get<Create_t>(data).get_id();
 
             for (auto &iterator : data_json.object_range())
             {
-                keys_arr.push_back(iterator.key());
-                values_arr.push_back(iterator.value().as<std::string>());
+                keys_arr.push_back(PreparedStatement::quoteIdentifier(iterator.key()));
+                values_arr.push_back(toParam(iterator.value()));
+                placeholders_arr.push_back(PreparedStatement::placeholder(values_arr.size()));
             }
 
             std::string columns = fmt::format("{}", fmt::join(keys_arr, ","));
-            std::string values  = fmt::format("'{}'", fmt::join(values_arr, "','"));
+            std::string values  = fmt::format("{}", fmt::join(placeholders_arr, ","));
 
-            query = fmt::format("INSERT INTO {} ({}) VALUES ({}) RETURNING *;", tablename, columns, values);
+            return PreparedStatement(fmt::format("INSERT INTO {} ({}) VALUES ({}) RETURNING *;", tablename, columns, values), std::move(values_arr));
         }
         catch (const std::exception &e)
         {
@@ -69,24 +79,33 @@ class Entity : public Base
             Message::CriticalMessage(e.what());
             return std::nullopt;
         }
-        return query;
     };
 
-    std::optional<std::string> getSqlReadStatement() override
+    std::optional<PreparedStatement> getSqlReadStatement() override
     {
-        std::optional<std::string> query;
         try
         {
             auto user_id = std::get<Read_t>(data).get_id();
             auto schema  = std::get<Read_t>(data).get_data();
 
-            std::string columns = schema.empty() ? "*" : fmt::format("{}", fmt::join(schema, ", "));
-
             if (!user_id.has_value())
             {
                 Message::ErrorMessage(fmt::format("Failed to read data from table {}. No id provided.", tablename));
+                return std::nullopt;
+            }
+
+            // sort the requested columns so the same column set always yields the same statement
+            std::vector<std::string> columns_arr;
+            columns_arr.reserve(schema.size());
+            for (const auto &column : schema)
+            {
+                columns_arr.push_back(PreparedStatement::quoteIdentifier(column));
             }
-            query = fmt::format("SELECT {} FROM {}_safe WHERE id={} LIMIT 1;", columns, tablename, user_id.value());
+            std::ranges::sort(columns_arr);
+
+            std::string columns = columns_arr.empty() ? "*" : fmt::format("{}", fmt::join(columns_arr, ", "));
+
+            return PreparedStatement(fmt::format("SELECT {} FROM {}_safe WHERE id = $1 LIMIT 1;", columns, tablename), {std::to_string(user_id.value())});
         }
         catch (const std::exception &e)
         {
@@ -94,13 +113,10 @@ class Entity : public Base
             Message::CriticalMessage(e.what());
             return std::nullopt;
         }
-        return query;
     }
 
-    std::optional<std::string> getSqlUpdateStatement() override
+    std::optional<PreparedStatement> getSqlUpdateStatement() override
     {
-        std::optional<std::string> query;
-
         try
         {
             jsoncons::json payload = std::get<Update_t>(data).get_data();
@@ -110,20 +126,24 @@ class Entity : public Base
             if (!_id.has_value())
             {
                 Message::ErrorMessage(fmt::format("Failed to update data from table {}. No id provided.", tablename));
+                return std::nullopt;
             }
 
-            std::string update_column_values;
+            std::vector<std::string>  update_column_values;
+            PreparedStatement::Params values_arr;
 
-            for (auto it = payload.object_range().begin(); it != payload.object_range().end(); ++it)
+            for (const auto &iterator : payload.object_range())
             {
-                update_column_values.append(fmt::format(" {} = '{}' ", it->key(), it->value().as<std::string>()));
-                if (std::next(it) != payload.object_range().end())
-                {
-                    update_column_values.append(",");
-                }
+                values_arr.push_back(toParam(iterator.value()));
+                update_column_values.push_back(
+                    fmt::format("{} = {}", PreparedStatement::quoteIdentifier(iterator.key()), PreparedStatement::placeholder(values_arr.size())));
             }
 
-            query = fmt::format("UPDATE {} set {} WHERE id={} returning *;", tablename, update_column_values, _id.value());
+            values_arr.emplace_back(std::to_string(_id.value()));
+
+            return PreparedStatement(fmt::format("UPDATE {} SET {} WHERE id = {} RETURNING *;", tablename, fmt::join(update_column_values, ", "),
+                                         PreparedStatement::placeholder(values_arr.size())),
+                std::move(values_arr));
         }
         catch (const std::exception &e)
         {
@@ -131,24 +151,20 @@ class Entity : public Base
             Message::CriticalMessage(e.what());
             return std::nullopt;
         }
-        return query;
     }
 
-    std::optional<std::string> getSqlDeleteStatement() override
+    std::optional<PreparedStatement> getSqlDeleteStatement() override
     {
-        std::optional<std::string> query;
-        std::optional<uint64_t>    _id;
-
         try
         {
-            _id = std::get<Delete_t>(data).get_id();
+            std::optional<uint64_t> _id = std::get<Delete_t>(data).get_id();
             if (!_id.has_value())
             {
                 Message::ErrorMessage(fmt::format("Failed to delete data from table {}. No id provided.", tablename));
                 return std::nullopt;
             }
-            // Construct SQL query using {fmt} for parameterized query
-            query = fmt::format("DELETE FROM {} where id={} returning id;", tablename, _id.value());
+
+            return PreparedStatement(fmt::format("DELETE FROM {} WHERE id = $1 RETURNING id;", tablename), {std::to_string(_id.value())});
         }
         catch (const std::exception &e)
         {
@@ -156,19 +172,40 @@ class Entity : public Base
             Message::CriticalMessage(e.what());
             return std::nullopt;
         }
-        return query;
     }
 
-    std::optional<std::string> getSqlSearchStatement() override
+    std::optional<PreparedStatement> getSqlSearchStatement() override
     {
-        std::optional<std::string> query;
         try
         {
-            Search_t searchdata = std::get<Search_t>(getData());
-            query               = fmt::format(
-                "SELECT * FROM {}_safe WHERE {}::text ILIKE '%{}%' ORDER BY {} {} "
-                              "LIMIT {} OFFSET {};",
-                tablename, searchdata.filter, searchdata.keyword, searchdata.order_by, searchdata.direction, searchdata.limit + 1, searchdata.offset);
+            const Search_t &searchdata = std::get<Search_t>(getData());
+
+            if (searchdata.keyset)
+            {
+                return getSqlKeysetSearchStatement(searchdata);
+            }
+
+            // filter, order_by and the match mode are part of the statement shape, keyword, limit and offset are bound
+            PreparedStatement::Params params;
+            std::string               condition = getSearchCondition(searchdata, params);
+            std::string               order     = fmt::format("{} {}", PreparedStatement::quoteIdentifier(searchdata.order_by), searchdata.direction);
+
+            if (!searchdata.filter.empty() && getSearchMatch(searchdata) == Search_t::Match::TRIGRAM)
+            {
+                params.emplace_back(searchdata.keyword);
+                order = fmt::format("similarity({}, {}) DESC, id", PreparedStatement::quoteIdentifier(searchdata.filter),
+                    PreparedStatement::placeholder(params.size()));
+            }
+
+            params.emplace_back(std::to_string(searchdata.limit + 1));
+            std::string limit = PreparedStatement::placeholder(params.size());
+            params.emplace_back(std::to_string(searchdata.offset));
+            std::string offset = PreparedStatement::placeholder(params.size());
+
+            PreparedStatement statement(
+                fmt::format("SELECT * FROM {}_safe WHERE {} ORDER BY {} LIMIT {} OFFSET {};", tablename, condition, order, limit, offset), std::move(params));
+            statement.order = std::move(order);
+            return statement;
         }
         catch (const std::exception &e)
         {
@@ -176,8 +213,175 @@ class Entity : public Base
             Message::CriticalMessage(e.what());
             return std::nullopt;
         }
+    }
+
+    // The total of a search regardless of its page. The count statement stops reading after limit rows, the
+    // estimate statement yields the planner row estimate of the same condition as EXPLAIN (FORMAT JSON) output.
+    [[nodiscard]] std::optional<PreparedStatement> getSqlSearchCountStatement(size_t limit) const
+    {
+        try
+        {
+            PreparedStatement::Params params;
+            std::string               condition = getSearchCondition(std::get<Search_t>(getData()), params);
+            params.emplace_back(std::to_string(limit));
+
+            return PreparedStatement(fmt::format("SELECT count(*) FROM (SELECT 1 FROM {}_safe WHERE {} LIMIT {}) q;", tablename, condition,
+                                         PreparedStatement::placeholder(params.size())),
+                std::move(params));
+        }
+        catch (const std::exception &e)
+        {
+            Message::ErrorMessage(fmt::format("Failed to create Sql search count statement for table {}.", tablename));
+            Message::CriticalMessage(e.what());
+            return std::nullopt;
+        }
+    }
+
+    [[nodiscard]] std::optional<PreparedStatement> getSqlSearchEstimateStatement() const
+    {
+        try
+        {
+            PreparedStatement::Params params;
+            std::string               condition = getSearchCondition(std::get<Search_t>(getData()), params);
+
+            return PreparedStatement(fmt::format("EXPLAIN (FORMAT JSON) SELECT 1 FROM {}_safe WHERE {};", tablename, condition), std::move(params));
+        }
+        catch (const std::exception &e)
+        {
+            Message::ErrorMessage(fmt::format("Failed to create Sql search estimate statement for table {}.", tablename));
+            Message::CriticalMessage(e.what());
+            return std::nullopt;
+        }
+    }
+
+    // Multi-row variants for batches, each yields one statement however many rows it carries.
+
+    // every row must have the same keys, id included
+    static std::optional<PreparedStatement> getSqlBatchCreateStatement(const std::string &table, const std::vector<jsoncons::json> &rows)
+    {
+        try
+        {
+            if (rows.empty())
+            {
+                return std::nullopt;
+            }
+
+            std::vector<std::string> keys_arr;
+            for (const auto &iterator : rows.front().object_range())
+            {
+                keys_arr.push_back(PreparedStatement::quoteIdentifier(iterator.key()));
+            }
+
+            std::vector<std::string>  tuples_arr;
+            PreparedStatement::Params values_arr;
+            values_arr.reserve(rows.size() * keys_arr.size());
+
+            for (const auto &row : rows)
+            {
+                std::vector<std::string> placeholders_arr;
+                for (const auto &iterator : row.object_range())
+                {
+                    values_arr.push_back(toParam(iterator.value()));
+                    placeholders_arr.push_back(PreparedStatement::placeholder(values_arr.size()));
+                }
+
+                if (placeholders_arr.size() != keys_arr.size())
+                {
+                    Message::ErrorMessage(fmt::format("Failed to create Sql batch create statement for table {}, rows differ in columns.", table));
+                    return std::nullopt;
+                }
+                tuples_arr.push_back(fmt::format("({})", fmt::join(placeholders_arr, ",")));
+            }
+
+            return PreparedStatement(fmt::format("INSERT INTO {} ({}) VALUES {} RETURNING *;", table, fmt::join(keys_arr, ","), fmt::join(tuples_arr, ",")),
+                std::move(values_arr));
+        }
+        catch (const std::exception &e)
+        {
+            Message::ErrorMessage(fmt::format("Failed to create Sql batch create statement for table {}.", table));
+            Message::CriticalMessage(e.what());
+            return std::nullopt;
+        }
+    }
+
+    // every payload must have the same keys, id excluded. Values of a VALUES list are text, so each column is cast back
+    // to its type from the schema; arrays and enums have no usable type name there and go through json_populate_record
+    static std::optional<PreparedStatement> getSqlBatchUpdateStatement(
+        const std::string &table, const std::vector<std::pair<uint64_t, jsoncons::json>> &rows, const std::unordered_set<api::v2::ColumnInfo> &schema)
+    {
+        try
+        {
+            if (rows.empty())
+            {
+                return std::nullopt;
+            }
+
+            std::unordered_map<std::string, std::string> types;
+            for (const auto &column : schema)
+            {
+                types.emplace(column.Name, column.DataType);
+            }
+
+            std::vector<std::string> keys_arr = {PreparedStatement::quoteIdentifier("id")};
+            std::vector<std::string> set_arr;
+            for (const auto &iterator : rows.front().second.object_range())
+            {
+                std::string key    = PreparedStatement::quoteIdentifier(iterator.key());
+                auto        type   = types.find(iterator.key());
+                std::string source = fmt::format("v.{}", key);
+
+                if (type == types.end() || type->second == "ARRAY" || type->second == "USER-DEFINED")
+                {
+                    source = fmt::format("(json_populate_record(NULL::{}, json_build_object({}, {}))).{}", table,
+                        PreparedStatement::quoteLiteral(iterator.key()), source, key);
+                }
+                else
+                {
+                    source = fmt::format("{}::{}", source, type->second);
+                }
+
+                set_arr.push_back(fmt::format("{} = {}", key, source));
+                keys_arr.push_back(std::move(key));
+            }
+
+            std::vector<std::string>  tuples_arr;
+            PreparedStatement::Params values_arr;
+            values_arr.reserve(rows.size() * keys_arr.size());
+
+            for (const auto &[id, payload] : rows)
+            {
+                values_arr.emplace_back(std::to_string(id));
+                std::vector<std::string> placeholders_arr = {PreparedStatement::placeholder(values_arr.size())};
+
+                for (const auto &iterator : payload.object_range())
+                {
+                    values_arr.push_back(toParam(iterator.value()));
+                    placeholders_arr.push_back(PreparedStatement::placeholder(values_arr.size()));
+                }
+
+                if (placeholders_arr.size() != keys_arr.size())
+                {
+                    Message::ErrorMessage(fmt::format("Failed to create Sql batch update statement for table {}, rows differ in columns.", table));
+                    return std::nullopt;
+                }
+                tuples_arr.push_back(fmt::format("({})", fmt::join(placeholders_arr, ",")));
+            }
+
+            return PreparedStatement(fmt::format(R"(UPDATE {} AS t SET {} FROM (VALUES {}) AS v({}) WHERE t.id = v."id"::bigint RETURNING t.*;)", table,
+                                         fmt::join(set_arr, ", "), fmt::join(tuples_arr, ","), fmt::join(keys_arr, ",")),
+                std::move(values_arr));
+        }
+        catch (const std::exception &e)
+        {
+            Message::ErrorMessage(fmt::format("Failed to create Sql batch update statement for table {}.", table));
+            Message::CriticalMessage(e.what());
+            return std::nullopt;
+        }
+    }
 
-        return query;
+    static PreparedStatement getSqlBatchDeleteStatement(const std::string &table, const std::vector<uint64_t> &ids)
+    {
+        return PreparedStatement(fmt::format("DELETE FROM {} WHERE id = ANY($1::bigint[]) RETURNING id;", table), {fmt::format("{{{}}}", fmt::join(ids, ","))});
     }
 
     [[nodiscard("Warning: You should never discard the returned object")]] const EntityType &getData() const { return data; }
@@ -208,6 +412,129 @@ class Entity : public Base
     }
 
    protected:
+    // json null is bound as SQL NULL, strings are bound verbatim and everything else as its json text
+    static std::optional<std::string> toParam(const jsoncons::json &value)
+    {
+        if (value.is_null())
+        {
+            return std::nullopt;
+        }
+        return value.as<std::string>();
+    }
+
+    // Keyset pagination, the page seeks past the (order_by, id) of the last row of the previous one instead of
+    // skipping offset rows, so every page costs the same. NULL order values sort last and are paged by id alone.
+    std::optional<PreparedStatement> getSqlKeysetSearchStatement(const Search_t &searchdata)
+    {
+        std::string order_by  = PreparedStatement::quoteIdentifier(searchdata.order_by);
+        std::string direction = searchdata.direction;
+        std::string op        = direction == "ASC" ? ">" : "<";
+
+        PreparedStatement::Params params;
+        std::string               condition = getSearchCondition(searchdata, params);
+
+        if (searchdata.after.has_value() && searchdata.after->value.has_value())
+        {
+            params.emplace_back(searchdata.after->value.value());
+            std::string value = PreparedStatement::placeholder(params.size());
+            params.emplace_back(std::to_string(searchdata.after->id));
+            condition +=
+                fmt::format(" AND (({0}, id) {1} ({2}, {3}::bigint) OR {0} IS NULL)", order_by, op, value, PreparedStatement::placeholder(params.size()));
+        }
+        else if (searchdata.after.has_value())
+        {
+            params.emplace_back(std::to_string(searchdata.after->id));
+            condition += fmt::format(" AND {} IS NULL AND id {} {}::bigint", order_by, op, PreparedStatement::placeholder(params.size()));
+        }
+
+        params.emplace_back(std::to_string(searchdata.limit + 1));
+
+        std::string order = fmt::format("{} {} NULLS LAST, id {}", order_by, direction, direction);
+
+        PreparedStatement statement(
+            fmt::format("SELECT * FROM {}_safe WHERE {} ORDER BY {} LIMIT {};", tablename, condition, order, PreparedStatement::placeholder(params.size())),
+            std::move(params));
+        statement.order = std::move(order);
+        return statement;
+    }
+
+    // the requested match mode if the filter column supports it. Prefix and trigram matches work on text columns
+    // and trigram matches need pg_trgm, anything else falls back to a substring match on the column as text
+    [[nodiscard]] Search_t::Match getSearchMatch(const Search_t &searchdata) const
+    {
+        if (searchdata.match == Search_t::Match::CONTAINS || !DatabaseSchema::isTextColumn(tablename, searchdata.filter))
+        {
+            return Search_t::Match::CONTAINS;
+        }
+        if (searchdata.match == Search_t::Match::TRIGRAM && !DatabaseSchema::trigramSupported())
+        {
+            return Search_t::Match::CONTAINS;
+        }
+        return searchdata.match;
+    }
+
+    // The where filter and the keyword match on filter joined by AND, binds their values to the empty params. TRUE
+    // when the request has neither. The where filter is the one the controller compiled, its placeholders start at
+    // $1 so it goes first, a where filter that was not compiled throws.
+    [[nodiscard]] std::string getSearchCondition(const Search_t &searchdata, PreparedStatement::Params &params) const
+    {
+        std::vector<std::string> conditions;
+
+        if (searchdata.where.has_value())
+        {
+            if (searchdata.compiled == nullptr || !params.empty())
+            {
+                throw std::runtime_error(fmt::format("Search filter for table {} is not compiled.", tablename));
+            }
+            params = searchdata.compiled->params;
+            conditions.push_back(searchdata.compiled->condition);
+        }
+
+        if (!searchdata.filter.empty())
+        {
+            conditions.push_back(getKeywordCondition(searchdata, params));
+        }
+
+        return conditions.empty() ? "TRUE" : fmt::format("{}", fmt::join(conditions, " AND "));
+    }
+
+    // The condition matching keyword, binds it to params. Prefix and trigram conditions leave the column uncast so
+    // the indexes verified by DatabaseSchema::verifySearchIndexes apply, and match keyword literally.
+    [[nodiscard]] std::string getKeywordCondition(const Search_t &searchdata, PreparedStatement::Params &params) const
+    {
+        std::string filter = PreparedStatement::quoteIdentifier(searchdata.filter);
+
+        switch (getSearchMatch(searchdata))
+        {
+            case Search_t::Match::PREFIX:
+                params.emplace_back(fmt::format("{}%", escapeLike(searchdata.keyword)));
+                return fmt::format("lower({}) LIKE lower({})", filter, PreparedStatement::placeholder(params.size()));
+            case Search_t::Match::TRIGRAM:
+                params.emplace_back(fmt::format("%{}%", escapeLike(searchdata.keyword)));
+                return fmt::format("{} ILIKE {}", filter, PreparedStatement::placeholder(params.size()));
+            case Search_t::Match::CONTAINS:
+            default:
+                params.emplace_back(fmt::format("%{}%", searchdata.keyword));
+                return fmt::format("{}::text ILIKE {}", filter, PreparedStatement::placeholder(params.size()));
+        }
+    }
+
+    // escapes the LIKE wildcards, backslash is the default escape character
+    static std::string escapeLike(std::string_view keyword)
+    {
+        std::string escaped;
+        escaped.reserve(keyword.size());
+        for (char character : keyword)
+        {
+            if (character == '%' || character == '_' || character == '\\')
+            {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(character);
+        }
+        return escaped;
+    }
+
     const std::string                   tablename;                                                   /*NOLINT*/
     std::shared_ptr<DatabaseController> databaseController = Store::getObject<DatabaseController>(); /*NOLINT*/
 
@@ -74,9 +74,10 @@ class Service : public Entity
         }
         return query;
     }
-    static std::optional<std::string> getServicePermissionsQuery(const std::string &service_name, std::uint64_t service_id)
+    // the permissions of many services of one table at once, bound with an array of ids and keyed by id
+    static std::string getServicePermissionsBatchQuery(const std::string &service_name)
     {
-        return fmt::format("SELECT owner_id,admin_id,staff FROM {} WHERE id = '{}' LIMIT 1;", service_name, service_id);
+        return fmt::format("SELECT id,owner_id,admin_id,staff FROM {} WHERE id = ANY($1::bigint[]);", service_name);
     }
 
    private:
@@ -17,12 +17,14 @@
 #include <unordered_set>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "configurator/configurator.hpp"
 #include "gatekeeper/passwordcrypt/passwordcrypt.hpp"
 #include "store/store.hpp"
 #include "utils/global/http.hpp"
 #include "utils/message/message.hpp"
+#include "utils/searchfilter/searchfilter.hpp"
 #include "validator/validator.hpp"
 namespace api::v2::Types
 {
@@ -103,24 +105,74 @@ namespace api::v2::Types
 
     using Search_t = struct Search_t
     {
-        std::string keyword;
-        std::string filter;
-        std::string order_by;
-        std::string direction;
-        size_t      limit;
-        size_t      offset;
-
-        Search_t(const jsoncons::json &search_j, bool &success)
+        // the position a keyset page starts after, the order_by value of the last row as text and its id
+        struct Cursor
+        {
+            std::optional<std::string> value;
+            uint64_t                   id;
+        };
+
+        // how keyword matches filter, CONTAINS is a substring match on the column as text
+        enum class Match : std::uint8_t
+        {
+            CONTAINS,
+            PREFIX,   // filter starts with keyword, ignoring case
+            TRIGRAM,  // filter contains keyword, ranked by trigram similarity instead of order_by
+        };
+
+        std::string                   keyword;
+        std::string                   filter;
+        std::string                   order_by;
+        std::string                   direction;
+        size_t                        limit;
+        size_t                        offset = 0;
+        bool                          keyset = false;  // set when the request carries a cursor instead of an offset
+        std::optional<Cursor>         after;           // nullopt on the first keyset page
+        Match                         match = Match::CONTAINS;
+        std::optional<jsoncons::json> where;  // a SearchFilter expression, keyword and filter are optional with it
+        // where compiled once by the controller, the search, count and estimate statements all reuse it
+        std::shared_ptr<const SearchFilter::Compiled> compiled;
+        bool                          count = false;  // whether the answer carries the total of the search
+
+        // a cursor the client cannot have got from us is answered with a BAD_REQUEST in error
+        Search_t(const jsoncons::json &search_j, api::v2::Http::Error &error, bool &success)
         {
             try
             {
-                keyword   = search_j.at("keyword").as<std::string>();
-                filter    = search_j.at("filter").as<std::string>();
+                where     = search_j.contains("where") ? std::optional<jsoncons::json>(search_j.at("where")) : std::nullopt;
+                keyword   = search_j.contains("keyword") ? search_j.at("keyword").as<std::string>() : "";
+                filter    = search_j.contains("filter") ? search_j.at("filter").as<std::string>() : "";
                 order_by  = search_j.at("order_by").as<std::string>();
                 direction = search_j.at("direction").as<short>() == 0 ? "ASC" : "DESC";
                 limit     = search_j.at("limit").as<size_t>();
-                offset    = search_j.at("offset").as<size_t>();
-                success   = validate(search_j);
+                keyset    = search_j.contains("cursor");
+                match     = search_j.contains("match") ? matchOf(search_j.at("match").as<std::string>()) : Match::CONTAINS;
+                count     = search_j.contains("count") && search_j.at("count").as<bool>();
+
+                if (keyset && match == Match::TRIGRAM)
+                {
+                    error.code    = api::v2::Http::Status::BAD_REQUEST;
+                    error.message = "Trigram matches are ranked by similarity and cannot be paged with a cursor.";
+                    success       = false;
+                    return;
+                }
+
+                if (keyset)
+                {
+                    std::string problem;
+                    if (!search_j.at("cursor").is_string() || !decodeCursor(search_j.at("cursor").as<std::string>(), problem))
+                    {
+                        error.code    = api::v2::Http::Status::BAD_REQUEST;
+                        error.message = fmt::format("Invalid cursor, {}", problem.empty() ? "it is not a string." : problem);
+                        success       = false;
+                        return;
+                    }
+                }
+                else
+                {
+                    offset = search_j.at("offset").as<size_t>();
+                }
+                success = validate(search_j);
             }
             catch (const std::exception &e)
             {
@@ -128,11 +180,95 @@ namespace api::v2::Types
                 throw std::runtime_error(std::string(e.what()));
             }
         }
-        bool validate(const jsoncons::json &search_j)
+        bool validate(const jsoncons::json &search_j) const
         {
-            std::unordered_set<std::string> keys = {"keyword", "filter", "order_by", "direction", "limit", "offset"};
+            std::unordered_set<std::string> keys = {"order_by", "direction", "limit", keyset ? "cursor" : "offset"};
+            if (!where.has_value())
+            {
+                keys.insert({"keyword", "filter"});
+            }
             return std::ranges::all_of(keys, [&search_j](const std::string &key) { return search_j.find(key).has_value(); });
         }
+
+        // The opaque cursor of the page following the row with value and id. It names the order it was made
+        // for, so a client cannot continue a listing under a different order.
+        [[nodiscard]] std::string encodeCursor(const std::optional<std::string_view> &value, std::string_view id) const
+        {
+            jsoncons::json cursor_j;
+            cursor_j["o"]  = order_by;
+            cursor_j["d"]  = direction;
+            cursor_j["v"]  = value.has_value() ? jsoncons::json(std::string(value.value())) : jsoncons::json::null();
+            cursor_j["id"] = std::string(id);
+            return cppcodec::base64_rfc4648::encode(cursor_j.to_string());
+        }
+
+       private:
+        static Match matchOf(const std::string &name)
+        {
+            if (name == "contains")
+            {
+                return Match::CONTAINS;
+            }
+            if (name == "prefix")
+            {
+                return Match::PREFIX;
+            }
+            if (name == "trigram")
+            {
+                return Match::TRIGRAM;
+            }
+            throw std::runtime_error(fmt::format("Unknown match {}, expected contains, prefix or trigram.", name));
+        }
+
+        // Fills after from the cursor, an empty cursor asks for the first page. The cursor comes from the client,
+        // so anything that is not one of ours is reported in problem instead of thrown.
+        [[nodiscard]] bool decodeCursor(const std::string &cursor, std::string &problem)
+        {
+            if (cursor.empty())
+            {
+                return true;
+            }
+
+            jsoncons::json cursor_j;
+            try
+            {
+                std::vector<uint8_t> decoded = cppcodec::base64_rfc4648::decode(cursor);
+                cursor_j                     = jsoncons::json::parse(std::string(decoded.begin(), decoded.end()));
+            }
+            catch (const std::exception &e)
+            {
+                problem = "it is not one this server made.";
+                return false;
+            }
+
+            auto isString = [&cursor_j](const char *key) { return cursor_j.contains(key) && cursor_j.at(key).is_string(); };
+            if (!cursor_j.is_object() || !isString("o") || !isString("d") || !isString("id") || !cursor_j.contains("v") ||
+                !(cursor_j.at("v").is_null() || cursor_j.at("v").is_string()))
+            {
+                problem = "it is not one this server made.";
+                return false;
+            }
+
+            if (cursor_j.at("o").as<std::string>() != order_by || cursor_j.at("d").as<std::string>() != direction)
+            {
+                problem = "it was made for a different order_by or direction.";
+                return false;
+            }
+
+            std::string id = cursor_j.at("id").as<std::string>();
+            if (id.empty() || !std::ranges::all_of(id, [](char character) { return character >= '0' && character <= '9'; }) || id.size() > 19)
+            {
+                problem = "its id is not a number.";
+                return false;
+            }
+
+            after = Cursor{.value = std::nullopt, .id = std::stoull(id)};
+            if (!cursor_j.at("v").is_null())
+            {
+                after->value = cursor_j.at("v").as<std::string>();
+            }
+            return true;
+        }
     };
 
     struct ClientData_t
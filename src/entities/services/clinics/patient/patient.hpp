@@ -2,15 +2,20 @@
 
 #include <fmt/core.h>
 
+#include <array>
 #include <cstdint>
 #include <exception>
 #include <jsoncons/basic_json.hpp>
 #include <jsoncons/json.hpp>
 #include <optional>
+#include <span>
 #include <string>
 
+#include "database/preparedstatement.hpp"
 #include "entities/base/case.hpp"
 #include "entities/base/types.hpp"
+#include "validator/databaseschema/columndescriptor.hpp"
+#include "validator/databaseschema/searchindex.hpp"
 
 using Data_t = api::v2::Types::Data_t;
 
@@ -20,6 +25,17 @@ class Patient : public Case
     static constexpr auto TABLENAME  = "patients";
     static constexpr auto CREATE_KEY = "clinic_id";
 
+    // patients are looked up by name with the prefix and trigram match modes, their indexes are verified at startup
+    static constexpr std::array<SearchIndex, 2> SEARCH_INDEXES = {
+        SearchIndex{.column = "name", .kind = SearchIndex::Kind::TRIGRAM}, SearchIndex{.column = "name", .kind = SearchIndex::Kind::PREFIX}};
+
+    // the columns the server relies on, verified against the catalog at startup
+    static constexpr std::array<ColumnDescriptor, 2> COLUMNS = {
+        ColumnDescriptor{.name = "id", .kind = ColumnDescriptor::Kind::INTEGER}, ColumnDescriptor{.name = CREATE_KEY, .kind = ColumnDescriptor::Kind::INTEGER}};
+
+    static_assert(ColumnDescriptor::unique(COLUMNS));
+    static_assert(ColumnDescriptor::declares(COLUMNS, "id") && ColumnDescriptor::declares(COLUMNS, CREATE_KEY));
+
    public:
     Patient(const Patient&)            = delete;
     Patient(Patient&&)                 = delete;
@@ -34,10 +50,12 @@ class Patient : public Case
 
     static constexpr auto getTableName() { return TABLENAME; }
     static constexpr auto getCreateKey() { return CREATE_KEY; }
+    static constexpr auto getSearchIndexes() { return std::span<const SearchIndex>(SEARCH_INDEXES); }
+    static constexpr auto getColumns() { return std::span<const ColumnDescriptor>(COLUMNS); }
 
-    std::string getSqlGetVisitsStatement()
+    PreparedStatement getSqlGetVisitsStatement()
     {
-        return fmt::format("SELECT * FROM clinics_visits WHERE patient_id = {} ;", std::get<Data_t>(getData()).get_id().value());
+        return PreparedStatement("SELECT * FROM clinics_visits WHERE patient_id = $1;", {std::to_string(std::get<Data_t>(getData()).get_id().value())});
     }
 
     static std::optional<std::string> getPermissionsQueryForCreate(const std::optional<jsoncons::json>& data_j)
@@ -56,9 +74,10 @@ class Patient : public Case
         return getPermissionsQueryForCreatePatientImpl(id);
     }
 
-    static std::optional<std::string> getPermissionsQueryForRead(const uint64_t id) { return getPermissionsQueryForReadImp(id, TABLENAME); }
-
-    static std::optional<std::string> getPermissionsQueryForUpdate(const uint64_t id) { return getPermissionsQueryForUpdateImpl(id, TABLENAME); }
+    static std::optional<PreparedStatement> getPermissionsStatementForCreate(const std::optional<jsoncons::json>& data_j)
+    {
+        return getPermissionsStatementForCreatePatientImpl(data_j, CREATE_KEY);
+    }
 
-    static std::optional<std::string> getPermissionsQueryForDelete(const uint64_t id) { return getPermissionsQueryForDeleteImp(id, TABLENAME); }
+    static std::string getPermissionsBatchQueryForCreate() { return getPermissionsBatchQueryForCreatePatientImpl(); }
 };
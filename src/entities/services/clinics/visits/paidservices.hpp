@@ -39,9 +39,11 @@ class PaidServices : public Case
 
         return getPermissionsQueryForCreateImpl(id, KEYREFTABLENAME);
     }
-    static std::optional<std::string> getPermissionsQueryForRead(const uint64_t id) { return getPermissionsQueryForReadImp(id, TABLENAME); }
 
-    static std::optional<std::string> getPermissionsQueryForUpdate(const uint64_t id) { return getPermissionsQueryForUpdateImpl(id, TABLENAME); }
+    static std::optional<PreparedStatement> getPermissionsStatementForCreate(const std::optional<jsoncons::json>& data_j)
+    {
+        return getPermissionsStatementForCreateImpl(data_j, CREATE_KEY, KEYREFTABLENAME);
+    }
 
-    static std::optional<std::string> getPermissionsQueryForDelete(const uint64_t id) { return getPermissionsQueryForDeleteImp(id, TABLENAME); }
+    static std::string getPermissionsBatchQueryForCreate() { return getPermissionsBatchQueryForCreateImpl(KEYREFTABLENAME); }
 };
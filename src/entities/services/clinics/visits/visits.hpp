@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
 #include <jsoncons/json.hpp>
+#include <span>
 
 #include "entities/base/case.hpp"
+#include "validator/databaseschema/columndescriptor.hpp"
 
 class Visits : public Case
 {
@@ -11,6 +14,13 @@ class Visits : public Case
     static constexpr auto KEYREFTABLENAME = "patients";
     static constexpr auto CREATE_KEY      = "patient_id";
 
+    // the columns the server relies on, verified against the catalog at startup
+    static constexpr std::array<ColumnDescriptor, 2> COLUMNS = {
+        ColumnDescriptor{.name = "id", .kind = ColumnDescriptor::Kind::INTEGER}, ColumnDescriptor{.name = CREATE_KEY, .kind = ColumnDescriptor::Kind::INTEGER}};
+
+    static_assert(ColumnDescriptor::unique(COLUMNS));
+    static_assert(ColumnDescriptor::declares(COLUMNS, "id") && ColumnDescriptor::declares(COLUMNS, CREATE_KEY));
+
    public:
     // Visits() : Case(TABLENAME) {}
 
@@ -21,6 +31,7 @@ class Visits : public Case
 
     static constexpr auto getTableName() { return TABLENAME; }
     static constexpr auto getCreateKey() { return CREATE_KEY; }
+    static constexpr auto getColumns() { return std::span<const ColumnDescriptor>(COLUMNS); }
 
     ~Visits() override = default;
 
@@ -39,9 +50,11 @@ class Visits : public Case
 
         return getPermissionsQueryForCreateImpl(id, KEYREFTABLENAME);
     }
-    static std::optional<std::string> getPermissionsQueryForRead(const uint64_t id) { return getPermissionsQueryForReadImp(id, TABLENAME); }
 
-    static std::optional<std::string> getPermissionsQueryForUpdate(const uint64_t id) { return getPermissionsQueryForUpdateImpl(id, TABLENAME); }
+    static std::optional<PreparedStatement> getPermissionsStatementForCreate(const std::optional<jsoncons::json>& data_j)
+    {
+        return getPermissionsStatementForCreateImpl(data_j, CREATE_KEY, KEYREFTABLENAME);
+    }
 
-    static std::optional<std::string> getPermissionsQueryForDelete(const uint64_t id) { return getPermissionsQueryForDeleteImp(id, TABLENAME); }
+    static std::string getPermissionsBatchQueryForCreate() { return getPermissionsBatchQueryForCreateImpl(KEYREFTABLENAME); }
 };
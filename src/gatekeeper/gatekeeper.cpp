@@ -177,27 +177,57 @@ bool GateKeeper::canCreate(const Requester& requester, const std::optional<jsonc
 }
 
 template <typename T>
-bool GateKeeper::canRead(const Requester& requester, const uint64_t entity_id, Http::Error& error)
+void GateKeeper::canRead(const Requester& requester, const uint64_t entity_id, PermissionManager::Decision&& decision)
 {
-    return permissionManager_->canRead<T>(requester, entity_id, error);
+    permissionManager_->canRead<T>(requester, entity_id, std::move(decision));
 }
 
 template <typename T>
-bool GateKeeper::canUpdate(const Requester& requester, const uint64_t entity_id, Http::Error& error)
+void GateKeeper::canUpdate(const Requester& requester, const uint64_t entity_id, PermissionManager::Decision&& decision)
 {
-    return permissionManager_->canUpdate<T>(requester, entity_id, error);
+    permissionManager_->canUpdate<T>(requester, entity_id, std::move(decision));
 }
 
 template <typename T>
-bool GateKeeper::canDelete(const Requester& requester, const uint64_t entity_id, Http::Error& error)
+void GateKeeper::canDelete(const Requester& requester, const uint64_t entity_id, PermissionManager::Decision&& decision)
 {
-    return permissionManager_->canDelete<T>(requester, entity_id, error);
+    permissionManager_->canDelete<T>(requester, entity_id, std::move(decision));
 }
 
 template <typename T>
-bool GateKeeper::canManageStaff(const Requester& requester, uint64_t _id, Http::Error& error)
+void GateKeeper::canManageStaff(const Requester& requester, uint64_t _id, PermissionManager::Decision&& decision)
 {
-    return permissionManager_->canManageStaff<T>(requester, _id, error);
+    permissionManager_->canManageStaff<T>(requester, _id, std::move(decision));
+}
+
+template <Case_t T>
+bool GateKeeper::canCreateWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error)
+{
+    return permissionManager_->canCreateWithPermissions<T>(requester, permissions_j, error);
+}
+
+template <Case_t T>
+bool GateKeeper::canReadWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error)
+{
+    return permissionManager_->canReadWithPermissions<T>(requester, permissions_j, error);
+}
+
+template <Case_t T>
+bool GateKeeper::canCreateMany(const Requester& requester, const std::vector<uint64_t>& parent_ids, Http::Error& error)
+{
+    return permissionManager_->canCreateMany<T>(requester, parent_ids, error);
+}
+
+template <Case_t T>
+bool GateKeeper::canUpdateMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error)
+{
+    return permissionManager_->canUpdateMany<T>(requester, ids, error);
+}
+
+template <Case_t T>
+bool GateKeeper::canDeleteMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error)
+{
+    return permissionManager_->canDeleteMany<T>(requester, ids, error);
 }
 
 template <Client_t T>
@@ -213,11 +243,11 @@ bool GateKeeper::canGetServices(const Requester& requester, const uint64_t _id,
 }
 
 // canCreate specializations
-#define INSTANTIATE_GATEKEEPER_CRUD(TYPE) /* NOLINT  */                                                              \
-    template bool GateKeeper::canCreate<TYPE>(const Requester&, const std::optional<jsoncons::json>&, Http::Error&); \
-    template bool GateKeeper::canRead<TYPE>(const Requester&, const uint64_t entity_id, Http::Error&);               \
-    template bool GateKeeper::canUpdate<TYPE>(const Requester&, const uint64_t entity_id, Http::Error&);             \
-    template bool GateKeeper::canDelete<TYPE>(const Requester&, const uint64_t entity_id, Http::Error&);
+#define INSTANTIATE_GATEKEEPER_CRUD(TYPE) /* NOLINT  */                                                                   \
+    template bool GateKeeper::canCreate<TYPE>(const Requester&, const std::optional<jsoncons::json>&, Http::Error&);      \
+    template void GateKeeper::canRead<TYPE>(const Requester&, const uint64_t entity_id, PermissionManager::Decision&&);   \
+    template void GateKeeper::canUpdate<TYPE>(const Requester&, const uint64_t entity_id, PermissionManager::Decision&&); \
+    template void GateKeeper::canDelete<TYPE>(const Requester&, const uint64_t entity_id, PermissionManager::Decision&&);
 
 #define INSTANTIATE_GATEKEEPER_CLIENT(TYPE) /* NOLINT  */                                                               \
     INSTANTIATE_GATEKEEPER_CRUD(TYPE)                                                                                   \
@@ -226,7 +256,15 @@ bool GateKeeper::canGetServices(const Requester& requester, const uint64_t _id,
 
 #define INSTANTIATE_GATEKEEPER_ENTITY(TYPE) /* NOLINT  */ \
     INSTANTIATE_GATEKEEPER_CRUD(TYPE)                     \
-    template bool GateKeeper::canManageStaff<TYPE>(const Requester&, const uint64_t entity_id, Http::Error&);
+    template void GateKeeper::canManageStaff<TYPE>(const Requester&, const uint64_t entity_id, PermissionManager::Decision&&);
+
+#define INSTANTIATE_GATEKEEPER_CASE(TYPE) /* NOLINT  */                                                                             \
+    INSTANTIATE_GATEKEEPER_CRUD(TYPE)                                                                                               \
+    template bool GateKeeper::canCreateWithPermissions<TYPE>(const Requester&, const std::optional<jsoncons::json>&, Http::Error&); \
+    template bool GateKeeper::canReadWithPermissions<TYPE>(const Requester&, const std::optional<jsoncons::json>&, Http::Error&);   \
+    template bool GateKeeper::canCreateMany<TYPE>(const Requester&, const std::vector<uint64_t>&, Http::Error&);                    \
+    template bool GateKeeper::canUpdateMany<TYPE>(const Requester&, const std::vector<uint64_t>&, Http::Error&);                    \
+    template bool GateKeeper::canDeleteMany<TYPE>(const Requester&, const std::vector<uint64_t>&, Http::Error&);
 
 // Usage:
 INSTANTIATE_GATEKEEPER_CLIENT(User)
@@ -237,15 +275,15 @@ INSTANTIATE_GATEKEEPER_ENTITY(Pharmacies)
 INSTANTIATE_GATEKEEPER_ENTITY(Laboratories)
 INSTANTIATE_GATEKEEPER_ENTITY(RadiologyCenters)
 
-INSTANTIATE_GATEKEEPER_CRUD(Patient)
-INSTANTIATE_GATEKEEPER_CRUD(Health)
-INSTANTIATE_GATEKEEPER_CRUD(PatientDrugs)
-INSTANTIATE_GATEKEEPER_CRUD(Reports)
-INSTANTIATE_GATEKEEPER_CRUD(Visits)
-INSTANTIATE_GATEKEEPER_CRUD(VisitDrugs)
-INSTANTIATE_GATEKEEPER_CRUD(Prescriptions)
-INSTANTIATE_GATEKEEPER_CRUD(Requests)
-INSTANTIATE_GATEKEEPER_CRUD(PaidServices)
+INSTANTIATE_GATEKEEPER_CASE(Patient)
+INSTANTIATE_GATEKEEPER_CASE(Health)
+INSTANTIATE_GATEKEEPER_CASE(PatientDrugs)
+INSTANTIATE_GATEKEEPER_CASE(Reports)
+INSTANTIATE_GATEKEEPER_CASE(Visits)
+INSTANTIATE_GATEKEEPER_CASE(VisitDrugs)
+INSTANTIATE_GATEKEEPER_CASE(Prescriptions)
+INSTANTIATE_GATEKEEPER_CASE(Requests)
+INSTANTIATE_GATEKEEPER_CASE(PaidServices)
 INSTANTIATE_GATEKEEPER_CRUD(ClinicAppointment)
 INSTANTIATE_GATEKEEPER_CRUD(PharmacyAppointment)
 INSTANTIATE_GATEKEEPER_CRUD(LaboratoryAppointment)
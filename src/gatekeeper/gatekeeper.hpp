@@ -8,6 +8,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "gatekeeper/dosdetector/dosdetector.hpp"
 #include "gatekeeper/permissionmanager/permissionmanager.hpp"
@@ -40,17 +41,33 @@ namespace api::v2
         template <typename T>
         bool canCreate(const Requester& requester, const std::optional<jsoncons::json>& data_j, Http::Error& error);
 
+        // the checks of one entity by id look its permissions up without blocking and hand their verdict to decision
         template <typename T>
-        bool canRead(const Requester& requester, uint64_t entity_id, Http::Error& error);
+        void canRead(const Requester& requester, uint64_t entity_id, PermissionManager::Decision&& decision);
 
         template <typename T>
-        bool canUpdate(const Requester& requester, uint64_t entity_id, Http::Error& error);
+        void canUpdate(const Requester& requester, uint64_t entity_id, PermissionManager::Decision&& decision);
 
         template <typename T>
-        bool canDelete(const Requester& requester, uint64_t entity_id, Http::Error& error);
+        void canDelete(const Requester& requester, uint64_t entity_id, PermissionManager::Decision&& decision);
 
         template <typename T>
-        bool canManageStaff(const Requester& requester, uint64_t _id, Http::Error& error);
+        void canManageStaff(const Requester& requester, uint64_t _id, PermissionManager::Decision&& decision);
+
+        template <Case_t T>
+        bool canCreateWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error);
+
+        template <Case_t T>
+        bool canReadWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error);
+
+        template <Case_t T>
+        bool canCreateMany(const Requester& requester, const std::vector<uint64_t>& parent_ids, Http::Error& error);
+
+        template <Case_t T>
+        bool canUpdateMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error);
+
+        template <Case_t T>
+        bool canDeleteMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error);
 
         template <Client_t T>
         bool canToggleActive(const Requester& requester, uint64_t _id, Http::Error& error);
@@ -0,0 +1,139 @@
+#include "gatekeeper/permissionmanager/permissionbatcher.hpp"
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <trantor/net/EventLoop.h>
+
+#include <cstdint>
+#include <exception>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/preparedstatement.hpp"
+#include "database/readrouter.hpp"
+#include "database/requestlease.hpp"
+#include "store/store.hpp"
+#include "utils/message/message.hpp"
+
+using PermissionBatcher = api::v2::PermissionBatcher;
+
+PermissionBatcher::PermissionBatcher()
+    : PermissionBatcher(
+          [databaseController = Store::getObject<DatabaseController>()](const PreparedStatement& statement, std::function<void(Rows&&)>&& callback)
+          { databaseController->executeSearchPreparedAsync(statement, std::move(callback)); },
+          [readRouter = Store::getObject<ReadRouter>()]() { return RequestLease::inTransaction() || readRouter->inWriteWindow(); })
+{
+}
+
+PermissionBatcher::PermissionBatcher(Query query, Alone alone) : query_(std::move(query)), alone_(std::move(alone)) {}
+
+void PermissionBatcher::lookup(const std::string& sql, const std::string& key_column, uint64_t id, Callback&& callback)
+{
+    trantor::EventLoop* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+
+    // a request transaction must check the rows as it sees them and a client that just wrote must see its write,
+    // so those lookups run in the caller's context rather than in a batch sent on behalf of everyone
+    if (loop == nullptr || alone_())
+    {
+        auto own        = std::make_shared<Batch>();
+        own->key_column = key_column;
+        own->waiters[id].push_back(std::move(callback));
+        send(sql, own);
+        return;
+    }
+
+    std::shared_ptr<Batch> batch;
+    bool                   leader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [open, opened] = open_.try_emplace(Key{loop, sql});
+
+        if (opened)
+        {
+            open->second             = std::make_shared<Batch>();
+            open->second->key_column = key_column;
+            leader                   = true;
+        }
+
+        // the batch is answered outside of any request, every waiter continues under its own lease
+        batch = open->second;
+        batch->waiters[id].push_back(RequestLease::bind(std::move(callback)));
+
+        if (batch->waiters.size() >= MAX_BATCH)
+        {
+            // later lookups open a new batch, this one still goes out with its queued send
+            open_.erase(open);
+        }
+    }
+
+    if (!leader)
+    {
+        return;
+    }
+
+    // queued behind the work the loop already has, so the lookups of every request it handles meanwhile join the batch
+    loop->queueInLoop(
+        [this, loop, sql, batch]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto                        open = open_.find(Key{loop, sql});
+                if (open != open_.end() && open->second == batch)
+                {
+                    open_.erase(open);
+                }
+            }
+            send(sql, batch);
+        });
+}
+
+void PermissionBatcher::send(const std::string& sql, const std::shared_ptr<Batch>& batch)
+{
+    // the batch is closed, nobody adds to its waiters anymore
+    auto deliver = [batch](Rows&& found)
+    {
+        std::unordered_map<uint64_t, jsoncons::json> rows;
+        try
+        {
+            if (found.has_value())
+            {
+                rows.reserve(found->size());
+                for (auto& row : found.value())
+                {
+                    uint64_t key = row.at(batch->key_column).as<uint64_t>();
+                    rows.emplace(key, std::move(row));
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Message::CriticalMessage(fmt::format("Failed to resolve a batch of permission lookups: {}", e.what()));
+            found.reset();
+        }
+
+        for (auto& [id, callbacks] : batch->waiters)
+        {
+            auto row = rows.find(id);
+            for (auto& callback : callbacks)
+            {
+                callback(found.has_value() && row != rows.end() ? std::optional<jsoncons::json>(row->second) : std::nullopt);
+            }
+        }
+    };
+
+    std::vector<uint64_t> ids;
+    ids.reserve(batch->waiters.size());
+    for (const auto& [id, callbacks] : batch->waiters)
+    {
+        ids.push_back(id);
+    }
+
+    query_(PreparedStatement(sql, {fmt::format("{{{}}}", fmt::join(ids, ","))}), std::move(deliver));
+}
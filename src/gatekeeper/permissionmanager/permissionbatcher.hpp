@@ -0,0 +1,68 @@
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <jsoncons/basic_json.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+
+namespace api::v2
+{
+    /// Groups the permission lookups made on one event loop.
+    /// The first lookup of a query shape in a loop iteration opens a batch and queues its sending behind the work
+    /// the loop already has, lookups of the same shape made until then join it. A batch is resolved with one
+    /// `id = ANY($1)` query on the loop's async connection and every caller gets its own row through its callback,
+    /// so no loop ever waits on another thread. Lookups off an event loop, or that have to be resolved alone
+    /// (inside a request transaction or the client's read-your-writes window), send a query of their own at once.
+    class PermissionBatcher
+    {
+       public:
+        using Rows     = std::optional<jsoncons::json::array>;
+        using Query    = std::function<void(const PreparedStatement&, std::function<void(Rows&&)>&&)>;
+        using Alone    = std::function<bool()>;
+        using Callback = std::function<void(std::optional<jsoncons::json>&&)>;
+
+        // resolves the batches through the DatabaseController
+        PermissionBatcher();
+        // query resolves a batch and reports its rows, alone tells whether the calling lookup may not join a batch
+        PermissionBatcher(Query query, Alone alone);
+        PermissionBatcher(const PermissionBatcher&)            = delete;
+        PermissionBatcher(PermissionBatcher&&)                 = delete;
+        PermissionBatcher& operator=(const PermissionBatcher&) = delete;
+        PermissionBatcher& operator=(PermissionBatcher&&)      = delete;
+        virtual ~PermissionBatcher()                           = default;
+
+        // sql selects the rows of an array of ids bound as $1, key_column names the column holding the id of a row.
+        // callback gets the row of id, nullopt if there is none or the query failed, on the calling loop.
+        void lookup(const std::string& sql, const std::string& key_column, uint64_t id, Callback&& callback);
+
+       private:
+        struct Batch
+        {
+            std::string                                         key_column;
+            std::unordered_map<uint64_t, std::vector<Callback>> waiters;
+        };
+
+        using Key = std::pair<trantor::EventLoop*, std::string>;
+
+        void send(const std::string& sql, const std::shared_ptr<Batch>& batch);
+
+        Query                                 query_;
+        Alone                                 alone_;
+        std::mutex                            mutex_;
+        std::map<Key, std::shared_ptr<Batch>> open_;  // the batch taking lookups, per loop and query shape
+
+        static constexpr std::size_t MAX_BATCH = 1000;  // ids per query, a full batch takes no more
+    };
+}  // namespace api::v2
@@ -6,6 +6,7 @@
 #include <jsoncons/basic_json.hpp>
 #include <optional>
 #include <string>
+#include <utility>
 
 #include "gatekeeper/includes.hpp"  // IWYU pragma: keep
 #include "gatekeeper/permissionmanager/permissionmanager_private.hpp"
@@ -15,6 +16,24 @@
 using pm_priv           = api::v2::PermissionManagerPrivate;
 using PermissionManager = api::v2::PermissionManager;
 using HttpError         = api::v2::Http::Error;
+
+namespace
+{
+    // looks the permissions of id up together with the other lookups of the loop, decide rules on them once they arrived
+    template <typename Decide>
+    void decideBatched(const std::string& sql, const std::string& key_column, uint64_t id, Decide&& decide, PermissionManager::Decision&& decision)
+    {
+        pm_priv::getPermissionsOfEntityBatched(sql, key_column, id,
+            [decide = std::forward<Decide>(decide), decision = std::move(decision)](std::optional<jsoncons::json>&& permissions_j)
+            {
+                HttpError error{};
+                bool      allowed = decide(permissions_j, error);
+
+                decision(allowed, error);
+            });
+    }
+}  // namespace
+
 template <Client_t T>
 bool PermissionManager::canCreate(
     [[maybe_unused]] const Requester& requester, [[maybe_unused]] const std::optional<jsoncons::json>& data_j, [[maybe_unused]] Http::Error& error)
@@ -23,19 +42,28 @@ bool PermissionManager::canCreate(
 }
 
 template <Client_t T>
-bool PermissionManager::canRead(const Requester& requester, uint64_t client_id, HttpError& error)
+void PermissionManager::canRead(const Requester& requester, uint64_t client_id, Decision&& decision)
 {
-    return pm_priv::assert_group_id_match(requester, T::getTableName(), client_id, error);
+    HttpError error{};
+    bool      allowed = pm_priv::assert_group_id_match(requester, T::getTableName(), client_id, error);
+
+    decision(allowed, error);
 }
 template <Client_t T>
-bool PermissionManager::canUpdate(const Requester& requester, uint64_t client_id, HttpError& error)
+void PermissionManager::canUpdate(const Requester& requester, uint64_t client_id, Decision&& decision)
 {
-    return pm_priv::assert_group_id_match(requester, T::getTableName(), client_id, error);
+    HttpError error{};
+    bool      allowed = pm_priv::assert_group_id_match(requester, T::getTableName(), client_id, error);
+
+    decision(allowed, error);
 }
 template <Client_t T>
-bool PermissionManager::canDelete(const Requester& requester, const uint64_t client_id, HttpError& error)
+void PermissionManager::canDelete(const Requester& requester, uint64_t client_id, Decision&& decision)
 {
-    return pm_priv::assert_group_id_match(requester, T::getTableName(), client_id, error);
+    HttpError error{};
+    bool      allowed = pm_priv::assert_group_id_match(requester, T::getTableName(), client_id, error);
+
+    decision(allowed, error);
 }
 
 template <Client_t T>
@@ -57,43 +85,47 @@ bool PermissionManager::canCreate(const Requester& requester, const std::optiona
 }
 
 template <Service_t T>
-bool PermissionManager::canRead(const Requester& requester, uint64_t service_id, Http::Error& error)
+void PermissionManager::canRead(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
     const std::string service_name = T::getTableName();
 
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
-
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 template <Service_t T>
-bool PermissionManager::canUpdate(const Requester& requester, uint64_t service_id, Http::Error& error)
+void PermissionManager::canUpdate(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
     const std::string service_name = T::getTableName();
 
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
-
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 template <Service_t T>
-bool PermissionManager::canDelete(const Requester& requester, const uint64_t service_id, Http::Error& error)
+void PermissionManager::canDelete(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
     const std::string service_name = T::getTableName();
 
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
-
-    return pm_priv::isOwnerOfService(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOfService(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 template <typename T>
-bool PermissionManager::canManageStaff(const Requester& requester, uint64_t service_id, Http::Error& error)
+void PermissionManager::canManageStaff(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
-    std::string service_name = T::getTableName();
-
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
+    const std::string service_name = T::getTableName();
 
-    return pm_priv::isOwnerOrAdmin(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdmin(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 template <Case_t T>
@@ -107,32 +139,76 @@ bool PermissionManager::canCreate(const Requester& requester, const std::optiona
 }
 
 template <Case_t T>
-bool PermissionManager::canRead(const Requester& requester, const uint64_t _id, Http::Error& error)
+bool PermissionManager::canCreateWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error)
 {
     std::string service_name = T::getTableName();
 
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getPermissionsQueryForRead, _id);
+    // no row means the parent entity does not exist, treated like getPermissionsOfEntity does
+    std::optional<jsoncons::json> found = permissions_j.has_value() && !permissions_j->empty() ? permissions_j : std::nullopt;
 
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    return pm_priv::isOwnerOrAdminOrHasPermission(requester, found, service_name, error);
 }
 
 template <Case_t T>
-bool PermissionManager::canUpdate(const Requester& requester, const uint64_t _id, Http::Error& error)
+void PermissionManager::canRead(const Requester& requester, uint64_t _id, Decision&& decision)
 {
-    std::string service_name = T::getTableName();
+    const std::string service_name = T::getTableName();
 
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(&T::getPermissionsQueryForUpdate, _id);
+    decideBatched(T::getPermissionsBatchQuery(service_name), "patient_id", _id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
+}
+
+template <Case_t T>
+bool PermissionManager::canReadWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error)
+{
+    std::string service_name = T::getTableName();
 
     return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
 }
 
 template <Case_t T>
-bool PermissionManager::canDelete(const Requester& requester, const uint64_t _id, Http::Error& error)
+void PermissionManager::canUpdate(const Requester& requester, uint64_t _id, Decision&& decision)
 {
-    std::string                   service_name  = T::getTableName();
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(&T::getPermissionsQueryForDelete, _id);
+    const std::string service_name = T::getTableName();
 
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    decideBatched(T::getPermissionsBatchQuery(service_name), "patient_id", _id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
+}
+
+template <Case_t T>
+void PermissionManager::canDelete(const Requester& requester, uint64_t _id, Decision&& decision)
+{
+    const std::string service_name = T::getTableName();
+
+    decideBatched(T::getPermissionsBatchQuery(service_name), "patient_id", _id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
+}
+
+template <Case_t T>
+bool PermissionManager::canCreateMany(const Requester& requester, const std::vector<uint64_t>& parent_ids, Http::Error& error)
+{
+    return pm_priv::isOwnerOrAdminOrHasPermissionForAll(requester, T::getPermissionsBatchQueryForCreate(), "parent_id", "clinic_id", parent_ids,
+        T::getTableName(), error);
+}
+
+template <Case_t T>
+bool PermissionManager::canUpdateMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error)
+{
+    return pm_priv::isOwnerOrAdminOrHasPermissionForAll(requester, T::getPermissionsBatchQuery(T::getTableName()), "patient_id", "clinic_id", ids,
+        T::getTableName(), error);
+}
+
+template <Case_t T>
+bool PermissionManager::canDeleteMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error)
+{
+    return pm_priv::isOwnerOrAdminOrHasPermissionForAll(requester, T::getPermissionsBatchQuery(T::getTableName()), "patient_id", "clinic_id", ids,
+        T::getTableName(), error);
 }
 
 template <Appointment_t T>
@@ -146,46 +222,50 @@ bool PermissionManager::canCreate(const Requester& requester, const std::optiona
     {
         return false;
     }
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id.value());
+    std::optional<jsoncons::json> permissions_j =
+        pm_priv::getPermissionsOfEntityAlone(T::getServicePermissionsBatchQuery(service_name), "id", service_id.value());
 
     return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
 }
 
 template <Appointment_t T>
-bool PermissionManager::canRead(const Requester& requester, uint64_t service_id, Http::Error& error)
+void PermissionManager::canRead(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
-    std::string service_name = T::getOrgName();
-
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
+    const std::string service_name = T::getOrgName();
 
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 template <Appointment_t T>
-bool PermissionManager::canUpdate(const Requester& requester, const uint64_t service_id, Http::Error& error)
+void PermissionManager::canUpdate(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
-    std::string service_name = T::getOrgName();
-
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
+    const std::string service_name = T::getOrgName();
 
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 template <Appointment_t T>
-bool PermissionManager::canDelete(const Requester& requester, uint64_t service_id, Http::Error& error)
+void PermissionManager::canDelete(const Requester& requester, uint64_t service_id, Decision&& decision)
 {
-    std::string service_name = T::getOrgName();
+    const std::string service_name = T::getOrgName();
 
-    std::optional<jsoncons::json> permissions_j = pm_priv::getPermissionsOfEntity(T::getServicePermissionsQuery, service_name, service_id);
-
-    return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error);
+    decideBatched(T::getServicePermissionsBatchQuery(service_name), "id", service_id,
+        [requester, service_name](const std::optional<jsoncons::json>& permissions_j, HttpError& error)
+        { return pm_priv::isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, error); },
+        std::move(decision));
 }
 
 #define INSTANTIATE_PERMISSION_CRUD(TYPE)                                                                                 \
     template bool PermissionManager::canCreate<TYPE>(const Requester&, const std::optional<jsoncons::json>&, HttpError&); \
-    template bool PermissionManager::canRead<TYPE>(const Requester&, const uint64_t entity_id, HttpError&);               \
-    template bool PermissionManager::canUpdate<TYPE>(const Requester&, const uint64_t entity_id, HttpError&);             \
-    template bool PermissionManager::canDelete<TYPE>(const Requester&, const uint64_t entity_id, HttpError&);
+    template void PermissionManager::canRead<TYPE>(const Requester&, uint64_t entity_id, Decision&&);                     \
+    template void PermissionManager::canUpdate<TYPE>(const Requester&, uint64_t entity_id, Decision&&);                   \
+    template void PermissionManager::canDelete<TYPE>(const Requester&, uint64_t entity_id, Decision&&);
 
 #define INSTANTIATE_PERMISSION_CLIENT(TYPE)                                                                                 \
     INSTANTIATE_PERMISSION_CRUD(TYPE)                                                                                       \
@@ -194,7 +274,15 @@ bool PermissionManager::canDelete(const Requester& requester, uint64_t service_i
 
 #define INSTANTIATE_PERMISSION_ENTITY(TYPE) \
     INSTANTIATE_PERMISSION_CRUD(TYPE)       \
-    template bool PermissionManager::canManageStaff<TYPE>(const Requester&, const uint64_t entity_id, HttpError&);
+    template void PermissionManager::canManageStaff<TYPE>(const Requester&, uint64_t entity_id, Decision&&);
+
+#define INSTANTIATE_PERMISSION_CASE(TYPE)                                                                                                \
+    INSTANTIATE_PERMISSION_CRUD(TYPE)                                                                                                    \
+    template bool PermissionManager::canCreateWithPermissions<TYPE>(const Requester&, const std::optional<jsoncons::json>&, HttpError&); \
+    template bool PermissionManager::canReadWithPermissions<TYPE>(const Requester&, const std::optional<jsoncons::json>&, HttpError&);   \
+    template bool PermissionManager::canCreateMany<TYPE>(const Requester&, const std::vector<uint64_t>&, HttpError&);                    \
+    template bool PermissionManager::canUpdateMany<TYPE>(const Requester&, const std::vector<uint64_t>&, HttpError&);                    \
+    template bool PermissionManager::canDeleteMany<TYPE>(const Requester&, const std::vector<uint64_t>&, HttpError&);
 
 // Client types
 INSTANTIATE_PERMISSION_CLIENT(User)
@@ -207,15 +295,15 @@ INSTANTIATE_PERMISSION_ENTITY(Laboratories)
 INSTANTIATE_PERMISSION_ENTITY(RadiologyCenters)
 
 // Regular entities with CRUD
-INSTANTIATE_PERMISSION_CRUD(Patient)
-INSTANTIATE_PERMISSION_CRUD(Health)
-INSTANTIATE_PERMISSION_CRUD(PatientDrugs)
-INSTANTIATE_PERMISSION_CRUD(Reports)
-INSTANTIATE_PERMISSION_CRUD(Visits)
-INSTANTIATE_PERMISSION_CRUD(VisitDrugs)
-INSTANTIATE_PERMISSION_CRUD(Prescriptions)
-INSTANTIATE_PERMISSION_CRUD(Requests)
-INSTANTIATE_PERMISSION_CRUD(PaidServices)
+INSTANTIATE_PERMISSION_CASE(Patient)
+INSTANTIATE_PERMISSION_CASE(Health)
+INSTANTIATE_PERMISSION_CASE(PatientDrugs)
+INSTANTIATE_PERMISSION_CASE(Reports)
+INSTANTIATE_PERMISSION_CASE(Visits)
+INSTANTIATE_PERMISSION_CASE(VisitDrugs)
+INSTANTIATE_PERMISSION_CASE(Prescriptions)
+INSTANTIATE_PERMISSION_CASE(Requests)
+INSTANTIATE_PERMISSION_CASE(PaidServices)
 
 INSTANTIATE_PERMISSION_CRUD(ClinicAppointment)
 INSTANTIATE_PERMISSION_CRUD(PharmacyAppointment)
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <jsoncons/basic_json.hpp>
 #include <optional>
+#include <vector>
 
 #include "utils/global/concepts.hpp"
 #include "utils/global/http.hpp"
@@ -19,18 +21,22 @@ namespace api::v2
         PermissionManager& operator=(PermissionManager&&)      = default;
         virtual ~PermissionManager()                           = default;
 
+        // the verdict of a check that looks permissions up without blocking, handed over on the calling loop once they
+        // arrived, error tells why the check failed
+        using Decision = std::function<void(bool allowed, const Http::Error& error)>;
+
         // client is either user or provider
         template <Client_t T>
         bool canCreate(const Requester& requester, const std::optional<jsoncons::json>& data_j, Http::Error& error);
 
         template <Client_t T>
-        bool canRead(const Requester& requester, uint64_t client_id, Http::Error& error);
+        void canRead(const Requester& requester, uint64_t client_id, Decision&& decision);
 
         template <Client_t T>
-        bool canUpdate(const Requester& requester, uint64_t client_id, Http::Error& error);
+        void canUpdate(const Requester& requester, uint64_t client_id, Decision&& decision);
 
         template <Client_t T>
-        bool canDelete(const Requester& requester, uint64_t client_id, Http::Error& error);
+        void canDelete(const Requester& requester, uint64_t client_id, Decision&& decision);
 
         template <Client_t T>
         bool canToggleActive(const Requester& requester, uint64_t client_id, Http::Error& error);
@@ -43,43 +49,62 @@ namespace api::v2
         bool canCreate(const Requester& requester, const std::optional<jsoncons::json>& service_j, Http::Error& error);
 
         template <Service_t T>
-        bool canRead(const Requester& requester, uint64_t service_id, Http::Error& error);
+        void canRead(const Requester& requester, uint64_t service_id, Decision&& decision);
 
         template <Service_t T>
-        bool canUpdate(const Requester& requester, uint64_t service_id, Http::Error& error);
+        void canUpdate(const Requester& requester, uint64_t service_id, Decision&& decision);
 
         template <Service_t T>
-        bool canDelete(const Requester& requester, uint64_t service_id, Http::Error& error);
+        void canDelete(const Requester& requester, uint64_t service_id, Decision&& decision);
 
         template <typename T>
-        bool canManageStaff(const Requester& requester, uint64_t service_id, Http::Error& error);
+        void canManageStaff(const Requester& requester, uint64_t service_id, Decision&& decision);
 
         // case is a data set inside clinic workflow
 
         template <Case_t T>
         bool canCreate(const Requester& requester, const std::optional<jsoncons::json>& data_j, Http::Error& error);
 
+        // same decision as canCreate, from permissions the caller already fetched (see getPermissionsStatementForCreate)
+        template <Case_t T>
+        bool canCreateWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error);
+
+        template <Case_t T>
+        void canRead(const Requester& requester, uint64_t case_id, Decision&& decision);
+
+        // same decision as canRead, from permissions fetched together with the entity (see getSqlReadWithPermissionsStatement)
+        template <Case_t T>
+        bool canReadWithPermissions(const Requester& requester, const std::optional<jsoncons::json>& permissions_j, Http::Error& error);
+
+        template <Case_t T>
+        void canUpdate(const Requester& requester, uint64_t case_id, Decision&& decision);
+
+        template <Case_t T>
+        void canDelete(const Requester& requester, uint64_t _id, Decision&& decision);
+
+        // same decisions as canCreate/canUpdate/canDelete for many entities at once, their permissions are fetched with
+        // one query and decided once per clinic, canCreateMany takes the ids of the parents the rows are created under
         template <Case_t T>
-        bool canRead(const Requester& requester, uint64_t case_id, Http::Error& error);
+        bool canCreateMany(const Requester& requester, const std::vector<uint64_t>& parent_ids, Http::Error& error);
 
         template <Case_t T>
-        bool canUpdate(const Requester& requester, uint64_t case_id, Http::Error& error);
+        bool canUpdateMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error);
 
         template <Case_t T>
-        bool canDelete(const Requester& requester, uint64_t _id, Http::Error& error);
+        bool canDeleteMany(const Requester& requester, const std::vector<uint64_t>& ids, Http::Error& error);
 
         // appointment is either for any service
         template <Appointment_t T>
         bool canCreate(const Requester& requester, const std::optional<jsoncons::json>& service_j, Http::Error& error);
 
         template <Appointment_t T>
-        bool canRead(const Requester& requester, uint64_t service_id, Http::Error& error);
+        void canRead(const Requester& requester, uint64_t service_id, Decision&& decision);
 
         template <Appointment_t T>
-        bool canUpdate(const Requester& requester, uint64_t service_id, Http::Error& error);
+        void canUpdate(const Requester& requester, uint64_t service_id, Decision&& decision);
 
         template <Appointment_t T>
-        bool canDelete(const Requester& requester, uint64_t _id, Http::Error& error);
+        void canDelete(const Requester& requester, uint64_t _id, Decision&& decision);
 
        private:
     };
@@ -2,16 +2,24 @@
 
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <fmt/ranges.h>
 
 #include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <jsoncons/basic_json.hpp>
 #include <jsoncons/json.hpp>
+#include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/preparedstatement.hpp"
 #include "gatekeeper/permissionmanager/permissions.hpp"
+#include "store/store.hpp"
 #include "utils/global/http.hpp"
 #include "utils/global/requester.hpp"
 
@@ -187,3 +195,66 @@ bool api::v2::PermissionManagerPrivate::isOwnerOrAdmin(
 {
     return (isOwnerOfService(requester, permissions_j, service_name, error) || isAdminOfService(requester, permissions_j, service_name, error));
 }
+
+bool api::v2::PermissionManagerPrivate::isOwnerOrAdminOrHasPermissionForAll(const Requester& requester, const std::string& sql, const std::string& key_column,
+    const std::string& group_column, const std::vector<uint64_t>& ids, const std::string& service_name, Http::Error& error)
+{
+    if (ids.empty())
+    {
+        return true;
+    }
+
+    static std::shared_ptr<DatabaseController> db_ctl = Store::getObject<DatabaseController>();
+
+    std::unordered_map<uint64_t, uint64_t> groups;  // id -> service
+    std::unordered_map<uint64_t, bool>     decided;  // service -> allowed
+
+    try
+    {
+        std::optional<jsoncons::json::array> found = db_ctl->executeSearchPrepared(PreparedStatement(sql, {fmt::format("{{{}}}", fmt::join(ids, ","))}));
+
+        if (!found.has_value())
+        {
+            error.code    = Http::Status::INTERNAL_SERVER_ERROR;
+            error.message = "Failed to get service permissions for " + service_name;
+            return false;
+        }
+
+        for (const auto& row : found.value())
+        {
+            uint64_t group = row.at(group_column).as<uint64_t>();
+            groups.emplace(row.at(key_column).as<uint64_t>(), group);
+
+            if (decided.contains(group))
+            {
+                continue;
+            }
+
+            std::optional<jsoncons::json> permissions_j = row;
+            Http::Error                   group_error{};
+            decided.emplace(group, isOwnerOrAdminOrHasPermission(requester, permissions_j, service_name, group_error));
+            if (!decided.at(group))
+            {
+                error = group_error;
+                return false;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        error.code    = Http::Status::INTERNAL_SERVER_ERROR;
+        error.message = fmt::format("Failed to get service permissions for {}, {}", service_name, e.what());
+        return false;
+    }
+
+    for (uint64_t id : ids)
+    {
+        if (!groups.contains(id))
+        {
+            error.code    = Http::Status::NOT_FOUND;
+            error.message = fmt::format("{} with id {} is not found", service_name, id);
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <fmt/core.h>
 
 #include <cstdint>
 #include <exception>
@@ -6,8 +7,12 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/preparedstatement.hpp"
+#include "gatekeeper/permissionmanager/permissionbatcher.hpp"
 #include "gatekeeper/permissionmanager/permissions.hpp"
 #include "store/store.hpp"
 #include "utils/global/http.hpp"
@@ -47,6 +52,11 @@ namespace api::v2
         static bool isOwnerOrAdmin(
             const Requester& requester, const std::optional<jsoncons::json>& permissions_j, const std::string& service_name, Http::Error& error);
 
+        // isOwnerOrAdminOrHasPermission for every id, sql selects the permission rows of an array of ids bound as $1, key_column
+        // names the id of a row and group_column the service it belongs to; every service is decided once
+        static bool isOwnerOrAdminOrHasPermissionForAll(const Requester& requester, const std::string& sql, const std::string& key_column,
+            const std::string& group_column, const std::vector<uint64_t>& ids, const std::string& service_name, Http::Error& error);
+
         template <typename T>
         static std::optional<T> extract_json_value_safely(
             const std::optional<jsoncons::json>& service_j, const std::string& key, const std::string& service_name, Http::Error& error)
@@ -100,6 +110,35 @@ namespace api::v2
             return permissions_j;
         }
 
+        // same as getPermissionsOfEntity for a statement selecting the rows of an array of ids, the lookup is grouped with
+        // the other lookups of the same table on the calling loop and callback gets the row of id once it arrived
+        static void getPermissionsOfEntityBatched(const std::string& sql, const std::string& key_column, uint64_t id, PermissionBatcher::Callback&& callback)
+        {
+            static std::shared_ptr<PermissionBatcher> batcher = Store::getObject<PermissionBatcher>();
+            batcher->lookup(sql, key_column, id, std::move(callback));
+        }
+
+        // the row of id from the same statement, looked up on its own and waited for
+        static std::optional<jsoncons::json> getPermissionsOfEntityAlone(const std::string& sql, const std::string& key_column, uint64_t id)
+        {
+            static std::shared_ptr<DatabaseController> db_ctl = Store::getObject<DatabaseController>();
+            std::optional<jsoncons::json::array>       rows   = db_ctl->executeSearchPrepared(PreparedStatement(sql, {fmt::format("{{{}}}", id)}));
+
+            if (!rows.has_value())
+            {
+                return std::nullopt;
+            }
+
+            for (const auto& row : rows.value())
+            {
+                if (row.at(key_column).as<uint64_t>() == id)
+                {
+                    return row;
+                }
+            }
+            return std::nullopt;
+        }
+
        private:
     };
 
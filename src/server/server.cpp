@@ -10,22 +10,28 @@
 #include <fmt/core.h>
 #include <trantor/utils/Logger.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "api/v2/all_routes.hpp"  // IWYU pragma: keep
 #include "api/v2/middlewares/elapsedtime.hpp"
 #include "configurator/configurator.hpp"
+#include "entities/services/clinics/patient/patient.hpp"
+#include "entities/services/clinics/visits/visits.hpp"
 #include "server/extras/banner.hpp"
 #include "store/store.hpp"
 #include "utils/Logger/logger.hpp"
 #include "utils/jsonhelper/jsonhelper.hpp"
 #include "utils/message/message.hpp"
 #include "validator/databaseschema/databaseschema.hpp"
+#include "validator/databaseschema/entitydeclaration.hpp"
+#include "validator/databaseschema/schemawatcher.hpp"
 #ifndef GIT_TAG
 #    define GIT_TAG "unknown"
 #endif
@@ -34,7 +40,10 @@ Server::Server()
       configurator_(Store::getObject<Configurator>()),
       config_(configurator_->get<Configurator::ServerConfig>()),
       db_config_(configurator_->get<Configurator::DatabaseConfig>()),
-      databaseSchema_(Store::getObject<DatabaseSchema>()),
+      databaseSchema_(Store::getObject<DatabaseSchema>(std::vector<EntityDeclaration>{
+          {.table = Patient::getTableName(), .columns = Patient::getColumns(), .indexes = Patient::getSearchIndexes()},
+          {.table = Visits::getTableName(), .columns = Visits::getColumns(), .indexes = {}}})),
+      schemaWatcher_(Store::getObject<SchemaWatcher>()),
       auth_filter_(std::make_shared<api::v2::Filters::Auth>()),
       elapsed_time_(std::make_shared<api::v2::MiddleWares::ElapsedTime>()),
       rate_limit_(std::make_shared<api::v2::Filters::RateLimit>())
@@ -50,12 +59,22 @@ int Server::run()
             .addListener(std::string(config_.host), config_.port)
             .setThreadNum(config_.threads)
             .setUploadPath(config_.upload_dir)
+            // drogon reads every body against one limit, it admits an import and the advice below holds other routes
+            // to max_body_size. Bodies beyond drogon's memory limit are buffered in a temporary file, not in memory
+            .setClientMaxBodySize(std::max(config_.max_body_size, config_.import_max_body_size))
             .disableSigtermHandling()
             .setLogLevel(static_cast<trantor::Logger::LogLevel>(config_.debug_level))
             .registerPreRoutingAdvice(
-                [](const drogon::HttpRequestPtr& req, drogon::AdviceCallback&& callback, drogon::AdviceChainCallback&& chainedcallback)
+                [maxBodySize = config_.max_body_size](
+                    const drogon::HttpRequestPtr& req, drogon::AdviceCallback&& callback, drogon::AdviceChainCallback&& chainedcallback)
                 {
-                    if (req->method() == drogon::Options)
+                    if (req->body().size() > maxBodySize && !req->path().ends_with("/import"))
+                    {
+                        auto resp = drogon::HttpResponse::newHttpJsonResponse(api::v2::JsonHelper::jsonify("Request body is too large."));
+                        resp->setStatusCode(drogon::k413RequestEntityTooLarge);
+                        std::move(callback)(resp);
+                    }
+                    else if (req->method() == drogon::Options)
                     {
                         auto resp = drogon::HttpResponse::newHttpResponse();
                         resp->setStatusCode(drogon::k204NoContent);
@@ -111,7 +130,11 @@ void Server::print_banner()
     Banner::print(" - Version", GIT_TAG, fmt::color::light_green, fmt::color::yellow);
     Banner::print(" - Port", config_.port, fmt::color::light_green, fmt::color::yellow);
     Banner::print(" - Threads", config_.threads, fmt::color::light_green, fmt::color::yellow);
-    Banner::print(" - Database", fmt::format("{} {}", db_config_.max_conn, "connections"), fmt::color::light_green, fmt::color::yellow);
+    Banner::print(" - Database", fmt::format("{}-{} {}", db_config_.min_conn, db_config_.max_conn, "connections"), fmt::color::light_green, fmt::color::yellow);
+    if (!db_config_.replica_hosts.empty())
+    {
+        Banner::print(" - Replicas", fmt::format("{} {}", db_config_.replica_hosts.size(), "hosts"), fmt::color::light_green, fmt::color::yellow);
+    }
     Banner::print_line();
     std::flush(std::cout);
 }
@@ -9,6 +9,7 @@
 
 class Logger;
 class DatabaseSchema;
+class SchemaWatcher;
 
 class Server
 {
@@ -31,6 +32,7 @@ class Server
     Configurator::ServerConfig                         config_;
     Configurator::DatabaseConfig                       db_config_;
     std::shared_ptr<DatabaseSchema>                    databaseSchema_;
+    std::shared_ptr<SchemaWatcher>                     schemaWatcher_;
     std::shared_ptr<api::v2::Filters::Auth>            auth_filter_;
     std::shared_ptr<api::v2::MiddleWares::ElapsedTime> elapsed_time_;
     std::shared_ptr<api::v2::Filters::RateLimit>       rate_limit_;
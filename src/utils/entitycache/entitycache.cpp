@@ -0,0 +1,172 @@
+#include "utils/entitycache/entitycache.hpp"
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "configurator/configurator.hpp"
+#include "store/store.hpp"
+#include "utils/message/message.hpp"
+
+EntityCache::EntityCache()
+{
+    auto                                configurator = Store::getObject<Configurator>();
+    const Configurator::CacheConfig    &config       = configurator->get<Configurator::CacheConfig>();
+    const Configurator::DatabaseConfig &database     = configurator->get<Configurator::DatabaseConfig>();
+
+    maxEntry_   = config.entity_cache_max_entry;
+    replicaLag_ = database.replica_hosts.empty() ? std::chrono::milliseconds::zero() : database.replica_max_lag;
+    maxSlots_   = static_cast<std::size_t>(config.entity_cache_size) * 2;
+    pruneAt_    = maxSlots_;
+
+    if (config.entity_cache_size != 0)
+    {
+        cache_ = std::make_unique<MemCache<std::string>>(config.entity_cache_size, config.entity_cache_ttl);
+    }
+}
+
+std::optional<EntityCache::Ticket> EntityCache::ticket(const std::string &table, uint64_t id, const std::unordered_set<std::string> &columns)
+{
+    if (cache_ == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    // the same projection may arrive in any order
+    std::vector<std::string> sorted(columns.begin(), columns.end());
+    std::ranges::sort(sorted);
+
+    Ticket ticket{.entity = entityKey(table, id), .key = {}, .version = 0};
+    ticket.key = fmt::format("{}:{}", ticket.entity, fmt::join(sorted, ","));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        slot = slots_.find(ticket.entity);
+    ticket.version                   = slot != slots_.end() ? slot->second.version : floor_;
+    return ticket;
+}
+
+std::optional<std::string> EntityCache::get(const Ticket &ticket)
+{
+    if (cache_ == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<std::string> body = cache_->get(ticket.key);
+
+    std::atomic<uint64_t> &counter = body.has_value() ? hits_ : misses_;
+    counter.fetch_add(1, std::memory_order_relaxed);
+
+    if ((hits() + misses()) % REPORT_INTERVAL == 0)
+    {
+        report();
+    }
+
+    return body;
+}
+
+bool EntityCache::contains(const Ticket &ticket) { return cache_ != nullptr && cache_->contains(ticket.key); }
+
+void EntityCache::insert(const Ticket &ticket, const std::string &body)
+{
+    if (cache_ == nullptr || body.size() > maxEntry_)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        slot = slots_.find(ticket.entity);
+
+    if (slot == slots_.end())
+    {
+        if (ticket.version != floor_ || Clock::now() < floorDirtyUntil_)
+        {
+            return;
+        }
+        slot = slots_.emplace(ticket.entity, Slot{.version = floor_, .dirtyUntil = {}, .keys = {}}).first;
+    }
+    else if (slot->second.version != ticket.version || Clock::now() < slot->second.dirtyUntil)
+    {
+        // written while the read was in flight, or recently enough that a replica may have served the old row
+        return;
+    }
+
+    slot->second.keys.insert(ticket.key);
+    cache_->insert(ticket.key, body);
+
+    if (slots_.size() > pruneAt_)
+    {
+        prune();
+    }
+}
+
+void EntityCache::invalidate(const std::string &table, uint64_t id)
+{
+    if (cache_ == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot                       &slot = slots_[entityKey(table, id)];
+
+    slot.version    = ++nextVersion_;
+    slot.dirtyUntil = Clock::now() + replicaLag_;
+
+    for (const auto &key : slot.keys)
+    {
+        cache_->remove(key);
+    }
+    slot.keys.clear();
+
+    if (slots_.size() > pruneAt_)
+    {
+        prune();
+    }
+}
+
+std::string EntityCache::entityKey(const std::string &table, uint64_t id) { return fmt::format("{}:{}", table, id); }
+
+void EntityCache::prune()
+{
+    Clock::time_point now = Clock::now();
+
+    // past the bound the slots still dirty go too, the floor keeps their protection
+    bool full = slots_.size() > maxSlots_;
+
+    for (auto slot = slots_.begin(); slot != slots_.end();)
+    {
+        std::erase_if(slot->second.keys, [this](const std::string &key) { return !cache_->contains(key); });
+
+        if (slot->second.keys.empty() && (full || now >= slot->second.dirtyUntil))
+        {
+            // tickets taken against this slot must not match a fresh one
+            floor_           = std::max(floor_, slot->second.version);
+            floorDirtyUntil_ = std::max(floorDirtyUntil_, slot->second.dirtyUntil);
+            slot             = slots_.erase(slot);
+            continue;
+        }
+        ++slot;
+    }
+
+    // slots still dirty are dropped on a later pass, do not rescan on every write until then
+    pruneAt_ = std::min(std::max(maxSlots_ / 2, slots_.size() * 2), maxSlots_);
+}
+
+void EntityCache::report()
+{
+    uint64_t hit_count  = hits();
+    uint64_t miss_count = misses();
+
+    Message::InfoMessage(fmt::format("Entity cache: {} hits, {} misses, {:.1f}% hit rate.", hit_count, miss_count,
+        100.0 * static_cast<double>(hit_count) / static_cast<double>(std::max<uint64_t>(hit_count + miss_count, 1))));
+}
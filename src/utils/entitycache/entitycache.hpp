@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "utils/memcache/memcache.hpp"
+
+/// Read-through cache of entity read responses keyed by (table, id, projected columns).
+/// Every cached key is indexed under its (table, id) so a write to the entity drops all
+/// of its projections at once. Each entity carries a version bumped by invalidate, a read
+/// takes a ticket before it queries and its response is only stored if the version did not
+/// move meanwhile, so a read racing a write never caches the old row.
+/// Invalidation is local to this process, another instance keeps serving its own copy of a
+/// row written here until the copy expires, so instances may be stale for up to the TTL.
+/// The index holds at most two slots per cache entry, slots of invalidated entities are
+/// pruned as they pile up and their versions folded into a floor every later ticket starts at.
+class EntityCache
+{
+   public:
+    struct Ticket
+    {
+        std::string entity;  // table:id
+        std::string key;     // table:id:columns
+        uint64_t    version;
+    };
+
+    EntityCache();
+    EntityCache(const EntityCache &)            = delete;
+    EntityCache(EntityCache &&)                 = delete;
+    EntityCache &operator=(const EntityCache &) = delete;
+    EntityCache &operator=(EntityCache &&)      = delete;
+    virtual ~EntityCache()                      = default;
+
+    // nullopt if the cache is disabled
+    std::optional<Ticket> ticket(const std::string &table, uint64_t id, const std::unordered_set<std::string> &columns);
+
+    std::optional<std::string> get(const Ticket &ticket);
+    // whether get would hit, without counting a lookup
+    bool                       contains(const Ticket &ticket);
+    void                       insert(const Ticket &ticket, const std::string &body);
+    void                       invalidate(const std::string &table, uint64_t id);
+
+    [[nodiscard]] uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot
+    {
+        uint64_t                        version = 0;
+        Clock::time_point               dirtyUntil;  // a replica may still serve the old row until then
+        std::unordered_set<std::string> keys;
+    };
+
+    static std::string entityKey(const std::string &table, uint64_t id);
+
+    // drops the index slots whose entries are all gone from the cache
+    void prune();
+    void report();
+
+    std::size_t               maxEntry_;
+    std::chrono::milliseconds replicaLag_;
+
+    std::unique_ptr<MemCache<std::string>> cache_;  // null if disabled
+
+    std::mutex                            mutex_;
+    std::unordered_map<std::string, Slot> slots_;
+    std::size_t                           maxSlots_;
+    std::size_t                           pruneAt_;
+    uint64_t                              nextVersion_ = 0;
+    uint64_t                              floor_       = 0;  // highest version of a pruned slot
+    Clock::time_point                     floorDirtyUntil_;  // latest dirtyUntil of a pruned slot
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    static constexpr uint64_t REPORT_INTERVAL = 10000;  // lookups
+};
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <chrono>
 #include <condition_variable>
 #include <list>
@@ -103,6 +105,14 @@ class MemCache
         return item->second->getValue();
     }
 
+    // like get but neither copies the value nor refreshes its position
+    bool contains(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        item = cacheMap_.find(key);
+        return item != cacheMap_.end() && item->second->getExpiration() > Clock::now();
+    }
+
     bool remove(const std::string& key)
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design).
+// Every cell carries a sequence number telling producers and consumers whose turn it is,
+// so push and pop only contend on a single compare-exchange of their own cursor.
+template <typename T>
+class MPMCQueue
+{
+   public:
+    explicit MPMCQueue(size_t capacity) : mask_(std::bit_ceil(capacity < 2 ? size_t{2} : capacity) - 1), cells_(std::make_unique<Cell[]>(mask_ + 1))
+    {
+        for (size_t index = 0; index <= mask_; ++index)
+        {
+            cells_[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+    MPMCQueue()                             = delete;
+    MPMCQueue(const MPMCQueue &)            = delete;
+    MPMCQueue(MPMCQueue &&)                 = delete;
+    MPMCQueue &operator=(const MPMCQueue &) = delete;
+    MPMCQueue &operator=(MPMCQueue &&)      = delete;
+    virtual ~MPMCQueue()                    = default;
+
+    // returns false if the queue is full, value is left untouched in that case
+    bool try_push(T &&value);
+
+    // returns false if the queue is empty
+    bool try_pop(T &value);
+
+    // approximate, only meaningful while no other thread touches the queue
+    [[nodiscard]] size_t size() const
+    {
+        size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+        size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+        return enqueued >= dequeued ? enqueued - dequeued : 0;
+    }
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+   private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T                   value;
+    };
+
+    const size_t            mask_;
+    std::unique_ptr<Cell[]> cells_;  // NOLINT
+
+    alignas(CACHE_LINE) std::atomic<size_t> enqueuePos_{0};
+    alignas(CACHE_LINE) std::atomic<size_t> dequeuePos_{0};
+};
+
+template <typename T>
+bool MPMCQueue<T>::try_push(T &&value)
+{
+    Cell  *cell     = nullptr;
+    size_t position = enqueuePos_.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        cell                = &cells_[position & mask_];
+        size_t   sequence   = cell->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+        if (difference == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = std::move(value);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool MPMCQueue<T>::try_pop(T &value)
+{
+    Cell  *cell     = nullptr;
+    size_t position = dequeuePos_.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        cell                = &cells_[position & mask_];
+        size_t   sequence   = cell->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+        if (difference == 0)
+        {
+            if (dequeuePos_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    value       = std::move(cell->value);
+    cell->value = T();
+    cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+    return true;
+}
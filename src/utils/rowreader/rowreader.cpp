@@ -0,0 +1,328 @@
+#include "utils/rowreader/rowreader.hpp"
+
+#include <fmt/core.h>
+
+#include <charconv>
+#include <cstdint>
+#include <exception>
+#include <jsoncons/basic_json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/global/types.hpp"
+
+namespace
+{
+    bool isBlank(std::string_view line) { return line.find_first_not_of(" \t\r\n") == std::string_view::npos; }
+}  // namespace
+
+RowReader::RowReader(std::string_view body, Format format, const std::unordered_set<api::v2::ColumnInfo> &schema) : body_(body), format_(format)
+{
+    types_.reserve(schema.size());
+    for (const auto &column : schema)
+    {
+        types_.emplace(column.Name, column.DataType);
+    }
+}
+
+std::optional<RowReader::Format> RowReader::formatOf(std::string_view contentType)
+{
+    // parameters such as the charset do not matter
+    std::string_view media = contentType.substr(0, contentType.find(';'));
+    while (!media.empty() && media.back() == ' ')
+    {
+        media.remove_suffix(1);
+    }
+
+    if (media == "application/x-ndjson" || media == "application/ndjson" || media == "application/jsonl")
+    {
+        return Format::NDJSON;
+    }
+    if (media == "text/csv")
+    {
+        return Format::CSV;
+    }
+    return std::nullopt;
+}
+
+RowReader::Result RowReader::next(jsoncons::json &row, std::string &error)
+{
+    return format_ == Format::NDJSON ? readNdjson(row, error) : readCsv(row, error);
+}
+
+std::string_view RowReader::nextLine()
+{
+    size_t end = body_.find('\n', pos_);
+    if (end == std::string_view::npos)
+    {
+        end = body_.size();
+    }
+
+    std::string_view line = body_.substr(pos_, end - pos_);
+    pos_                  = end < body_.size() ? end + 1 : end;
+    return line;
+}
+
+RowReader::Result RowReader::readNdjson(jsoncons::json &row, std::string &error)
+{
+    while (pos_ < body_.size())
+    {
+        std::string_view line = nextLine();
+        if (isBlank(line))
+        {
+            continue;
+        }
+
+        ++row_;
+        try
+        {
+            row = jsoncons::json::parse(line);
+        }
+        catch (const std::exception &e)
+        {
+            error = fmt::format("Invalid json, {}", e.what());
+            return Result::INVALID;
+        }
+
+        if (!row.is_object())
+        {
+            error = "Row is not a json object";
+            return Result::INVALID;
+        }
+        return Result::ROW;
+    }
+    return Result::END;
+}
+
+RowReader::Result RowReader::readCsv(jsoncons::json &row, std::string &error)
+{
+    std::vector<std::optional<std::string>> fields;
+
+    if (header_.empty())
+    {
+        if (isBlank(body_.substr(pos_)))
+        {
+            pos_ = body_.size();
+            return Result::END;
+        }
+
+        if (!readRecord(fields, error))
+        {
+            // without the column names nothing after it can be read
+            pos_  = body_.size();
+            error = fmt::format("Invalid CSV header, {}", error);
+            return Result::INVALID;
+        }
+
+        for (auto &field : fields)
+        {
+            if (!field.has_value() || field->empty())
+            {
+                pos_  = body_.size();
+                error = "Invalid CSV header, a column name is empty";
+                return Result::INVALID;
+            }
+            header_.push_back(std::move(field.value()));
+        }
+
+        if (header_.empty())
+        {
+            return Result::END;
+        }
+    }
+
+    while (pos_ < body_.size())
+    {
+        size_t start = pos_;
+        if (!readRecord(fields, error))
+        {
+            ++row_;
+            return Result::INVALID;
+        }
+
+        // a blank line is one empty unquoted field
+        if (fields.size() == 1 && !fields.front().has_value() && isBlank(body_.substr(start, pos_ - start)))
+        {
+            continue;
+        }
+
+        ++row_;
+        if (fields.size() != header_.size())
+        {
+            error = fmt::format("Expected {} fields, found {}", header_.size(), fields.size());
+            return Result::INVALID;
+        }
+
+        row = jsoncons::json();
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            if (!fields[i].has_value())
+            {
+                continue;
+            }
+
+            jsoncons::json value;
+            if (!toJson(header_[i], fields[i].value(), value, error))
+            {
+                return Result::INVALID;
+            }
+            row[header_[i]] = std::move(value);
+        }
+        return Result::ROW;
+    }
+    return Result::END;
+}
+
+bool RowReader::readRecord(std::vector<std::optional<std::string>> &fields, std::string &error)
+{
+    fields.clear();
+
+    while (true)
+    {
+        std::optional<std::string> field;
+
+        if (pos_ < body_.size() && body_[pos_] == '"')
+        {
+            // quoted field, may hold separators, line breaks and doubled quotes
+            field.emplace();
+            ++pos_;
+            while (true)
+            {
+                if (pos_ >= body_.size())
+                {
+                    error = "Unterminated quoted field";
+                    return false;
+                }
+                char character = body_[pos_++];
+                if (character == '"')
+                {
+                    if (pos_ < body_.size() && body_[pos_] == '"')
+                    {
+                        field->push_back('"');
+                        ++pos_;
+                        continue;
+                    }
+                    break;
+                }
+                field->push_back(character);
+            }
+
+            if (pos_ < body_.size() && body_[pos_] == '\r')
+            {
+                ++pos_;
+            }
+            if (pos_ < body_.size() && body_[pos_] != ',' && body_[pos_] != '\n')
+            {
+                error = "Unexpected character after a quoted field";
+                nextLine();
+                return false;
+            }
+        }
+        else
+        {
+            size_t end = body_.find_first_of(",\n", pos_);
+            if (end == std::string_view::npos)
+            {
+                end = body_.size();
+            }
+
+            std::string_view cell = body_.substr(pos_, end - pos_);
+            if (!cell.empty() && cell.back() == '\r')
+            {
+                cell.remove_suffix(1);
+            }
+            if (!cell.empty())
+            {
+                field.emplace(cell);
+            }
+            pos_ = end;
+        }
+
+        fields.push_back(std::move(field));
+
+        if (pos_ >= body_.size())
+        {
+            return true;
+        }
+        if (body_[pos_++] == '\n')
+        {
+            return true;
+        }
+    }
+}
+
+bool RowReader::toJson(const std::string &column, const std::string &cell, jsoncons::json &value, std::string &error) const
+{
+    auto type = types_.find(column);
+
+    // unknown columns stay text, the schema validation reports them
+    if (type == types_.end())
+    {
+        value = cell;
+        return true;
+    }
+
+    const std::string &dataType = type->second;
+    const char        *first    = cell.data();
+    const char        *last     = cell.data() + cell.size();
+
+    if (dataType == "integer" || dataType == "bigint" || dataType == "smallint")
+    {
+        int64_t number = 0;
+        auto [end, ec] = std::from_chars(first, last, number);
+        if (ec != std::errc() || end != last)
+        {
+            error = fmt::format("Value of column {} is not an integer: {}", column, cell);
+            return false;
+        }
+        value = number;
+        return true;
+    }
+
+    if (dataType == "float" || dataType == "double" || dataType == "real" || dataType == "double precision" || dataType == "numeric")
+    {
+        double number = 0;
+        auto [end, ec] = std::from_chars(first, last, number);
+        if (ec != std::errc() || end != last)
+        {
+            error = fmt::format("Value of column {} is not a number: {}", column, cell);
+            return false;
+        }
+        value = number;
+        return true;
+    }
+
+    if (dataType == "boolean")
+    {
+        static const std::unordered_set<std::string> truthy = {"true", "t", "yes", "1"};
+        static const std::unordered_set<std::string> falsy  = {"false", "f", "no", "0"};
+
+        if (!truthy.contains(cell) && !falsy.contains(cell))
+        {
+            error = fmt::format("Value of column {} is not a boolean: {}", column, cell);
+            return false;
+        }
+        value = truthy.contains(cell);
+        return true;
+    }
+
+    if (dataType == "jsonb" || dataType == "json")
+    {
+        try
+        {
+            value = jsoncons::json::parse(cell);
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            error = fmt::format("Value of column {} is not valid json, {}", column, e.what());
+            return false;
+        }
+    }
+
+    value = cell;
+    return true;
+}
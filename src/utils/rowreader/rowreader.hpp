@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <jsoncons/basic_json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/global/types.hpp"
+
+/// Reads the rows of a bulk import body one at a time, so an import never holds more than one parsed row.
+/// NDJSON rows are taken as they are. CSV rows are keyed by the header record and every cell is converted
+/// to the json type its column has in the table schema; an empty unquoted cell leaves the column out so it
+/// gets its default, a quoted empty cell is an empty string.
+class RowReader
+{
+   public:
+    enum class Format : std::uint8_t
+    {
+        NDJSON,
+        CSV
+    };
+
+    enum class Result : std::uint8_t
+    {
+        ROW,      // row holds the next row
+        INVALID,  // the next row cannot be parsed, error holds why
+        END       // the body is exhausted
+    };
+
+    RowReader(std::string_view body, Format format, const std::unordered_set<api::v2::ColumnInfo> &schema);
+    RowReader(const RowReader &)            = delete;
+    RowReader(RowReader &&)                 = delete;
+    RowReader &operator=(const RowReader &) = delete;
+    RowReader &operator=(RowReader &&)      = delete;
+    virtual ~RowReader()                    = default;
+
+    // the format of a Content-Type header, nullopt if it is none of the supported ones
+    static std::optional<Format> formatOf(std::string_view contentType);
+
+    // reads the next row, a row that cannot be parsed is skipped after reporting it
+    Result next(jsoncons::json &row, std::string &error);
+
+    // number of the row read last, counting from 1, the CSV header is not a row
+    [[nodiscard]] size_t row() const { return row_; }
+
+   private:
+    Result           readNdjson(jsoncons::json &row, std::string &error);
+    Result           readCsv(jsoncons::json &row, std::string &error);
+    std::string_view nextLine();
+    // the fields of the next CSV record, nullopt for an empty unquoted field; false if it is malformed
+    bool readRecord(std::vector<std::optional<std::string>> &fields, std::string &error);
+    bool toJson(const std::string &column, const std::string &cell, jsoncons::json &value, std::string &error) const;
+
+    std::string_view                             body_;
+    size_t                                       pos_ = 0;
+    size_t                                       row_ = 0;
+    Format                                       format_;
+    std::vector<std::string>                     header_;
+    std::unordered_map<std::string, std::string> types_;  // column -> data type
+};
@@ -0,0 +1,79 @@
+#include "utils/searchcount/searchcount.hpp"
+
+#include <fmt/core.h>
+
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "configurator/configurator.hpp"
+#include "store/store.hpp"
+
+SearchCount::SearchCount()
+{
+    auto                             configurator = Store::getObject<Configurator>();
+    const Configurator::CacheConfig &config       = configurator->get<Configurator::CacheConfig>();
+
+    exactLimit_ = config.search_count_exact_limit;
+
+    if (config.search_count_cache_size != 0)
+    {
+        cache_ = std::make_unique<MemCache<Total>>(config.search_count_cache_size, config.search_count_cache_ttl);
+    }
+}
+
+std::optional<SearchCount::Total> SearchCount::get(const PreparedStatement &count)
+{
+    if (cache_ == nullptr)
+    {
+        return std::nullopt;
+    }
+    return cache_->get(key(count));
+}
+
+void SearchCount::insert(const PreparedStatement &count, const Total &total)
+{
+    if (cache_ != nullptr)
+    {
+        cache_->insert(key(count), total);
+    }
+}
+
+std::optional<uint64_t> SearchCount::planRows(std::string_view plan)
+{
+    try
+    {
+        jsoncons::json explained = jsoncons::json::parse(plan);
+        double         rows      = explained.at(0).at("Plan").at("Plan Rows").as<double>();
+        return rows < 0 ? 0 : static_cast<uint64_t>(std::llround(rows));
+    }
+    catch (const std::exception &)
+    {
+        return std::nullopt;
+    }
+}
+
+std::string SearchCount::toJson(const std::optional<Total> &total)
+{
+    if (!total.has_value())
+    {
+        return "null";
+    }
+    return fmt::format(R"({{"total":{},"exact":{}}})", total->rows, total->exact);
+}
+
+std::string SearchCount::key(const PreparedStatement &count)
+{
+    // the statement name already hashes table and condition, the parameters are length prefixed so they cannot run into each other
+    std::string key = count.name;
+    for (const auto &param : count.params)
+    {
+        key += param.has_value() ? fmt::format(":{}:{}", param->size(), param.value()) : ":null";
+    }
+    return key;
+}
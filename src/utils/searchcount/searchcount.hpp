@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "database/preparedstatement.hpp"
+#include "utils/memcache/memcache.hpp"
+
+/// Totals of search results. Up to the exact limit the rows are counted, a count that reaches it stops there and
+/// the planner row estimate of the search is reported instead, so a total never costs more than limit rows read.
+/// Totals are cached briefly, keyed by the count statement and its parameters, i.e. by table and filter.
+class SearchCount
+{
+   public:
+    struct Total
+    {
+        uint64_t rows;
+        bool     exact;
+    };
+
+    SearchCount();
+    SearchCount(const SearchCount &)            = delete;
+    SearchCount(SearchCount &&)                 = delete;
+    SearchCount &operator=(const SearchCount &) = delete;
+    SearchCount &operator=(SearchCount &&)      = delete;
+    virtual ~SearchCount()                      = default;
+
+    std::optional<Total> get(const PreparedStatement &count);
+    void                 insert(const PreparedStatement &count, const Total &total);
+
+    [[nodiscard]] std::size_t exactLimit() const { return exactLimit_; }
+
+    // the "Plan Rows" of the top node of an EXPLAIN (FORMAT JSON) output
+    static std::optional<uint64_t> planRows(std::string_view plan);
+
+    // the total as the value of the count member of a search answer
+    static std::string toJson(const std::optional<Total> &total);
+
+   private:
+    static std::string key(const PreparedStatement &count);
+
+    std::size_t                      exactLimit_;
+    std::unique_ptr<MemCache<Total>> cache_;  // null if disabled
+};
@@ -0,0 +1,288 @@
+#include "utils/searchfilter/searchfilter.hpp"
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <cstddef>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+#include "validator/databaseschema/databaseschema.hpp"
+#include "validator/databaseschema/searchindex.hpp"
+
+namespace
+{
+    // types whose values cannot be compared as a whole with a bound scalar
+    bool isComposite(const std::string &type) { return type == "ARRAY" || type == "json" || type == "jsonb"; }
+}  // namespace
+
+SearchFilter::SearchFilter(const jsoncons::json &expression, std::string table) : expression_(expression), table_(std::move(table))
+{
+    std::shared_ptr<const SCHEMA_t> schema = DatabaseSchema::getDatabaseSchema();
+    auto                            view   = schema->find(fmt::format("{}_safe", table_));
+
+    if (view != schema->end())
+    {
+        for (const auto &column : view->second)
+        {
+            types_.emplace(column.Name, column.DataType);
+        }
+    }
+}
+
+std::optional<SearchFilter::Compiled> SearchFilter::compile(std::string &error) const
+{
+    Compiled compiled;
+    Context  context{.params = &compiled.params, .predicates = &compiled.predicates, .error = &error};
+
+    std::optional<std::string> condition = node(expression_, 0, context);
+    if (!condition.has_value())
+    {
+        return std::nullopt;
+    }
+    compiled.condition = std::move(condition.value());
+    return compiled;
+}
+
+jsoncons::json SearchFilter::describe(const std::vector<Predicate> &predicates)
+{
+    jsoncons::json described = jsoncons::json::array();
+    for (const auto &predicate : predicates)
+    {
+        jsoncons::json item;
+        item["column"]  = predicate.column;
+        item["op"]      = predicate.op;
+        item["indexed"] = predicate.indexed;
+        described.push_back(std::move(item));
+    }
+    return described;
+}
+
+std::optional<std::string> SearchFilter::node(const jsoncons::json &expression, size_t depth, Context &context) const
+{
+    if (depth > MAX_DEPTH)
+    {
+        *context.error = fmt::format("Filter is nested deeper than {} levels.", MAX_DEPTH);
+        return std::nullopt;
+    }
+
+    if (!expression.is_object() || expression.size() != 1)
+    {
+        *context.error = "Every filter node is an object with exactly one operator.";
+        return std::nullopt;
+    }
+
+    const auto        &member = *expression.object_range().begin();
+    const std::string &op     = member.key();
+
+    if (op != "and" && op != "or")
+    {
+        return predicate(op, member.value(), context);
+    }
+
+    if (!member.value().is_array() || member.value().empty())
+    {
+        *context.error = fmt::format("{} expects a non empty array of filters.", op);
+        return std::nullopt;
+    }
+
+    std::vector<std::string> operands;
+    for (const auto &operand : member.value().array_range())
+    {
+        std::optional<std::string> condition = node(operand, depth + 1, context);
+        if (!condition.has_value())
+        {
+            return std::nullopt;
+        }
+        operands.push_back(std::move(condition.value()));
+    }
+
+    return fmt::format("({})", fmt::join(operands, op == "and" ? " AND " : " OR "));
+}
+
+std::optional<std::string> SearchFilter::predicate(const std::string &op, const jsoncons::json &operand, Context &context) const
+{
+    static const std::unordered_set<std::string> ops = {"eq", "in", "range", "prefix", "is_null"};
+
+    if (!ops.contains(op))
+    {
+        *context.error = fmt::format("Unknown filter operator {}.", op);
+        return std::nullopt;
+    }
+
+    if (!operand.is_object() || operand.size() != 1)
+    {
+        *context.error = fmt::format("{} expects an object with exactly one column.", op);
+        return std::nullopt;
+    }
+
+    if (++context.count > MAX_PREDICATES)
+    {
+        *context.error = fmt::format("Filter holds more than {} predicates.", MAX_PREDICATES);
+        return std::nullopt;
+    }
+
+    const auto                &member = *operand.object_range().begin();
+    const std::string         &name   = member.key();
+    const jsoncons::json      &value  = member.value();
+    std::optional<std::string> type   = typeOf(name);
+
+    if (!type.has_value())
+    {
+        *context.error = fmt::format("Unknown filter column {}.", name);
+        return std::nullopt;
+    }
+
+    if (op != "is_null" && isComposite(type.value()))
+    {
+        *context.error = fmt::format("Column {} of type {} only supports is_null.", name, type.value());
+        return std::nullopt;
+    }
+
+    std::string column = PreparedStatement::quoteIdentifier(name);
+    std::string condition;
+    SearchIndex index{.column = name, .kind = SearchIndex::Kind::BTREE};
+
+    if (op == "eq")
+    {
+        if (!isScalar(value))
+        {
+            *context.error = fmt::format("eq on {} expects a string, number or boolean, use is_null for null.", name);
+            return std::nullopt;
+        }
+        condition = fmt::format("{} = {}", column, bind(value, context));
+    }
+    else if (op == "in")
+    {
+        if (!value.is_array() || value.empty() || value.size() > MAX_IN_VALUES)
+        {
+            *context.error = fmt::format("in on {} expects an array of 1 to {} values.", name, MAX_IN_VALUES);
+            return std::nullopt;
+        }
+        for (const auto &item : value.array_range())
+        {
+            if (!isScalar(item))
+            {
+                *context.error = fmt::format("in on {} expects strings, numbers or booleans.", name);
+                return std::nullopt;
+            }
+        }
+        // the array is bound as one parameter, its element type is taken from the column
+        condition = fmt::format("{} = ANY({})", column, bind(jsoncons::json(arrayLiteral(value)), context));
+    }
+    else if (op == "range")
+    {
+        static const std::vector<std::pair<std::string, std::string>> bounds = {{"gt", ">"}, {"gte", ">="}, {"lt", "<"}, {"lte", "<="}};
+
+        if (!value.is_object() || value.empty())
+        {
+            *context.error = fmt::format("range on {} expects an object of gt, gte, lt and lte bounds.", name);
+            return std::nullopt;
+        }
+
+        std::vector<std::string> conditions;
+        for (const auto &[bound, comparison] : bounds)
+        {
+            if (!value.contains(bound))
+            {
+                continue;
+            }
+            if (!isScalar(value.at(bound)))
+            {
+                *context.error = fmt::format("range bound {} on {} expects a string or number.", bound, name);
+                return std::nullopt;
+            }
+            conditions.push_back(fmt::format("{} {} {}", column, comparison, bind(value.at(bound), context)));
+        }
+
+        if (conditions.size() != value.size())
+        {
+            *context.error = fmt::format("range on {} accepts only gt, gte, lt and lte bounds.", name);
+            return std::nullopt;
+        }
+        condition = fmt::format("{}", fmt::join(conditions, " AND "));
+    }
+    else if (op == "prefix")
+    {
+        if (!value.is_string() || !DatabaseSchema::isTextColumn(fmt::format("{}_safe", table_), name))
+        {
+            *context.error = fmt::format("prefix expects a string and a text column, {} is {}.", name, type.value());
+            return std::nullopt;
+        }
+
+        // the same shape as the prefix match of Search, so one index serves both
+        std::string escaped;
+        for (char character : value.as<std::string>())
+        {
+            if (character == '%' || character == '_' || character == '\\')
+            {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(character);
+        }
+        escaped.push_back('%');
+
+        condition = fmt::format("lower({}) LIKE lower({})", column, bind(jsoncons::json(escaped), context));
+        index     = SearchIndex{.column = name, .kind = SearchIndex::Kind::PREFIX};
+    }
+    else
+    {
+        if (!value.is_bool())
+        {
+            *context.error = fmt::format("is_null on {} expects true or false.", name);
+            return std::nullopt;
+        }
+        condition = fmt::format("{} IS {}NULL", column, value.as<bool>() ? "" : "NOT ");
+    }
+
+    if (context.predicates != nullptr)
+    {
+        context.predicates->push_back(Predicate{.column = name, .op = op, .indexed = DatabaseSchema::hasIndex(table_, index)});
+    }
+    return condition;
+}
+
+std::optional<std::string> SearchFilter::typeOf(const std::string &column) const
+{
+    auto type = types_.find(column);
+    if (type == types_.end())
+    {
+        return std::nullopt;
+    }
+    return type->second;
+}
+
+std::string SearchFilter::bind(const jsoncons::json &value, Context &context)
+{
+    context.params->emplace_back(value.as<std::string>());
+    return PreparedStatement::placeholder(context.params->size());
+}
+
+std::string SearchFilter::arrayLiteral(const jsoncons::json &values)
+{
+    std::vector<std::string> elements;
+    elements.reserve(values.size());
+
+    for (const auto &value : values.array_range())
+    {
+        std::string element = "\"";
+        for (char character : value.as<std::string>())
+        {
+            if (character == '"' || character == '\\')
+            {
+                element.push_back('\\');
+            }
+            element.push_back(character);
+        }
+        element.push_back('"');
+        elements.push_back(std::move(element));
+    }
+
+    return fmt::format("{{{}}}", fmt::join(elements, ","));
+}
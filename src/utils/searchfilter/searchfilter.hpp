@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <jsoncons/basic_json.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+
+/// A structured Search filter compiled into a parameterized SQL condition. A node is one of
+///     {"and": [node, ...]}            {"or": [node, ...]}
+///     {"eq": {"column": value}}       {"in": {"column": [value, ...]}}
+///     {"range": {"column": {"gt" | "gte" | "lt" | "lte": value, ...}}}
+///     {"prefix": {"column": "text"}}  {"is_null": {"column": true | false}}
+/// Columns are checked against the safe view of the table, values are always bound and every predicate keeps
+/// its column bare on the left hand side so an index on it can serve the predicate.
+class SearchFilter
+{
+   public:
+    // one predicate of the filter and whether an index of the table serves it
+    struct Predicate
+    {
+        std::string column;
+        std::string op;
+        bool        indexed;
+    };
+
+    // one pass over the expression, the condition numbers its placeholders from $1 and binds params to them
+    struct Compiled
+    {
+        std::string               condition;
+        PreparedStatement::Params params;
+        std::vector<Predicate>    predicates;
+    };
+
+    SearchFilter(const jsoncons::json &expression, std::string table);
+    SearchFilter(const SearchFilter &)            = default;
+    SearchFilter(SearchFilter &&)                 = default;
+    SearchFilter &operator=(const SearchFilter &) = delete;
+    SearchFilter &operator=(SearchFilter &&)      = delete;
+    virtual ~SearchFilter()                       = default;
+
+    // checks and compiles the expression, nullopt with error telling the first thing that is wrong with it
+    [[nodiscard]] std::optional<Compiled> compile(std::string &error) const;
+
+    // the predicates as a json array for a search answer
+    static jsoncons::json describe(const std::vector<Predicate> &predicates);
+
+   private:
+    struct Context
+    {
+        PreparedStatement::Params *params;
+        std::vector<Predicate>    *predicates;
+        std::string               *error;
+        size_t                     count = 0;
+    };
+
+    std::optional<std::string> node(const jsoncons::json &expression, size_t depth, Context &context) const;
+    std::optional<std::string> predicate(const std::string &op, const jsoncons::json &operand, Context &context) const;
+
+    // the column type, nullopt if the safe view has no such column
+    [[nodiscard]] std::optional<std::string> typeOf(const std::string &column) const;
+
+    static std::string bind(const jsoncons::json &value, Context &context);
+    static bool        isScalar(const jsoncons::json &value) { return value.is_string() || value.is_number() || value.is_bool(); }
+    static std::string arrayLiteral(const jsoncons::json &values);
+
+    jsoncons::json                               expression_;
+    std::string                                  table_;
+    std::unordered_map<std::string, std::string> types_;  // column -> data type
+
+    static constexpr size_t MAX_DEPTH      = 8;
+    static constexpr size_t MAX_PREDICATES = 64;
+    static constexpr size_t MAX_IN_VALUES  = 1000;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Coalesces identical concurrent calls: the first caller of a key runs the work and every
+/// caller that arrives while it is in flight gets the same value instead of running it again.
+/// run() blocks the followers until the value is there, so it is only for threads that are not an
+/// event loop; join()/land() is the callback flavour for work that completes asynchronously.
+template <typename Value>
+class SingleFlight
+{
+   public:
+    using Waiter = std::function<void(const Value &)>;
+
+    SingleFlight()                                = default;
+    SingleFlight(const SingleFlight &)            = delete;
+    SingleFlight(SingleFlight &&)                 = delete;
+    SingleFlight &operator=(const SingleFlight &) = delete;
+    SingleFlight &operator=(SingleFlight &&)      = delete;
+    virtual ~SingleFlight()                       = default;
+
+    template <typename Func>
+    Value run(const std::string &key, Func &&func)
+    {
+        std::promise<Value>       promise;
+        std::shared_future<Value> flight;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto                        pending = blocking_.find(key);
+            if (pending != blocking_.end())
+            {
+                flight = pending->second;
+            }
+            else
+            {
+                blocking_.emplace(key, promise.get_future().share());
+            }
+        }
+
+        if (flight.valid())
+        {
+            return flight.get();
+        }
+
+        try
+        {
+            Value value = std::forward<Func>(func)();
+            finish(key);
+            promise.set_value(value);
+            return value;
+        }
+        catch (...)
+        {
+            finish(key);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    // queues the waiter on the flight of key, returns true if the caller leads the flight and must start the work,
+    // which in turn reports its value through land()
+    bool join(const std::string &key, Waiter &&waiter)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [flight, leader] = waiting_.try_emplace(key);
+        flight->second.push_back(std::move(waiter));
+        return leader;
+    }
+
+    // hands the value to every waiter of the flight and closes it, later callers start a new one
+    void land(const std::string &key, const Value &value)
+    {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto                        flight = waiting_.find(key);
+            if (flight == waiting_.end())
+            {
+                return;
+            }
+            waiters = std::move(flight->second);
+            waiting_.erase(flight);
+        }
+
+        for (auto &waiter : waiters)
+        {
+            waiter(value);
+        }
+    }
+
+   private:
+    void finish(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocking_.erase(key);
+    }
+
+    std::mutex                                                 mutex_;
+    std::unordered_map<std::string, std::shared_future<Value>> blocking_;
+    std::unordered_map<std::string, std::vector<Waiter>>       waiting_;
+};
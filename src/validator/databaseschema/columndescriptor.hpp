@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/// A column an entity relies on, declared next to the entity as a constexpr list and checked against the catalog
+/// by DatabaseSchema::verifyColumns at startup and on every reload. Only the columns the server code itself
+/// depends on are declared, the rest of a table is still taken from the catalog. kind names the family of types
+/// the column may have, so widening an integer to a bigint in a migration is not a mismatch.
+struct ColumnDescriptor
+{
+    enum class Kind : std::uint8_t
+    {
+        INTEGER,
+        FLOAT,
+        STRING,
+        BOOLEAN,
+        JSON,
+        TEMPORAL
+    };
+
+    std::string_view name;
+    Kind             kind;
+
+    // whether dataType, as the catalog reports it, is of kind
+    [[nodiscard]] constexpr bool admits(std::string_view dataType) const
+    {
+        switch (kind)
+        {
+            case Kind::INTEGER:
+                return dataType == "smallint" || dataType == "integer" || dataType == "bigint";
+            case Kind::FLOAT:
+                return dataType == "real" || dataType == "double precision" || dataType.starts_with("numeric");
+            case Kind::STRING:
+                return dataType == "text" || dataType.starts_with("character");
+            case Kind::BOOLEAN:
+                return dataType == "boolean";
+            case Kind::JSON:
+                return dataType == "json" || dataType == "jsonb";
+            case Kind::TEMPORAL:
+                return dataType == "date" || dataType.starts_with("time");
+            default:
+                return false;
+        }
+    }
+
+    // whether columns declares name, used to assert at compile time that the keys an entity uses are declared
+    static constexpr bool declares(std::span<const ColumnDescriptor> columns, std::string_view name)
+    {
+        return std::ranges::any_of(columns, [name](const ColumnDescriptor &column) { return column.name == name; });
+    }
+
+    // whether no name is declared twice
+    static constexpr bool unique(std::span<const ColumnDescriptor> columns)
+    {
+        for (size_t index = 0; index < columns.size(); ++index)
+        {
+            if (declares(columns.subspan(index + 1), columns[index].name))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
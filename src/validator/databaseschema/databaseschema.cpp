@@ -2,61 +2,349 @@
 
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <fmt/ranges.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdlib>
+#include <filesystem>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "configurator/configurator.hpp"
 #include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/preparedstatement.hpp"
 #include "store/store.hpp"
+#include "utils/global/types.hpp"
 #include "utils/message/message.hpp"
+#include "validator/databaseschema/columndescriptor.hpp"
+#include "validator/databaseschema/entitydeclaration.hpp"
+#include "validator/databaseschema/schemasnapshot.hpp"
+#include "validator/databaseschema/searchindex.hpp"
+#include "validator/tablevalidator.hpp"
 
-SCHEMA_t DatabaseSchema::databaseSchema;
+std::atomic<std::shared_ptr<const DatabaseSchema::Catalog>> DatabaseSchema::current;
+std::mutex                                                  DatabaseSchema::reloading;
+std::vector<EntityDeclaration>                              DatabaseSchema::declared;
 
-DatabaseSchema::DatabaseSchema()
+DatabaseSchema::DatabaseSchema(std::vector<EntityDeclaration> declarations)
 {
-    auto dbctl  = Store::getObject<DatabaseController>();
-    auto tables = dbctl->getAllTables();
+    std::lock_guard<std::mutex> lock(reloading);
+    declared = std::move(declarations);
 
-    if (!tables.has_value() || tables->empty())
+    const std::filesystem::path path        = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().schema_snapshot;
+    std::optional<std::string>  fingerprint = catalogFingerprint();
+
+    // the snapshot of the last run is used as long as the catalog did not change since
+    std::optional<SchemaSnapshot> snapshot = fingerprint.has_value() && !path.empty() ? SchemaSnapshot::read(path) : std::nullopt;
+
+    if (snapshot.has_value() && snapshot->fingerprint == fingerprint.value())
     {
-        throw std::runtime_error("No tables found in database.\n");
-        Message::ErrorMessage("Exiting...");
-        exit(EXIT_FAILURE); /*NOLINT*/
+        Message::InitMessage(fmt::format("Database schema loaded from {}.", path.string()));
     }
-
-    for (const auto& table : tables.value())
+    else
     {
-        populateSchema(table);
+        snapshot = loadCatalog();
+
+        if (!snapshot.has_value() || snapshot->schema.empty())
+        {
+            throw std::runtime_error("No tables found in database.\n");
+            Message::ErrorMessage("Exiting...");
+            exit(EXIT_FAILURE); /*NOLINT*/
+        }
+
+        if (fingerprint.has_value())
+        {
+            snapshot->fingerprint = fingerprint.value();
+            persist(snapshot.value());
+        }
     }
+
+    publish(std::move(snapshot.value()));
     // printSchema();
-}
 
-void DatabaseSchema::populateSchema(const std::string& tableName)
-{
-    auto dbctl  = Store::getObject<DatabaseController>();
-    auto schema = dbctl->getTableSchema(tableName);
-    if (schema.has_value())
+    if (!verifyEntities())
     {
-        databaseSchema[tableName] = dbctl->getTableSchema(tableName).value();
+        throw std::runtime_error("Database schema does not match the declared entity columns.\n");
     }
-    else
+}
+
+void DatabaseSchema::publish(SchemaSnapshot&& snapshot) { current.store(compile(std::move(snapshot)), std::memory_order_release); }
+
+std::shared_ptr<const DatabaseSchema::Catalog> DatabaseSchema::catalog() { return current.load(std::memory_order_acquire); }
+
+std::shared_ptr<const SCHEMA_t> DatabaseSchema::getDatabaseSchema()
+{
+    // shares ownership of the whole catalog, the map outlives a reload for as long as it is held
+    std::shared_ptr<const Catalog> loaded = catalog();
+    return {loaded, &loaded->schema};
+}
+
+std::shared_ptr<const TableValidator> DatabaseSchema::getValidator(const std::string& tableName)
+{
+    std::shared_ptr<const Catalog> loaded    = catalog();
+    auto                           validator = loaded->validators.find(tableName);
+    if (validator == loaded->validators.end())
     {
-        Message::WarningMessage(fmt::format("Table not found.\n", tableName));
-        Message::ErrorMessage("Exiting...");
-        exit(EXIT_FAILURE); /*NOLINT*/
+        return nullptr;
     }
+    return {loaded, &validator->second};
 }
 
-const SCHEMA_t& DatabaseSchema::getDatabaseSchema() { return databaseSchema; }
-
 void DatabaseSchema::printSchema()
 {
-    for (const auto& [tableName, columns] : databaseSchema)
+    for (const auto& [tableName, columns] : catalog()->schema)
     {
         for (const auto& column : columns)
         {
             fmt::print("{} : {} - {} - {} - {} \n", tableName, column.Name, column.DataType, column.Constraint, column.isNullable);
         }
     }
-}
\ No newline at end of file
+}
+
+bool DatabaseSchema::isTextColumn(const std::string& tableName, const std::string& column)
+{
+    std::shared_ptr<const Catalog> loaded = catalog();
+    auto                           table  = loaded->schema.find(tableName);
+    if (table == loaded->schema.end())
+    {
+        return false;
+    }
+
+    for (const auto& info : table->second)
+    {
+        if (info.Name == column)
+        {
+            return info.DataType == "text" || info.DataType == "character varying" || info.DataType == "character";
+        }
+    }
+    return false;
+}
+
+bool DatabaseSchema::trigramSupported() { return catalog()->trigram; }
+
+bool DatabaseSchema::hasIndex(const std::string& tableName, const SearchIndex& index)
+{
+    std::shared_ptr<const Catalog> loaded      = catalog();
+    auto                           definitions = loaded->indexDefinitions.find(tableName);
+    if (definitions == loaded->indexDefinitions.end())
+    {
+        return false;
+    }
+    return std::ranges::any_of(definitions->second, [&](const std::string& definition) { return index.covers(definition); });
+}
+
+std::optional<std::string> DatabaseSchema::catalogFingerprint()
+{
+    // a digest of what loadCatalog reads, columns by number, name, type, nullability and default,
+    // the index definitions and whether pg_trgm is installed
+    std::optional<jsoncons::json> fingerprint = Store::getObject<DatabaseController>()->executeReadPrepared(PreparedStatement(
+        "SELECT md5(concat_ws('|', "
+        "(SELECT string_agg(format('%s.%s.%s.%s.%s.%s', c.relname, a.attnum, a.attname, a.atttypid, a.attnotnull, pg_get_expr(d.adbin, d.adrelid)), ',' "
+        "ORDER BY c.relname, a.attnum) "
+        "FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "JOIN pg_attribute a ON a.attrelid = c.oid AND a.attnum > 0 AND NOT a.attisdropped "
+        "LEFT JOIN pg_attrdef d ON d.adrelid = a.attrelid AND d.adnum = a.attnum "
+        "WHERE n.nspname = 'public' AND c.relkind IN ('r', 'p', 'v', 'f')), "
+        "(SELECT string_agg(indexdef, ',' ORDER BY tablename, indexname) FROM pg_indexes WHERE schemaname = 'public'), "
+        "(SELECT string_agg(extname, ',') FROM pg_extension WHERE extname = 'pg_trgm'))) AS fingerprint;",
+        {}));
+
+    if (!fingerprint.has_value() || !fingerprint->contains("fingerprint"))
+    {
+        Message::WarningMessage("Failed to fingerprint the database catalog, the schema snapshot is not used.");
+        return std::nullopt;
+    }
+    return fingerprint->at("fingerprint").as<std::string>();
+}
+
+std::optional<SchemaSnapshot> DatabaseSchema::loadCatalog()
+{
+    auto dbctl = Store::getObject<DatabaseController>();
+
+    std::optional<std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>> schema = dbctl->getSchema();
+    if (!schema.has_value())
+    {
+        return std::nullopt;
+    }
+
+    SchemaSnapshot snapshot;
+    snapshot.schema = std::move(schema.value());
+
+    std::optional<jsoncons::json> extension =
+        dbctl->executeReadPrepared(PreparedStatement("SELECT EXISTS (SELECT 1 FROM pg_extension WHERE extname = 'pg_trgm') AS trgm;", {}));
+    snapshot.trigram = extension.has_value() && extension->contains("trgm") && extension->at("trgm").as<bool>();
+
+    std::optional<jsoncons::json::array> defined =
+        dbctl->executeSearchPrepared(PreparedStatement("SELECT tablename, indexdef FROM pg_indexes WHERE schemaname = 'public';", {}));
+
+    if (!defined.has_value())
+    {
+        Message::WarningMessage("Failed to read the index definitions, no search predicate is reported as indexed.");
+        return snapshot;
+    }
+
+    for (const auto& row : defined.value())
+    {
+        snapshot.indexes[row.at("tablename").as<std::string>()].push_back(row.at("indexdef").as<std::string>());
+    }
+    return snapshot;
+}
+
+void DatabaseSchema::persist(const SchemaSnapshot& snapshot)
+{
+    const std::filesystem::path path = Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().schema_snapshot;
+    if (path.empty() || snapshot.fingerprint.empty())
+    {
+        return;
+    }
+
+    if (snapshot.write(path))
+    {
+        Message::InitMessage(fmt::format("Database schema snapshot written to {}.", path.string()));
+    }
+}
+
+std::shared_ptr<const DatabaseSchema::Catalog> DatabaseSchema::compile(SchemaSnapshot&& snapshot)
+{
+    auto compiled = std::make_shared<Catalog>();
+
+    compiled->fingerprint      = std::move(snapshot.fingerprint);
+    compiled->schema           = std::move(snapshot.schema);
+    compiled->indexDefinitions = std::move(snapshot.indexes);
+    compiled->trigram          = snapshot.trigram;
+
+    // the id is set by the server, a payload naming it is validated as naming no column
+    for (const auto& [tableName, columns] : compiled->schema)
+    {
+        std::unordered_set<api::v2::ColumnInfo> payload = columns;
+        std::erase_if(payload, [](const api::v2::ColumnInfo& column) { return column.Name == "id"; });
+        compiled->validators.emplace(tableName, TableValidator(payload));
+    }
+    return compiled;
+}
+
+bool DatabaseSchema::reload()
+{
+    std::lock_guard<std::mutex> lock(reloading);
+
+    // read before the catalog, a change racing the load leaves an older fingerprint behind and is reloaded next time
+    std::optional<std::string> fingerprint = catalogFingerprint();
+    if (!fingerprint.has_value() || fingerprint.value() == catalog()->fingerprint)
+    {
+        return false;
+    }
+
+    std::optional<SchemaSnapshot> snapshot = loadCatalog();
+    if (!snapshot.has_value() || snapshot->schema.empty())
+    {
+        Message::WarningMessage("Failed to reload the database schema, the previous one stays in use.");
+        return false;
+    }
+
+    snapshot->fingerprint = fingerprint.value();
+    persist(snapshot.value());
+
+    std::shared_ptr<const Catalog> compiled = compile(std::move(snapshot.value()));
+    size_t                         tables   = compiled->schema.size();
+    current.store(std::move(compiled), std::memory_order_release);
+
+    Message::InfoMessage(fmt::format("Database schema reloaded, {} tables.", tables));
+    if (!verifyEntities())
+    {
+        Message::CriticalMessage("The reloaded database schema does not match the declared entity columns.");
+    }
+    return true;
+}
+
+bool DatabaseSchema::verifyEntities()
+{
+    bool verified = true;
+    for (const auto& entity : declared)
+    {
+        const std::string table(entity.table);
+        verifySearchIndexes(table, entity.indexes);
+        verified = verifyColumns(table, entity.columns) && verified;
+    }
+    return verified;
+}
+
+bool DatabaseSchema::verifyColumns(const std::string& tableName, std::span<const ColumnDescriptor> columns)
+{
+    std::shared_ptr<const Catalog> loaded = catalog();
+
+    auto table = loaded->schema.find(tableName);
+    if (table == loaded->schema.end())
+    {
+        Message::ErrorMessage(fmt::format("Table {} is not in the database.", tableName));
+        return false;
+    }
+
+    std::vector<std::string> mismatches;
+    for (const auto& declared : columns)
+    {
+        auto column = std::ranges::find_if(table->second, [&](const api::v2::ColumnInfo& info) { return info.Name == declared.name; });
+        if (column == table->second.end())
+        {
+            mismatches.push_back(fmt::format("{} is missing", declared.name));
+        }
+        else if (!declared.admits(column->DataType))
+        {
+            mismatches.push_back(fmt::format("{} is {}", declared.name, column->DataType));
+        }
+    }
+
+    if (!mismatches.empty())
+    {
+        Message::ErrorMessage(fmt::format("Table {} does not match its declared columns: {}", tableName, fmt::join(mismatches, ", ")));
+        return false;
+    }
+    return true;
+}
+
+void DatabaseSchema::verifySearchIndexes(const std::string& tableName, std::span<const SearchIndex> indexes)
+{
+    std::shared_ptr<const Catalog> loaded = catalog();
+
+    if (!loaded->trigram)
+    {
+        Message::WarningMessage("pg_trgm is not installed, trigram search falls back to substring matching. Run CREATE EXTENSION pg_trgm;");
+    }
+
+    auto table = loaded->schema.find(tableName);
+    if (table == loaded->schema.end())
+    {
+        return;
+    }
+
+    std::vector<std::string> missing;
+    for (const auto& index : indexes)
+    {
+        if (index.kind != SearchIndex::Kind::BTREE && !isTextColumn(tableName, std::string(index.column)))
+        {
+            Message::WarningMessage(fmt::format("{}.{} is not a text column, its {} index is not checked.", tableName, index.column, index.name(tableName)));
+            continue;
+        }
+
+        if ((index.kind != SearchIndex::Kind::TRIGRAM || loaded->trigram) && !hasIndex(tableName, index))
+        {
+            missing.push_back(index.definition(tableName));
+        }
+    }
+
+    if (!missing.empty())
+    {
+        Message::WarningMessage(fmt::format("Search on {} lacks {} indexes and scans the table instead, create them with:\n{}", tableName, missing.size(),
+            fmt::join(missing, "\n")));
+    }
+}
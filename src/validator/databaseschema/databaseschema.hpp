@@ -1,26 +1,82 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "utils/global/types.hpp"
+#include "validator/databaseschema/columndescriptor.hpp"
+#include "validator/databaseschema/entitydeclaration.hpp"
+#include "validator/databaseschema/schemasnapshot.hpp"
+#include "validator/databaseschema/searchindex.hpp"
+#include "validator/tablevalidator.hpp"
 
 #define SCHEMA_t std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>>
 class DatabaseSchema
 {
    public:
-    DatabaseSchema();
+    /// One loaded catalog. It is never changed once published, a reload builds a new one and swaps it in while
+    /// the readers still holding the previous one keep it alive until they are done with it.
+    struct Catalog
+    {
+        std::string                                               fingerprint;
+        SCHEMA_t                                                  schema;
+        std::unordered_map<std::string, TableValidator>           validators;
+        std::unordered_map<std::string, std::vector<std::string>> indexDefinitions;  // table -> pg_get_indexdef of its indexes
+        bool                                                      trigram = false;
+    };
+
+    // declarations are the entities checked against the catalog, now and after every reload
+    explicit DatabaseSchema(std::vector<EntityDeclaration> declarations);
     DatabaseSchema(const DatabaseSchema&)            = default;
     DatabaseSchema(DatabaseSchema&&)                 = delete;
     DatabaseSchema& operator=(const DatabaseSchema&) = default;
     DatabaseSchema& operator=(DatabaseSchema&&)      = delete;
     virtual ~DatabaseSchema()                        = default;
 
-    static void            populateSchema(const std::string& tableName);
-    static const SCHEMA_t& getDatabaseSchema();
-    static void            printSchema();
+    static std::shared_ptr<const SCHEMA_t> getDatabaseSchema();
+    // the compiled validator of tableName, nullptr if there is no such table
+    static std::shared_ptr<const TableValidator> getValidator(const std::string& tableName);
+    static void                                  printSchema();
+
+    // text, varchar or char, the types the prefix and trigram match modes apply to
+    static bool isTextColumn(const std::string& tableName, const std::string& column);
+    // whether the pg_trgm extension is installed, the trigram match mode is unavailable without it
+    static bool trigramSupported();
+    // whether one of the indexes of tableName is index
+    static bool hasIndex(const std::string& tableName, const SearchIndex& index);
+    // reports the indexes declared for tableName that it lacks, searching their column in that mode scans the table
+    static void verifySearchIndexes(const std::string& tableName, std::span<const SearchIndex> indexes);
+    // reports the columns declared for tableName that it lacks or that are of another kind, true if there are none
+    static bool verifyColumns(const std::string& tableName, std::span<const ColumnDescriptor> columns);
+
+    // rereads the catalog if its fingerprint changed and publishes it, true if the schema in use was replaced
+    static bool reload();
+    // makes snapshot the catalog in use without reading the database, for tools and tests working from a snapshot
+    static void publish(SchemaSnapshot&& snapshot);
 
    private:
-    static SCHEMA_t databaseSchema;
-};
\ No newline at end of file
+    // The catalog in use. std::atomic<std::shared_ptr> is not lock-free in libstdc++, a load briefly takes the
+    // internal lock guarding the pointer, never the reloading mutex, so it does not wait for a reload.
+    static std::shared_ptr<const Catalog> catalog();
+    // a digest of the live catalog, nullopt if it could not be read
+    static std::optional<std::string> catalogFingerprint();
+    // the columns of every table, the definitions of all indexes and whether pg_trgm is installed, read from the catalog
+    static std::optional<SchemaSnapshot> loadCatalog();
+    // writes snapshot to the configured file for the next start
+    static void persist(const SchemaSnapshot& snapshot);
+    // checks the search indexes and the declared columns of the entities against the catalog in use
+    static bool verifyEntities();
+    // compiles the validators of snapshot into a catalog ready to publish
+    static std::shared_ptr<const Catalog> compile(SchemaSnapshot&& snapshot);
+
+    static std::atomic<std::shared_ptr<const Catalog>> current;
+    static std::mutex                                  reloading;  // one reload at a time, readers never take it
+    static std::vector<EntityDeclaration>              declared;   // set once by the constructor, read under reloading
+};
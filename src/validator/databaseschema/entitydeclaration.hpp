@@ -0,0 +1,17 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "validator/databaseschema/columndescriptor.hpp"
+#include "validator/databaseschema/searchindex.hpp"
+
+/// What an entity declares about its table, handed to DatabaseSchema by whoever creates it so the schema does not
+/// depend on the entity classes that depend on it. The declarations are checked against the catalog at startup and
+/// on every reload.
+struct EntityDeclaration
+{
+    std::string_view                  table;
+    std::span<const ColumnDescriptor> columns;
+    std::span<const SearchIndex>      indexes;
+};
@@ -0,0 +1,143 @@
+#include "validator/databaseschema/schemasnapshot.hpp"
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <jsoncons/basic_json.hpp>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "utils/global/types.hpp"
+#include "utils/message/message.hpp"
+
+std::optional<SchemaSnapshot> SchemaSnapshot::read(const std::filesystem::path &path)
+{
+    try
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+
+        std::stringstream content;
+        content << file.rdbuf();
+        jsoncons::json snapshot_j = jsoncons::json::parse(content.str());
+
+        if (!snapshot_j.contains("format") || snapshot_j.at("format").as<uint32_t>() != FORMAT)
+        {
+            Message::InfoMessage(fmt::format("Schema snapshot {} is of another format, it is rebuilt.", path.string()));
+            return std::nullopt;
+        }
+
+        SchemaSnapshot snapshot;
+        snapshot.fingerprint = snapshot_j.at("fingerprint").as<std::string>();
+        snapshot.trigram     = snapshot_j.at("trigram").as<bool>();
+
+        for (const auto &table : snapshot_j.at("tables").object_range())
+        {
+            auto &columns = snapshot.schema[table.key()];
+            for (const auto &column_j : table.value().array_range())
+            {
+                api::v2::ColumnInfo column;
+                column.Name       = column_j.at("name").as<std::string>();
+                column.DataType   = column_j.at("type").as<std::string>();
+                column.Constraint = column_j.at("default").as<std::string>();
+                column.isNullable = column_j.at("nullable").as<bool>();
+                columns.insert(column);
+            }
+        }
+
+        for (const auto &table : snapshot_j.at("indexes").object_range())
+        {
+            auto &definitions = snapshot.indexes[table.key()];
+            for (const auto &definition : table.value().array_range())
+            {
+                definitions.push_back(definition.as<std::string>());
+            }
+        }
+        return snapshot;
+    }
+    catch (const std::exception &e)
+    {
+        Message::WarningMessage(fmt::format("Failed to read the schema snapshot {}, the catalog is read instead: {}", path.string(), e.what()));
+        return std::nullopt;
+    }
+}
+
+bool SchemaSnapshot::write(const std::filesystem::path &path) const
+{
+    try
+    {
+        jsoncons::json snapshot_j;
+        snapshot_j["format"]      = FORMAT;
+        snapshot_j["fingerprint"] = fingerprint;
+        snapshot_j["trigram"]     = trigram;
+        snapshot_j["tables"]      = jsoncons::json();
+        snapshot_j["indexes"]     = jsoncons::json();
+
+        for (const auto &[table, columns] : schema)
+        {
+            jsoncons::json columns_j = jsoncons::json::array();
+            for (const auto &column : columns)
+            {
+                jsoncons::json column_j;
+                column_j["name"]     = column.Name;
+                column_j["type"]     = column.DataType;
+                column_j["default"]  = column.Constraint;
+                column_j["nullable"] = column.isNullable;
+                columns_j.push_back(std::move(column_j));
+            }
+            snapshot_j["tables"][table] = std::move(columns_j);
+        }
+
+        for (const auto &[table, definitions] : indexes)
+        {
+            snapshot_j["indexes"][table] = jsoncons::json(jsoncons::json_array_arg, definitions.begin(), definitions.end());
+        }
+
+        // a name of its own, two servers writing the snapshot at once never write into the same file
+        std::string temporary  = path.string() + ".XXXXXX";
+        int         descriptor = mkstemp(temporary.data());
+        if (descriptor == -1)
+        {
+            Message::WarningMessage(fmt::format("Failed to write the schema snapshot {}.", temporary));
+            return false;
+        }
+        close(descriptor);
+
+        std::error_code error;
+        {
+            std::ofstream file(temporary, std::ios::trunc);
+            file << snapshot_j.to_string();
+            file.close();
+            if (file.fail())
+            {
+                std::filesystem::remove(temporary, error);
+                Message::WarningMessage(fmt::format("Failed to write the schema snapshot {}.", temporary));
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+        {
+            Message::WarningMessage(fmt::format("Failed to write the schema snapshot {}: {}", path.string(), error.message()));
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        Message::WarningMessage(fmt::format("Failed to write the schema snapshot {}: {}", path.string(), e.what()));
+        return false;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/global/types.hpp"
+
+/// The catalog DatabaseSchema loads, as stored on disk between runs. It carries the fingerprint of the catalog it
+/// was read from, a start whose live fingerprint matches loads the snapshot instead of reading the catalog. FORMAT
+/// is bumped whenever the file layout changes, a snapshot of another format is ignored and rewritten.
+struct SchemaSnapshot
+{
+    static constexpr uint32_t FORMAT = 2;  // 2 keeps the id columns
+
+    std::string                                                               fingerprint;
+    std::unordered_map<std::string, std::unordered_set<api::v2::ColumnInfo>> schema;
+    std::unordered_map<std::string, std::vector<std::string>>                 indexes;  // table -> pg_get_indexdef of its indexes
+    bool                                                                      trigram = false;
+
+    // nullopt if the file is missing, unreadable or of another format
+    static std::optional<SchemaSnapshot> read(const std::filesystem::path &path);
+    // writes a temporary file of its own next to path and renames it, a crash never leaves half a snapshot behind
+    [[nodiscard]] bool write(const std::filesystem::path &path) const;
+};
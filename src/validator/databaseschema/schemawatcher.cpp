@@ -0,0 +1,134 @@
+#include "validator/databaseschema/schemawatcher.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <jsoncons/basic_json.hpp>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "configurator/configurator.hpp"
+#include "controllers/databasecontroller/databasecontroller.hpp"
+#include "database/database.hpp"
+#include "database/databaseconnectionpool.hpp"
+#include "database/preparedstatement.hpp"
+#include "store/store.hpp"
+#include "utils/message/message.hpp"
+#include "validator/databaseschema/databaseschema.hpp"
+
+SchemaWatcher::SchemaWatcher()
+    : pool_(Store::getObject<DatabaseConnectionPool>()), poll_(Store::getObject<Configurator>()->get<Configurator::DatabaseConfig>().schema_poll)
+{
+    if (watch_thread.joinable())
+    {
+        throw std::logic_error("SchemaWatcher thread already running!");
+    }
+
+    checkTrigger();
+    watch_thread = std::thread(&SchemaWatcher::watch, this);
+}
+
+SchemaWatcher::~SchemaWatcher()
+{
+    should_watch = false;
+    if (watch_thread.joinable())
+    {
+        watch_thread.join();
+    }
+}
+
+bool SchemaWatcher::connect()
+{
+    if (listener_ == nullptr)
+    {
+        listener_ = pool_->open_connection();
+    }
+    else if (!listener_->reconnect())
+    {
+        return false;
+    }
+    return listener_ != nullptr && listener_->listen(std::string(CHANNEL));
+}
+
+void SchemaWatcher::checkTrigger()
+{
+    std::optional<jsoncons::json> installed = Store::getObject<DatabaseController>()->executePrepared(PreparedStatement(
+        "SELECT EXISTS (SELECT 1 FROM pg_event_trigger WHERE evtname = $1 AND evtenabled <> 'D') AS installed;", {std::string(CHANNEL)}));
+
+    if (installed.has_value() && installed->contains("installed") && installed->at("installed").as<bool>())
+    {
+        return;
+    }
+
+    // event triggers take a superuser, the server does not install it on its own
+    Message::WarningMessage(fmt::format(
+        "Schema changes are only noticed by polling, install the event trigger notifying them with:\n"
+        "CREATE OR REPLACE FUNCTION {0}() RETURNS event_trigger LANGUAGE plpgsql AS $$ BEGIN PERFORM pg_notify('{0}', tg_tag); END $$;\n"
+        "CREATE EVENT TRIGGER {0} ON ddl_command_end EXECUTE FUNCTION {0}();",
+        CHANNEL));
+}
+
+void SchemaWatcher::watch()
+{
+    bool listening = false;
+    bool listened  = false;
+    auto checked   = std::chrono::steady_clock::now();
+
+    while (should_watch)
+    {
+        try
+        {
+            bool changed = false;
+
+            if (!listening)
+            {
+                listening = connect();
+                // whatever changed while nobody listened went unnoticed
+                changed   = listening && listened;
+                listened  = listened || listening;
+                if (!listening)
+                {
+                    std::this_thread::sleep_for(WAIT);
+                }
+            }
+            else
+            {
+                std::optional<size_t> received = listener_->awaitNotifications(WAIT);
+                if (!received.has_value())
+                {
+                    listening = false;
+                    Message::WarningMessage("Schema listener lost its connection, reconnecting.");
+                    continue;
+                }
+
+                // a migration notifies once per command, the catalog is reread once it is done
+                changed = received.value() > 0;
+                while (changed && should_watch)
+                {
+                    received = listener_->awaitNotifications(QUIET);
+                    if (!received.has_value() || received.value() == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (changed || (poll_.count() > 0 && now - checked >= poll_))
+            {
+                checked = now;
+                DatabaseSchema::reload();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            listening = false;
+            Message::CriticalMessage(fmt::format("Schema watcher exception: {}", e.what()));
+            std::this_thread::sleep_for(WAIT);
+        }
+    }
+}
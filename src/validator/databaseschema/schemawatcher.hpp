@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <thread>
+
+class Database;
+class DatabaseConnectionPool;
+
+/// Reloads DatabaseSchema after a migration without a restart. A connection of its own LISTENs on CHANNEL, which
+/// the event trigger logged at startup notifies after every DDL command. The notifications of one migration are
+/// let settle for QUIET before the catalog is reread off the request threads and swapped in. The fingerprint is
+/// also checked every schema_poll, so a change made while the listener reconnects, or without the trigger
+/// installed, is picked up all the same.
+class SchemaWatcher
+{
+   public:
+    SchemaWatcher();
+    SchemaWatcher(const SchemaWatcher &)            = delete;
+    SchemaWatcher(SchemaWatcher &&)                 = delete;
+    SchemaWatcher &operator=(const SchemaWatcher &) = delete;
+    SchemaWatcher &operator=(SchemaWatcher &&)      = delete;
+    virtual ~SchemaWatcher();
+
+    static constexpr std::string_view CHANNEL = "valhalla_schema_changed";
+
+   private:
+    // opens or reopens the listener and subscribes it, true once it listens
+    bool connect();
+    // warns with the statements installing the event trigger if it is missing
+    static void checkTrigger();
+    void        watch();
+
+    std::shared_ptr<DatabaseConnectionPool> pool_;
+    std::shared_ptr<Database>               listener_;
+    std::chrono::seconds                    poll_;
+
+    std::atomic<bool> should_watch{true};
+    std::thread       watch_thread;
+
+    static constexpr std::chrono::milliseconds QUIET{500};  // a migration is over once no command was notified for this long
+    static constexpr std::chrono::seconds      WAIT{1};     // longest a wait blocks, bounds how long shutdown takes
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// An index a search predicate relies on, on column. A trigram index (pg_trgm, gin_trgm_ops) serves substring and
+/// similarity matches, a btree over lower(column) with text_pattern_ops serves case insensitive prefix matches
+/// and a btree leading with the column serves equality, membership, range and null tests.
+struct SearchIndex
+{
+    enum class Kind : std::uint8_t
+    {
+        TRIGRAM,
+        PREFIX,
+        BTREE
+    };
+
+    std::string_view column;
+    Kind             kind;
+
+    [[nodiscard]] std::string name(std::string_view table) const
+    {
+        return fmt::format("{}_{}_{}_idx", table, column, kind == Kind::TRIGRAM ? "trgm" : kind == Kind::PREFIX ? "prefix" : "btree");
+    }
+
+    // the statement creating the index, reported when it is missing
+    [[nodiscard]] std::string definition(std::string_view table) const
+    {
+        if (kind == Kind::TRIGRAM)
+        {
+            return fmt::format(R"(CREATE INDEX CONCURRENTLY IF NOT EXISTS {} ON {} USING gin ("{}" gin_trgm_ops);)", name(table), table, column);
+        }
+        if (kind == Kind::PREFIX)
+        {
+            return fmt::format(R"(CREATE INDEX CONCURRENTLY IF NOT EXISTS {} ON {} (lower("{}") text_pattern_ops);)", name(table), table, column);
+        }
+        return fmt::format(R"(CREATE INDEX CONCURRENTLY IF NOT EXISTS {} ON {} ("{}");)", name(table), table, column);
+    }
+
+    // whether an index definition as printed by pg_get_indexdef is this index
+    [[nodiscard]] bool covers(std::string_view indexdef) const
+    {
+        for (const std::string &identifier : {std::string(column), fmt::format(R"("{}")", column)})
+        {
+            if (kind == Kind::TRIGRAM && indexdef.find(fmt::format("({} gin_trgm_ops)", identifier)) != std::string_view::npos)
+            {
+                return true;
+            }
+            // varchar columns are printed with the cast lower() adds
+            if (kind == Kind::PREFIX && (indexdef.find(fmt::format("(lower({}) text_pattern_ops)", identifier)) != std::string_view::npos ||
+                                            indexdef.find(fmt::format("(lower(({})::text) text_pattern_ops)", identifier)) != std::string_view::npos))
+            {
+                return true;
+            }
+            if (kind == Kind::BTREE)
+            {
+                std::string leading = fmt::format("USING btree ({}", identifier);
+                size_t      at      = indexdef.find(leading);
+                if (at != std::string_view::npos && at + leading.size() < indexdef.size() &&
+                    std::string_view(") ,").find(indexdef[at + leading.size()]) != std::string_view::npos)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,317 @@
+#include "validator/tablevalidator.hpp"
+
+#include <fmt/core.h>
+#include <xxhash.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "utils/global/http.hpp"
+#include "utils/global/types.hpp"
+#include "validator/validator.hpp"
+
+using Action = Validator::Rule::Action;
+
+TableValidator::TableValidator(const std::unordered_set<api::v2::ColumnInfo> &columns)
+{
+    columns_.reserve(columns.size());
+    for (const auto &column : columns)
+    {
+        columns_.push_back(Column{.name = column.Name, .dataType = column.DataType, .type = typeOf(column.DataType)});
+    }
+    // the schema set has no order, sorting keeps the first reported error stable
+    std::ranges::sort(columns_, {}, &Column::name);
+
+    // looks for a seed that maps every name to a slot of its own, a table twice as large as the column count
+    // takes a few tries, the table is grown whenever a size keeps colliding
+    size_t size = std::bit_ceil(std::max<size_t>(columns_.size() * 2, 1));
+    for (uint64_t attempt = 0;; ++attempt)
+    {
+        if (attempt != 0 && attempt % 64 == 0)
+        {
+            size *= 2;
+        }
+
+        seed_ = attempt;
+        slots_.assign(size, NO_COLUMN);
+
+        bool unique = true;
+        for (uint32_t index = 0; index < columns_.size() && unique; ++index)
+        {
+            uint32_t &slot = slots_[hash(columns_[index].name, seed_) & (size - 1)];
+            unique         = slot == NO_COLUMN;
+            slot           = index;
+        }
+
+        if (unique)
+        {
+            break;
+        }
+    }
+
+    required_.assign((columns_.size() + 63) / 64, 0);
+    for (const auto &column : columns)
+    {
+        if (!column.isNullable)
+        {
+            size_t index = find(column.Name).value();
+            required_[index / 64] |= uint64_t{1} << (index % 64);
+        }
+    }
+}
+
+bool TableValidator::validateCreate(const jsoncons::json &data, api::v2::Http::Error &error, const Validator::Rule &rule) const
+{
+    Resolved        scratch;
+    const Resolved &rules = resolved(rule, scratch);
+    Mask            seen(required_.size(), 0);
+
+    for (const auto &member : data.object_range())
+    {
+        if (!checkKey(member.key(), &member.value(), rules, &seen, error))
+        {
+            return false;
+        }
+    }
+
+    for (size_t word = 0; word < required_.size(); ++word)
+    {
+        uint64_t missing = required_[word] & ~seen[word] & ~rules.ignoreNotNullable[word];
+        if (missing != 0)
+        {
+            error.message = "Non-nullable column missing in data: " + columns_[(word * 64) + std::countr_zero(missing)].name;
+            error.code    = api::v2::Http::Status::BAD_REQUEST;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TableValidator::validateUpdate(const jsoncons::json &data, api::v2::Http::Error &error, const Validator::Rule &rule) const
+{
+    Resolved        scratch;
+    const Resolved &rules = resolved(rule, scratch);
+
+    for (const auto &member : data.object_range())
+    {
+        if (!checkKey(member.key(), nullptr, rules, nullptr, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TableValidator::validateRead(const std::unordered_set<std::string> &keys, api::v2::Http::Error &error, const Validator::Rule &rule) const
+{
+    Resolved        scratch;
+    const Resolved &rules = resolved(rule, scratch);
+
+    for (const auto &key : keys)
+    {
+        std::optional<size_t> column = find(key);
+
+        if (rules.has(column, key, Action::ASSERT_NOT_PRESENT))
+        {
+            error.message = "Key not allowed: " + key;
+            error.code    = api::v2::Http::Status::BAD_REQUEST;
+            return false;
+        }
+
+        if (!column.has_value())
+        {
+            error.message = "Key not found in schema: " + key;
+            error.code    = api::v2::Http::Status::BAD_REQUEST;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TableValidator::Resolved::has(std::optional<size_t> column, std::string_view key, Action action) const
+{
+    if (column.has_value())
+    {
+        return (flags[column.value()] & action) != 0;
+    }
+    return std::ranges::any_of(others, [&](const auto &other) { return other.first == key && (other.second & action) != 0; });
+}
+
+std::optional<size_t> TableValidator::find(std::string_view key) const
+{
+    if (slots_.empty())
+    {
+        return std::nullopt;
+    }
+
+    uint32_t index = slots_[hash(key, seed_) & (slots_.size() - 1)];
+    if (index == NO_COLUMN || columns_[index].name != key)
+    {
+        return std::nullopt;
+    }
+    return index;
+}
+
+TableValidator::Resolved TableValidator::resolve(const Validator::Rule &rule) const
+{
+    Resolved rules{.flags = std::vector<std::uint8_t>(columns_.size(), 0), .others = {}, .ignoreNotNullable = Mask(required_.size(), 0)};
+
+    for (const auto &[action, keys] : rule.keys)
+    {
+        // the keys only take effect for the actions the rule is made of
+        auto flags = static_cast<std::uint8_t>(action & rule.action);
+        if (flags == 0)
+        {
+            continue;
+        }
+
+        for (const auto &key : keys)
+        {
+            std::optional<size_t> column = find(key);
+            if (!column.has_value())
+            {
+                rules.others.emplace_back(key, flags);
+                continue;
+            }
+
+            rules.flags[column.value()] |= flags;
+            if ((flags & Action::IGNORE_IF_NOT_NULLABLE_IN_SCHEMA) != 0)
+            {
+                rules.ignoreNotNullable[column.value() / 64] |= uint64_t{1} << (column.value() % 64);
+            }
+        }
+    }
+    return rules;
+}
+
+const TableValidator::Resolved &TableValidator::resolved(const Validator::Rule &rule, Resolved &scratch) const
+{
+    std::lock_guard<std::mutex> lock(rules_->mutex);
+
+    for (const auto &cached : rules_->entries)
+    {
+        if (cached->rule.action == rule.action && cached->rule.keys == rule.keys)
+        {
+            return cached->resolved;
+        }
+    }
+
+    if (rules_->entries.size() >= MAX_CACHED_RULES)
+    {
+        scratch = resolve(rule);
+        return scratch;
+    }
+
+    // resolved against the kept copy, the names of keys that are no column point into it
+    auto cached      = std::make_unique<Cached>(Cached{.rule = rule, .resolved = {}});
+    cached->resolved = resolve(cached->rule);
+    rules_->entries.push_back(std::move(cached));
+    return rules_->entries.back()->resolved;
+}
+
+bool TableValidator::checkKey(std::string_view key, const jsoncons::json *value, const Resolved &rules, Mask *seen, api::v2::Http::Error &error) const
+{
+    std::optional<size_t> column = find(key);
+
+    if (rules.has(column, key, Action::ASSERT_NOT_PRESENT))
+    {
+        error.message = fmt::format("A prohibited key was found: [{}]", key);
+        error.code    = api::v2::Http::Status::BAD_REQUEST;
+        return false;
+    }
+
+    if (rules.has(column, key, Action::ASSERT_IMMUTABLE))
+    {
+        error.message = fmt::format("Key: [{}] is not allowed to be changed", key);
+        error.code    = api::v2::Http::Status::BAD_REQUEST;
+        return false;
+    }
+
+    if (!column.has_value())
+    {
+        if (rules.has(column, key, Action::IGNORE_IF_MISSING_FROM_SCHEMA))
+        {
+            return true;
+        }
+        error.message = fmt::format("Key: [{}] is not found in database schema", key);
+        error.code    = api::v2::Http::Status::BAD_REQUEST;
+        return false;
+    }
+
+    const Column &info = columns_[column.value()];
+    if (value != nullptr && !matches(*value, info.type))
+    {
+        error.message = fmt::format("Data type mismatch for column: {} ,expected: {} ", info.name, info.dataType);
+        error.code    = api::v2::Http::Status::BAD_REQUEST;
+        return false;
+    }
+
+    if (seen != nullptr)
+    {
+        (*seen)[column.value() / 64] |= uint64_t{1} << (column.value() % 64);
+    }
+    return true;
+}
+
+TableValidator::Type TableValidator::typeOf(const std::string &dataType)
+{
+    if (dataType == "integer")
+    {
+        return Type::INTEGER;
+    }
+    if (dataType == "float" || dataType == "double" || dataType == "real")
+    {
+        return Type::FLOAT;
+    }
+    if (dataType == "character varying")
+    {
+        return Type::STRING;
+    }
+    if (dataType == "boolean")
+    {
+        return Type::BOOLEAN;
+    }
+    if (dataType == "jsonb")
+    {
+        return Type::JSON;
+    }
+    if (dataType == "timestamp with time zone" || dataType == "time without time zone" || dataType == "date")
+    {
+        return Type::TEMPORAL;  // Assuming dates are strings
+    }
+    return Type::UNKNOWN;
+}
+
+bool TableValidator::matches(const jsoncons::json &value, Type type)
+{
+    switch (type)
+    {
+        case Type::INTEGER:
+            return value.is_int64();
+        case Type::FLOAT:
+            return value.is_double();
+        case Type::STRING:
+        case Type::TEMPORAL:
+            return value.is_string();
+        case Type::BOOLEAN:
+            return value.is_bool();
+        case Type::JSON:
+            return value.is_object() || value.is_array();
+        case Type::UNKNOWN:
+        default:
+            return false;
+    }
+}
+
+uint64_t TableValidator::hash(std::string_view key, uint64_t seed) { return XXH3_64bits_withSeed(key.data(), key.size(), seed); }
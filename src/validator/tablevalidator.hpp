@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <jsoncons/basic_json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "utils/global/http.hpp"
+#include "utils/global/types.hpp"
+#include "validator/validator.hpp"
+
+/// The schema of one table compiled for validating request payloads. Column names are found through a perfect
+/// hash built once, column types are resolved to a check each and the non nullable columns are kept as a
+/// bitmask, so a payload is validated in one pass over its keys without building anything per column. The
+/// keys of a Rule are resolved to per column action flags the first time the table sees the rule.
+class TableValidator
+{
+   public:
+    explicit TableValidator(const std::unordered_set<api::v2::ColumnInfo> &columns);
+    TableValidator(const TableValidator &)            = default;
+    TableValidator(TableValidator &&)                 = default;
+    TableValidator &operator=(const TableValidator &) = default;
+    TableValidator &operator=(TableValidator &&)      = default;
+    virtual ~TableValidator()                         = default;
+
+    // every key is a column of the right type and every non nullable column is present
+    bool validateCreate(const jsoncons::json &data, api::v2::Http::Error &error, const Validator::Rule &rule) const;
+    // every key is a column, a partial payload is fine
+    bool validateUpdate(const jsoncons::json &data, api::v2::Http::Error &error, const Validator::Rule &rule) const;
+    // every requested key is a column
+    bool validateRead(const std::unordered_set<std::string> &keys, api::v2::Http::Error &error, const Validator::Rule &rule) const;
+
+   private:
+    enum class Type : std::uint8_t
+    {
+        INTEGER,
+        FLOAT,
+        STRING,
+        BOOLEAN,
+        JSON,
+        TEMPORAL,
+        UNKNOWN  // matches no value
+    };
+
+    struct Column
+    {
+        std::string name;
+        std::string dataType;
+        Type        type;
+    };
+
+    using Mask = std::vector<uint64_t>;  // one bit per column
+
+    // the actions of the rule for each column, and for keys that are no column
+    struct Resolved
+    {
+        std::vector<std::uint8_t>                              flags;
+        std::vector<std::pair<std::string_view, std::uint8_t>> others;
+        Mask                                                   ignoreNotNullable;
+
+        [[nodiscard]] bool has(std::optional<size_t> column, std::string_view key, Validator::Rule::Action action) const;
+    };
+
+    // a rule and its resolved flags, kept for the rules the controllers build on every request
+    struct Cached
+    {
+        Validator::Rule rule;
+        Resolved        resolved;
+    };
+
+    struct RuleCache
+    {
+        std::mutex                                 mutex;
+        std::vector<std::unique_ptr<const Cached>> entries;  // never erased, the entries are handed out by reference
+    };
+
+    static constexpr size_t MAX_CACHED_RULES = 64;  // the controllers use a handful, more means rules built from input
+
+    [[nodiscard]] std::optional<size_t> find(std::string_view key) const;
+    [[nodiscard]] Resolved              resolve(const Validator::Rule &rule) const;
+    // the flags of rule, resolved once per distinct rule, scratch holds them once the cache is full
+    [[nodiscard]] const Resolved       &resolved(const Validator::Rule &rule, Resolved &scratch) const;
+
+    // checks one key of a payload, value is only type checked if given
+    bool checkKey(std::string_view key, const jsoncons::json *value, const Resolved &rules, Mask *seen, api::v2::Http::Error &error) const;
+
+    static Type     typeOf(const std::string &dataType);
+    static bool     matches(const jsoncons::json &value, Type type);
+    static uint64_t hash(std::string_view key, uint64_t seed);
+
+    static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+
+    std::vector<Column>   columns_;
+    Mask                  required_;  // the non nullable columns
+    std::vector<uint32_t> slots_;     // perfect hash of the column names, size is a power of two
+    uint64_t              seed_ = 0;
+
+    std::shared_ptr<RuleCache> rules_ = std::make_shared<RuleCache>();  // shared by copies, they have the same columns
+};
@@ -7,6 +7,7 @@
 #include <exception>
 #include <jsoncons/basic_json.hpp>
 #include <jsoncons/pretty_print.hpp>
+#include <memory>
 #include <optional>
 #include <regex>
 #include <string>
@@ -17,6 +18,7 @@
 #include "utils/global/http.hpp"
 #include "utils/global/types.hpp"
 #include "validator/databaseschema/databaseschema.hpp"
+#include "validator/tablevalidator.hpp"
 
 bool Validator::validateDatabaseCreateSchema(const std::string &tablename, const jsoncons::json &data, api::v2::Http::Error &error, const Rule &rule)
 {
@@ -33,29 +35,15 @@ bool Validator::validateDatabaseCreateSchema(const std::string &tablename, const
         //     error.message); return false;
         // }
 
-        // Get the schema for the table
-        bool found        = false;
-        auto table_schema = getDatabaseSchemaForTable(tablename, error, found);
+        // Get the compiled schema for the table, it checks keys, types and the non-nullable columns in one pass
+        std::shared_ptr<const TableValidator> validator = getTableValidator(tablename, error);
 
-        if (!found)
+        if (validator == nullptr)
         {
             return false;
         }
 
-        // now lets go through the data and check if the keys are in the schema
-        // check for type and nullable
-
-        if (!checkColumns(data, table_schema, error, rule))
-        {
-            return false;
-        }
-
-        // Ensure all keys in the schema are present in the data
-        if (!ensureAllKeysExist(data, table_schema, error, rule))
-        {
-            return false;
-        }
-        return true;
+        return validator->validateCreate(data, error, rule);
     }
     catch (const std::exception &e)
     {
@@ -82,21 +70,16 @@ bool Validator::validateDatabaseUpdateSchema(const std::string &tablename, const
         //     error.message); return false;
         // }
 
-        // Get the schema for the table
-        bool found        = false;
-        auto table_schema = getDatabaseSchemaForTable(tablename, error, found);
+        // Get the compiled schema for the table
+        std::shared_ptr<const TableValidator> validator = getTableValidator(tablename, error);
 
-        if (!found)
+        if (validator == nullptr)
         {
             return false;
         }
-        // Ensure all keys in the schema are present in the data
+        // Ensure all keys in the data are in the schema
         // in case of update we dont need to check for all keys
-        if (!ensureAllKeysExist(data, table_schema, error, rule))
-        {
-            return false;
-        }
-        return true;
+        return validator->validateUpdate(data, error, rule);
     }
     catch (const std::exception &e)
     {
@@ -111,11 +94,9 @@ bool Validator::validateDatabaseUpdateSchema(const std::string &tablename, const
 bool Validator::validateDatabaseReadSchema(
     const std::unordered_set<std::string> &keys, const std::string &table_name, api::v2::Http::Error &error, const Rule &rule)
 {
-    bool found = false;
-
-    // Retrieve the schema for the given table
-    auto columns = getDatabaseSchemaForTable(table_name, error, found);
-    if (!found)
+    // Retrieve the compiled schema for the given table
+    std::shared_ptr<const TableValidator> validator = getTableValidator(table_name, error);
+    if (validator == nullptr)
     {
         error.message = "Table not found";
         error.code    = api::v2::Http::Status::NOT_FOUND;
@@ -123,27 +104,7 @@ bool Validator::validateDatabaseReadSchema(
     }
 
     // Check if all keys exist in the schema
-    for (const auto &key : keys)
-    {
-        if (rule.check(Rule::Action::ASSERT_NOT_PRESENT, key))
-        {
-            error.message = "Key not allowed: " + key;
-            error.code    = api::v2::Http::Status::BAD_REQUEST;
-            return false;
-        }
-        // Use std::ranges::find_if to check if a column with the given name
-        // exists
-        auto col = std::ranges::find_if(columns, [&](const api::v2::ColumnInfo &column) { return column.Name == key; });
-
-        if (col == columns.end())
-        {
-            error.message = "Key not found in schema: " + key;
-            error.code    = api::v2::Http::Status::BAD_REQUEST;
-            return false;
-        }
-    }
-
-    return true;
+    return validator->validateRead(keys, error, rule);
 }
 bool Validator::clientRegexValidation(const jsoncons::json &data, api::v2::Http::Error &error, std::unordered_set<std::pair<std::string, std::string>> &db_data)
 {
@@ -214,116 +175,15 @@ bool Validator::nullCheck(const jsoncons::json &data, api::v2::Http::Error &erro
     return false;
 }
 
-std::unordered_set<api::v2::ColumnInfo> Validator::getDatabaseSchemaForTable(const std::string &tablename, api::v2::Http::Error &error, bool &found)
+std::shared_ptr<const TableValidator> Validator::getTableValidator(const std::string &tablename, api::v2::Http::Error &error)
 {
-    SCHEMA_t schema = DatabaseSchema::getDatabaseSchema();
+    std::shared_ptr<const TableValidator> validator = DatabaseSchema::getValidator(tablename);
 
     // Ensure the table schema exists
-    auto table_schema_it = schema.find(tablename);
-    if ((table_schema_it == schema.end()) || table_schema_it->second.empty())
+    if (validator == nullptr)
     {
         error.message = "Table not found";
         error.code    = api::v2::Http::Status::BAD_REQUEST;
-        found         = false;
-    }
-    found = true;
-    return table_schema_it->second;
-}
-bool Validator::validateType(const jsoncons::json &value, const std::string &expectedType)
-{
-    if (expectedType == "integer")
-    {
-        return value.is_int64();
-    }
-    if (expectedType == "float" || expectedType == "double" || expectedType == "real")
-    {
-        return value.is_double();
-    }
-    if (expectedType == "character varying")
-    {
-        return value.is_string();
-    }
-    if (expectedType == "boolean")
-    {
-        return value.is_bool();
-    }
-    if (expectedType == "jsonb")
-    {
-        return (value.is_object() || value.is_array());
     }
-    if (expectedType == "timestamp with time zone" || expectedType == "time without time zone" || expectedType == "date")
-    {
-        return value.is_string();  // Assuming dates are strings
-    }
-    return false;  // Unknown type
-}
-
-bool Validator::checkColumns(
-    const jsoncons::json &data, const std::unordered_set<api::v2::ColumnInfo> &table_schema, api::v2::Http::Error &error, const Rule &rule)
-{
-    for (const auto &column : table_schema)
-    {
-        bool column_exists = data.contains(column.Name);
-
-        // Check for missing non-nullable columns
-        if (!column_exists && !column.isNullable && !rule.check(Rule::Action::IGNORE_IF_NOT_NULLABLE_IN_SCHEMA, column.Name))
-        {
-            error.message = "Non-nullable column missing in data: " + column.Name;
-            error.code    = api::v2::Http::Status::BAD_REQUEST;
-            return false;
-        }
-
-        // Validate data type if column exists
-        if (column_exists)
-        {
-            const auto &value = data.at(column.Name);
-            if (!validateType(value, column.DataType))
-            {
-                error.message = fmt::format("Data type mismatch for column: {} ,expected: {} ", column.Name, column.DataType);
-                error.code    = api::v2::Http::Status::BAD_REQUEST;
-                return false;
-            }
-        }
-    }
-    return true;
+    return validator;
 }
-bool Validator::ensureAllKeysExist(
-    const jsoncons::json &data, const std::unordered_set<api::v2::ColumnInfo> &table_schema, api::v2::Http::Error &error, const Rule &rule)
-{
-    // Create a set of column names for fast key lookup
-    std::unordered_set<std::string> schema_columns;
-    for (const auto &column : table_schema)
-    {
-        schema_columns.insert(column.Name);
-    }
-
-    // Ensure all keys in `data` exist in the schema
-    for (const auto &entry : data.object_range())
-    {
-        const auto &key = entry.key();
-
-        // Check for missing not allowed keys
-        if (rule.check(Rule::Action::ASSERT_NOT_PRESENT, key))
-        {
-            error.message = "A prohibited key was found: [" + key + "]";
-            error.code    = api::v2::Http::Status::BAD_REQUEST;
-            return false;
-        }
-        // check if the key is in the exclude list
-        if (rule.check(Rule::Action::ASSERT_IMMUTABLE, key))
-        {
-            error.message = "Key: [" + key + "] is not allowed to be changed";
-            error.code    = api::v2::Http::Status::BAD_REQUEST;
-            return false;
-        }
-
-        bool ignore_if_missing_from_database_schema = rule.check(Rule::Action::IGNORE_IF_MISSING_FROM_SCHEMA, key);
-        if (schema_columns.find(key) == schema_columns.end() && !ignore_if_missing_from_database_schema)  // Key not in schema
-        {
-            error.message = "Key: [" + key + "] is not found in database schema";
-            error.code    = api::v2::Http::Status::BAD_REQUEST;
-            return false;
-        }
-    }
-    return true;
-}
\ No newline at end of file
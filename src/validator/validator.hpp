@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <jsoncons/basic_json.hpp>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -10,6 +11,9 @@
 
 #include "utils/global/http.hpp"
 #include "utils/global/types.hpp"
+
+class TableValidator;
+
 class Validator
 {
    public:
@@ -99,12 +103,7 @@ class Validator
         const jsoncons::json &data, api::v2::Http::Error &error, std::unordered_set<std::pair<std::string, std::string>> &db_data);
 
    private:
-    static bool                                    nullCheck(const jsoncons::json &data, api::v2::Http::Error &error);
-    static std::unordered_set<api::v2::ColumnInfo> getDatabaseSchemaForTable(const std::string &tablename, api::v2::Http::Error &error, bool &found);
-    static bool                                    validateType(const jsoncons::json &value, const std::string &expectedType);
-    static bool                                    checkColumns(
-                                           const jsoncons::json &data, const std::unordered_set<api::v2::ColumnInfo> &table_schema, api::v2::Http::Error &error, const Rule &rule);
-    static bool ensureAllKeysExist(
-        const jsoncons::json &data, const std::unordered_set<api::v2::ColumnInfo> &table_schema, api::v2::Http::Error &error, const Rule &rule);
-    static bool hasDuplicateKeys(const jsoncons::json &data, api::v2::Http::Error &error);
+    static bool                  nullCheck(const jsoncons::json &data, api::v2::Http::Error &error);
+    static std::shared_ptr<const TableValidator> getTableValidator(const std::string &tablename, api::v2::Http::Error &error);
+    static bool                  hasDuplicateKeys(const jsoncons::json &data, api::v2::Http::Error &error);
 };
@@ -0,0 +1,117 @@
+#include <libpq-fe.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/EventLoopThread.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "database/asyncdatabase.hpp"
+#include "database/preparedstatement.hpp"
+
+// these talk to a real server, VALHALLA_TEST_DB holds its libpq connection string
+namespace
+{
+    std::optional<std::string> testDatabase()
+    {
+        const char *conninfo = std::getenv("VALHALLA_TEST_DB");  // NOLINT
+        if (conninfo == nullptr)
+        {
+            return std::nullopt;
+        }
+        return std::string(conninfo);
+    }
+
+    std::string valueOf(const AsyncDatabase::ResultPtr &result) { return result != nullptr ? PQgetvalue(result.get(), 0, 0) : "<failed>"; }
+
+    // runs func on the loop thread and waits for it, the connection is created and destroyed there
+    template <typename Func>
+    void inLoop(trantor::EventLoop *loop, Func &&func)
+    {
+        std::promise<void> done;
+        loop->runInLoop(
+            [&]()
+            {
+                func();
+                done.set_value();
+            });
+        done.get_future().wait();
+    }
+}  // namespace
+
+TEST_CASE("a query queued from inside a callback is sent once", "[asyncdatabase]")
+{
+    std::optional<std::string> conninfo = testDatabase();
+    if (!conninfo.has_value())
+    {
+        SKIP("VALHALLA_TEST_DB is not set");
+    }
+
+    trantor::EventLoopThread thread;
+    thread.run();
+    trantor::EventLoop *loop = thread.getLoop();
+
+    std::shared_ptr<AsyncDatabase>         database;
+    std::promise<std::vector<std::string>> answers;
+
+    inLoop(loop,
+        [&]()
+        {
+            database = std::make_shared<AsyncDatabase>(loop, "test", conninfo.value());
+            database->execute("SELECT 1",
+                [&](AsyncDatabase::ResultPtr &&first)
+                {
+                    std::string value = valueOf(first);
+                    database->execute("SELECT 2", [&, value](AsyncDatabase::ResultPtr &&second) { answers.set_value({value, valueOf(second)}); });
+                });
+        });
+
+    std::future<std::vector<std::string>> future = answers.get_future();
+    REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(future.get() == std::vector<std::string>{"1", "2"});
+
+    inLoop(loop, [&]() { database.reset(); });
+}
+
+TEST_CASE("a prepared statement queued from inside a batch callback is sent once", "[asyncdatabase]")
+{
+    std::optional<std::string> conninfo = testDatabase();
+    if (!conninfo.has_value())
+    {
+        SKIP("VALHALLA_TEST_DB is not set");
+    }
+
+    trantor::EventLoopThread thread;
+    thread.run();
+    trantor::EventLoop *loop = thread.getLoop();
+
+    std::shared_ptr<AsyncDatabase>         database;
+    std::promise<std::vector<std::string>> answers;
+
+    inLoop(loop,
+        [&]()
+        {
+            database = std::make_shared<AsyncDatabase>(loop, "test", conninfo.value());
+
+            std::vector<PreparedStatement> batch;
+            batch.emplace_back("SELECT $1::int + 1;", PreparedStatement::Params{"1"});
+            database->executeBatch(std::move(batch),
+                [&](std::optional<std::vector<AsyncDatabase::ResultPtr>> &&results, const std::string &)
+                {
+                    std::string value = results.has_value() ? valueOf(results->front()) : "<failed>";
+                    database->executePrepared(PreparedStatement("SELECT $1::int * 3;", {"2"}),
+                        [&, value](AsyncDatabase::ResultPtr &&second) { answers.set_value({value, valueOf(second)}); });
+                });
+        });
+
+    std::future<std::vector<std::string>> future = answers.get_future();
+    REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(future.get() == std::vector<std::string>{"2", "6"});
+
+    inLoop(loop, [&]() { database.reset(); });
+}
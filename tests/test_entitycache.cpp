@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+#include "utils/entitycache/entitycache.hpp"
+
+// runs with the default cache configuration: 10000 entries and no replicas
+namespace
+{
+    const std::unordered_set<std::string> ALL     = {"id", "name"};
+    const std::unordered_set<std::string> NAME    = {"name"};
+    const std::string                     PATIENT = "patients";
+}  // namespace
+
+TEST_CASE("a stored read is served until the entity is written", "[entitycache]")
+{
+    EntityCache cache;
+
+    std::optional<EntityCache::Ticket> ticket = cache.ticket(PATIENT, 1, ALL);
+    REQUIRE(ticket.has_value());
+    CHECK_FALSE(cache.get(ticket.value()).has_value());
+
+    cache.insert(ticket.value(), "body");
+    CHECK(cache.get(cache.ticket(PATIENT, 1, {"name", "id"}).value()) == "body");
+
+    cache.invalidate(PATIENT, 1);
+    CHECK_FALSE(cache.get(cache.ticket(PATIENT, 1, ALL).value()).has_value());
+}
+
+TEST_CASE("a write drops every projection of the entity and no other", "[entitycache]")
+{
+    EntityCache cache;
+
+    cache.insert(cache.ticket(PATIENT, 1, ALL).value(), "all");
+    cache.insert(cache.ticket(PATIENT, 1, NAME).value(), "name");
+    cache.insert(cache.ticket(PATIENT, 2, ALL).value(), "other");
+
+    cache.invalidate(PATIENT, 1);
+
+    CHECK_FALSE(cache.get(cache.ticket(PATIENT, 1, ALL).value()).has_value());
+    CHECK_FALSE(cache.get(cache.ticket(PATIENT, 1, NAME).value()).has_value());
+    CHECK(cache.get(cache.ticket(PATIENT, 2, ALL).value()) == "other");
+}
+
+TEST_CASE("a read racing a write is not stored", "[entitycache]")
+{
+    EntityCache cache;
+
+    EntityCache::Ticket before = cache.ticket(PATIENT, 1, ALL).value();
+    cache.invalidate(PATIENT, 1);
+    cache.insert(before, "old");
+
+    CHECK_FALSE(cache.get(cache.ticket(PATIENT, 1, ALL).value()).has_value());
+}
+
+TEST_CASE("pruning the index after many writes keeps racing reads out", "[entitycache]")
+{
+    EntityCache cache;
+
+    EntityCache::Ticket before = cache.ticket(PATIENT, 1, ALL).value();
+
+    // more entities than the index keeps slots for
+    for (uint64_t id = 1; id <= 50000; ++id)
+    {
+        cache.invalidate(PATIENT, id);
+    }
+    cache.insert(before, "old");
+    CHECK_FALSE(cache.get(cache.ticket(PATIENT, 1, ALL).value()).has_value());
+
+    EntityCache::Ticket after = cache.ticket(PATIENT, 1, ALL).value();
+    cache.insert(after, "new");
+    CHECK(cache.get(cache.ticket(PATIENT, 1, ALL).value()) == "new");
+}
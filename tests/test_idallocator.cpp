@@ -0,0 +1,42 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "database/idallocator.hpp"
+
+TEST_CASE("a reservation takes the fewest NEXTVAL calls covering the ids", "[idallocator]")
+{
+    CHECK(IdAllocator::callsFor(250, 100) == 3);
+    CHECK(IdAllocator::callsFor(200, 100) == 2);
+    CHECK(IdAllocator::callsFor(1, 100) == 1);
+    CHECK(IdAllocator::callsFor(5, 1) == 5);
+    CHECK(IdAllocator::callsFor(0, 1) == 1);
+}
+
+TEST_CASE("every NEXTVAL reserves step ids from the value it returned", "[idallocator]")
+{
+    std::vector<IdAllocator::Range> ranges = IdAllocator::rangesOf({1, 201, 101}, 100);
+
+    REQUIRE(ranges.size() == 3);
+    CHECK(ranges[0].first == 1);
+    CHECK(ranges[0].end == 101);
+    CHECK(ranges[1].first == 201);
+    CHECK(ranges[1].end == 301);
+    CHECK(ranges[2].first == 101);
+}
+
+TEST_CASE("ids are taken in order across ranges and exhausted ranges are dropped", "[idallocator]")
+{
+    std::deque<IdAllocator::Range> ranges = {{.first = 10, .end = 13}, {.first = 50, .end = 52}};
+
+    CHECK(IdAllocator::take(ranges, 2) == std::vector<uint64_t>{10, 11});
+    REQUIRE(ranges.size() == 2);
+
+    CHECK(IdAllocator::take(ranges, 2) == std::vector<uint64_t>{12, 50});
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges.front().first == 51);
+
+    CHECK(IdAllocator::take(ranges, 1) == std::vector<uint64_t>{51});
+    CHECK(ranges.empty());
+}
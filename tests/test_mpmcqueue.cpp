@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/mpmcqueue/mpmcqueue.hpp"
+
+TEST_CASE("the capacity is rounded up to a power of two", "[mpmcqueue]")
+{
+    CHECK(MPMCQueue<int>(0).capacity() == 2);
+    CHECK(MPMCQueue<int>(5).capacity() == 8);
+    CHECK(MPMCQueue<int>(64).capacity() == 64);
+}
+
+TEST_CASE("values leave in the order they came and a full queue refuses more", "[mpmcqueue]")
+{
+    MPMCQueue<std::string> queue(4);
+    std::string            value;
+
+    CHECK_FALSE(queue.try_pop(value));
+
+    // two rounds, so the cursors wrap around the cells once
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int index = 0; index < 4; ++index)
+        {
+            REQUIRE(queue.try_push(std::to_string(index)));
+        }
+
+        std::string refused = "refused";
+        CHECK_FALSE(queue.try_push(std::move(refused)));
+        CHECK(refused == "refused");
+        CHECK(queue.size() == 4);
+
+        for (int index = 0; index < 4; ++index)
+        {
+            REQUIRE(queue.try_pop(value));
+            CHECK(value == std::to_string(index));
+        }
+        CHECK_FALSE(queue.try_pop(value));
+        CHECK(queue.size() == 0);
+    }
+}
+
+TEST_CASE("every value pushed by many threads is popped exactly once", "[mpmcqueue]")
+{
+    constexpr size_t THREADS    = 4;
+    constexpr size_t PER_THREAD = 10000;
+
+    MPMCQueue<uint64_t>           queue(64);
+    std::vector<std::atomic<int>> seen(THREADS * PER_THREAD);
+    std::atomic<size_t>           popped{0};
+    std::vector<std::thread>      threads;
+
+    for (size_t thread = 0; thread < THREADS; ++thread)
+    {
+        threads.emplace_back(
+            [&, thread]()
+            {
+                for (size_t index = 0; index < PER_THREAD; ++index)
+                {
+                    uint64_t value = (thread * PER_THREAD) + index;
+                    while (!queue.try_push(std::move(value)))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        threads.emplace_back(
+            [&]()
+            {
+                uint64_t value = 0;
+                while (popped.load() < THREADS * PER_THREAD)
+                {
+                    if (queue.try_pop(value))
+                    {
+                        seen[value].fetch_add(1);
+                        popped.fetch_add(1);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    size_t once = 0;
+    for (const auto &count : seen)
+    {
+        once += count.load() == 1 ? 1 : 0;
+    }
+    CHECK(once == THREADS * PER_THREAD);
+}
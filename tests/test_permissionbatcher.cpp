@@ -0,0 +1,201 @@
+#include <fmt/core.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/EventLoopThread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <jsoncons/json.hpp>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "database/preparedstatement.hpp"
+#include "gatekeeper/permissionmanager/permissionbatcher.hpp"
+
+using api::v2::PermissionBatcher;
+
+namespace
+{
+    const std::string SQL   = "SELECT id, owner FROM patients WHERE id = ANY($1::bigint[]);";
+    const std::string OTHER = "SELECT id, owner FROM clinics WHERE id = ANY($1::bigint[]);";
+
+    // answers every id of the batch with a row, except the ids in missing
+    std::optional<jsoncons::json::array> rowsOf(const PreparedStatement &statement, const std::vector<uint64_t> &missing = {})
+    {
+        std::string ids = statement.params.front().value();
+        ids             = ids.substr(1, ids.size() - 2);
+
+        jsoncons::json::array rows;
+        std::size_t           start = 0;
+        while (start < ids.size())
+        {
+            std::size_t end = ids.find(',', start);
+            end             = end == std::string::npos ? ids.size() : end;
+            uint64_t id     = std::stoull(ids.substr(start, end - start));
+            start           = end + 1;
+
+            if (std::find(missing.begin(), missing.end(), id) == missing.end())
+            {
+                jsoncons::json row;
+                row["id"]    = id;
+                row["owner"] = fmt::format("owner of {}", id);
+                rows.push_back(std::move(row));
+            }
+        }
+        return rows;
+    }
+
+    bool never() { return false; }
+
+    // runs func on the loop thread and waits until it returned, the batches it opened are not sent yet by then
+    template <typename Func>
+    void inLoop(trantor::EventLoop *loop, Func &&func)
+    {
+        std::promise<void> done;
+        loop->runInLoop(
+            [&]()
+            {
+                func();
+                done.set_value();
+            });
+        done.get_future().wait();
+    }
+}  // namespace
+
+TEST_CASE("a lookup off an event loop is sent at once and picks its own row", "[permissionbatcher]")
+{
+    std::atomic<int>  queries{0};
+    PermissionBatcher batcher(
+        [&](const PreparedStatement &statement, std::function<void(PermissionBatcher::Rows &&)> &&callback)
+        {
+            ++queries;
+            callback(rowsOf(statement, {2}));
+        },
+        never);
+
+    std::optional<jsoncons::json> first;
+    batcher.lookup(SQL, "id", 1, [&](std::optional<jsoncons::json> &&row) { first = std::move(row); });
+    REQUIRE(first.has_value());
+    CHECK(first->at("owner").as<std::string>() == "owner of 1");
+
+    bool answered = false;
+    batcher.lookup(SQL, "id", 2,
+        [&](std::optional<jsoncons::json> &&row)
+        {
+            answered = true;
+            CHECK_FALSE(row.has_value());
+        });
+    CHECK(answered);
+    CHECK(queries == 2);
+}
+
+TEST_CASE("a failed batch fails every lookup in it", "[permissionbatcher]")
+{
+    PermissionBatcher batcher([](const PreparedStatement &, std::function<void(PermissionBatcher::Rows &&)> &&callback) { callback(std::nullopt); },
+        never);
+
+    bool answered = false;
+    batcher.lookup(SQL, "id", 1,
+        [&](std::optional<jsoncons::json> &&row)
+        {
+            answered = true;
+            CHECK_FALSE(row.has_value());
+        });
+    CHECK(answered);
+}
+
+TEST_CASE("lookups made in one loop iteration share one query per shape", "[permissionbatcher]")
+{
+    trantor::EventLoopThread thread;
+    thread.run();
+    trantor::EventLoop *loop = thread.getLoop();
+
+    std::mutex               mutex;
+    std::vector<std::string> batches;
+
+    PermissionBatcher batcher(
+        [&](const PreparedStatement &statement, std::function<void(PermissionBatcher::Rows &&)> &&callback)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batches.push_back(statement.sql);
+            }
+            callback(rowsOf(statement, {3}));
+        },
+        never);
+
+    std::vector<std::optional<jsoncons::json>> found(4);
+    std::atomic<int>                           answered{0};
+    std::promise<void>                         done;
+    size_t                                     sentMeanwhile = 0;
+
+    auto answer = [&](size_t slot)
+    {
+        return [&, slot](std::optional<jsoncons::json> &&row)
+        {
+            found[slot] = std::move(row);
+            if (++answered == 4)
+            {
+                done.set_value();
+            }
+        };
+    };
+
+    inLoop(loop,
+        [&]()
+        {
+            for (uint64_t id = 1; id <= 3; ++id)
+            {
+                batcher.lookup(SQL, "id", id, answer(id - 1));
+            }
+            batcher.lookup(OTHER, "id", 1, answer(3));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            sentMeanwhile = batches.size();
+        });
+
+    std::future<void> answers = done.get_future();
+    REQUIRE(answers.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+    // nothing went out before the loop got to the queued sends
+    CHECK(sentMeanwhile == 0);
+    CHECK(found[0]->at("id").as<uint64_t>() == 1);
+    CHECK(found[1]->at("id").as<uint64_t>() == 2);
+    CHECK_FALSE(found[2].has_value());
+    CHECK(found[3]->at("owner").as<std::string>() == "owner of 1");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(batches.size() == 2);
+}
+
+TEST_CASE("a lookup that has to be resolved alone does not join the loop's batch", "[permissionbatcher]")
+{
+    trantor::EventLoopThread thread;
+    thread.run();
+    trantor::EventLoop *loop = thread.getLoop();
+
+    std::atomic<int>  queries{0};
+    PermissionBatcher batcher(
+        [&](const PreparedStatement &statement, std::function<void(PermissionBatcher::Rows &&)> &&callback)
+        {
+            ++queries;
+            callback(rowsOf(statement));
+        },
+        []() { return true; });
+
+    int sentMeanwhile = 0;
+    inLoop(loop,
+        [&]()
+        {
+            batcher.lookup(SQL, "id", 1, [](std::optional<jsoncons::json> &&) {});
+            batcher.lookup(SQL, "id", 2, [](std::optional<jsoncons::json> &&) {});
+            sentMeanwhile = queries.load();
+        });
+
+    CHECK(sentMeanwhile == 2);
+}
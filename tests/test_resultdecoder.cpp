@@ -0,0 +1,90 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libpq-fe.h>
+
+#include <cstdint>
+#include <jsoncons/json.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "database/resultdecoder.hpp"
+
+// the results are built with libpq's result constructors, no connection is needed
+namespace
+{
+    struct Field
+    {
+        const char   *name;
+        std::uint32_t oid;
+    };
+
+    std::shared_ptr<PGresult> result(const std::vector<Field> &fields, const std::vector<std::vector<std::optional<std::string>>> &rows)
+    {
+        std::shared_ptr<PGresult> made(PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK), PQclear);
+
+        std::vector<PGresAttDesc> attributes;
+        for (const Field &field : fields)
+        {
+            // text format, variable length, no type modifier
+            attributes.push_back(PGresAttDesc{const_cast<char *>(field.name), 0, 0, 0, field.oid, -1, -1});  // NOLINT
+        }
+        PQsetResultAttrs(made.get(), static_cast<int>(attributes.size()), attributes.data());
+
+        for (size_t row = 0; row < rows.size(); ++row)
+        {
+            for (size_t column = 0; column < rows[row].size(); ++column)
+            {
+                // a length of -1 is SQL NULL
+                const std::optional<std::string> &value  = rows[row][column];
+                char                             *text   = value.has_value() ? const_cast<char *>(value->c_str()) : nullptr;  // NOLINT
+                int                               length = value.has_value() ? static_cast<int>(value->size()) : -1;
+                PQsetvalue(made.get(), static_cast<int>(row), static_cast<int>(column), text, length);
+            }
+        }
+        return made;
+    }
+
+    const std::vector<Field> PATIENT = {{"id", 20}, {"name", 25}, {"active", 16}, {"notes", 3802}, {"scores", 1007}, {"balance", 1700}};
+}  // namespace
+
+TEST_CASE("a row is decoded by the plan of its column types", "[resultdecoder]")
+{
+    ResultDecoder decoder(result(PATIENT, {{"7", "Ann \"A\"", "t", R"({"a": [1]})", "{1,NULL,3}", "12.50"}}));
+
+    REQUIRE(decoder.rows() == 1);
+    jsoncons::json row = decoder.rowToJson(0);
+
+    CHECK(row.at("id").as<int64_t>() == 7);
+    CHECK(row.at("name").as<std::string>() == "Ann \"A\"");
+    CHECK(row.at("active").as<bool>());
+    CHECK(row.at("notes").at("a").at(0).as<int>() == 1);
+    REQUIRE(row.at("scores").size() == 3);
+    CHECK(row.at("scores").at(1).is_null());
+    CHECK(row.at("scores").at(2).as<int>() == 3);
+}
+
+TEST_CASE("rows are written as json text without a DOM", "[resultdecoder]")
+{
+    ResultDecoder decoder(result(PATIENT, {{"7", "a\nb", "f", R"({"a": [1]})", "{1,2}", "12.50"}, {"8", std::nullopt, std::nullopt, "null", "{}", "NaN"}}));
+
+    std::string out;
+    decoder.writeRows(out, 10);
+    CHECK(out == R"([{"id":7,"name":"a\nb","active":false,"notes":{"a": [1]},"scores":[1,2],"balance":12.50},)"
+                 R"({"id":8,"name":null,"active":null,"notes":null,"scores":[],"balance":"NaN"}])");
+
+    out.clear();
+    decoder.writeRows(out, 1);
+    CHECK(out.starts_with(R"([{"id":7,)"));
+    CHECK(out.ends_with("}]"));
+}
+
+TEST_CASE("cells and columns are found by position and name", "[resultdecoder]")
+{
+    ResultDecoder decoder(result(PATIENT, {{"7", std::nullopt, "t", "{}", "{}", "0"}}));
+
+    CHECK(decoder.columnIndex("active") == std::optional<std::size_t>{2});
+    CHECK_FALSE(decoder.columnIndex("missing").has_value());
+    CHECK(decoder.cell(0, 0) == std::optional<std::string_view>{"7"});
+    CHECK_FALSE(decoder.cell(0, 1).has_value());
+}
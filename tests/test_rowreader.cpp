@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <jsoncons/json.hpp>
+#include <string>
+#include <unordered_set>
+
+#include "utils/global/types.hpp"
+#include "utils/rowreader/rowreader.hpp"
+
+namespace
+{
+    const std::unordered_set<api::v2::ColumnInfo> PATIENTS = {
+        api::v2::ColumnInfo{.Name = "name", .DataType = "character varying", .Constraint = "", .isNullable = true},
+        api::v2::ColumnInfo{.Name = "age", .DataType = "integer", .Constraint = "", .isNullable = true},
+        api::v2::ColumnInfo{.Name = "active", .DataType = "boolean", .Constraint = "", .isNullable = true},
+        api::v2::ColumnInfo{.Name = "notes", .DataType = "jsonb", .Constraint = "", .isNullable = true},
+    };
+}  // namespace
+
+TEST_CASE("the format is taken from the media type of the Content-Type header", "[rowreader]")
+{
+    CHECK(RowReader::formatOf("application/x-ndjson") == RowReader::Format::NDJSON);
+    CHECK(RowReader::formatOf("text/csv ; charset=utf-8") == RowReader::Format::CSV);
+    CHECK_FALSE(RowReader::formatOf("application/json").has_value());
+}
+
+TEST_CASE("NDJSON rows are read one per line and blank lines are skipped", "[rowreader]")
+{
+    RowReader      reader("{\"name\": \"ann\"}\n\n[1]\nnot json\n{\"age\": 3}\n", RowReader::Format::NDJSON, PATIENTS);
+    jsoncons::json row;
+    std::string    error;
+
+    REQUIRE(reader.next(row, error) == RowReader::Result::ROW);
+    CHECK(row.at("name").as<std::string>() == "ann");
+
+    CHECK(reader.next(row, error) == RowReader::Result::INVALID);
+    CHECK(error == "Row is not a json object");
+    CHECK(reader.row() == 2);
+
+    CHECK(reader.next(row, error) == RowReader::Result::INVALID);
+
+    REQUIRE(reader.next(row, error) == RowReader::Result::ROW);
+    CHECK(row.at("age").as<int>() == 3);
+    CHECK(reader.row() == 4);
+
+    CHECK(reader.next(row, error) == RowReader::Result::END);
+}
+
+TEST_CASE("CSV cells are converted to the types of their columns", "[rowreader]")
+{
+    RowReader      reader("name,age,active,notes\r\n\"Doe, \"\"J\"\"\",42,t,\"{\"\"a\"\": 1}\"\r\n,7,,\n\"\",x,no,\n", RowReader::Format::CSV, PATIENTS);
+    jsoncons::json row;
+    std::string    error;
+
+    REQUIRE(reader.next(row, error) == RowReader::Result::ROW);
+    CHECK(row.at("name").as<std::string>() == "Doe, \"J\"");
+    CHECK(row.at("age").as<int64_t>() == 42);
+    CHECK(row.at("active").as<bool>());
+    CHECK(row.at("notes").at("a").as<int>() == 1);
+
+    // an empty unquoted cell leaves its column out
+    REQUIRE(reader.next(row, error) == RowReader::Result::ROW);
+    CHECK_FALSE(row.contains("name"));
+    CHECK(row.at("age").as<int64_t>() == 7);
+    CHECK(row.size() == 1);
+
+    CHECK(reader.next(row, error) == RowReader::Result::INVALID);
+    CHECK(error == "Value of column age is not an integer: x");
+    CHECK(reader.row() == 3);
+
+    CHECK(reader.next(row, error) == RowReader::Result::END);
+}
+
+TEST_CASE("a CSV row of the wrong width or an unterminated quote is reported", "[rowreader]")
+{
+    RowReader      reader("name,age\nann\n\"open,1\n", RowReader::Format::CSV, PATIENTS);
+    jsoncons::json row;
+    std::string    error;
+
+    CHECK(reader.next(row, error) == RowReader::Result::INVALID);
+    CHECK(error == "Expected 2 fields, found 1");
+
+    CHECK(reader.next(row, error) == RowReader::Result::INVALID);
+    CHECK(error == "Unterminated quoted field");
+
+    CHECK(reader.next(row, error) == RowReader::Result::END);
+}
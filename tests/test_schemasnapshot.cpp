@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include "utils/global/types.hpp"
+#include "validator/databaseschema/schemasnapshot.hpp"
+
+namespace
+{
+    // a directory of its own per test, removed again when the test is done
+    struct Directory
+    {
+        std::filesystem::path path;
+
+        explicit Directory(const std::string &name) : path(std::filesystem::temp_directory_path() / name)
+        {
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+        ~Directory() { std::filesystem::remove_all(path); }
+    };
+
+    SchemaSnapshot patients()
+    {
+        SchemaSnapshot snapshot;
+        snapshot.fingerprint        = "5d41402abc4b2a76b9719d911017c592";
+        snapshot.trigram            = true;
+        snapshot.schema["patients"] = {
+            api::v2::ColumnInfo{.Name = "id", .DataType = "integer", .Constraint = "nextval('patients_id_seq'::regclass)", .isNullable = false},
+            api::v2::ColumnInfo{.Name = "name", .DataType = "text", .Constraint = "", .isNullable = true},
+        };
+        snapshot.indexes["patients"] = {"CREATE UNIQUE INDEX patients_pkey ON public.patients USING btree (id)"};
+        return snapshot;
+    }
+}  // namespace
+
+TEST_CASE("a snapshot reads back what was written", "[schemasnapshot]")
+{
+    Directory             directory("schemasnapshot_roundtrip");
+    std::filesystem::path path = directory.path / "schema.snapshot.json";
+
+    REQUIRE(patients().write(path));
+
+    std::optional<SchemaSnapshot> read = SchemaSnapshot::read(path);
+    REQUIRE(read.has_value());
+    CHECK(read->fingerprint == patients().fingerprint);
+    CHECK(read->trigram);
+    CHECK(read->schema == patients().schema);
+    CHECK(read->indexes == patients().indexes);
+    CHECK(read->schema.at("patients").find(api::v2::ColumnInfo{.Name = "id", .DataType = "integer", .Constraint = "", .isNullable = false})->Constraint ==
+          "nextval('patients_id_seq'::regclass)");
+
+    // the temporary file was renamed, nothing is left next to the snapshot
+    CHECK(std::distance(std::filesystem::directory_iterator(directory.path), std::filesystem::directory_iterator()) == 1);
+}
+
+TEST_CASE("a missing, broken or foreign snapshot is not used", "[schemasnapshot]")
+{
+    Directory             directory("schemasnapshot_rejected");
+    std::filesystem::path path = directory.path / "schema.snapshot.json";
+
+    CHECK_FALSE(SchemaSnapshot::read(path).has_value());
+
+    std::ofstream(path) << "{\"format\": ";
+    CHECK_FALSE(SchemaSnapshot::read(path).has_value());
+
+    std::ofstream(path, std::ios::trunc) << R"({"format": 0, "fingerprint": "", "trigram": false, "tables": {}, "indexes": {}})";
+    CHECK_FALSE(SchemaSnapshot::read(path).has_value());
+}
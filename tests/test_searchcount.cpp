@@ -0,0 +1,27 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <optional>
+
+#include "utils/searchcount/searchcount.hpp"
+
+TEST_CASE("the plan rows of the top node are read from an EXPLAIN (FORMAT JSON) output", "[searchcount]")
+{
+    CHECK(SearchCount::planRows(R"([{"Plan": {"Node Type": "Seq Scan", "Plan Rows": 1234, "Plans": [{"Plan Rows": 7}]}}])") == uint64_t{1234});
+    CHECK(SearchCount::planRows(R"([{"Plan": {"Plan Rows": 2.6}}])") == uint64_t{3});
+    CHECK(SearchCount::planRows(R"([{"Plan": {"Plan Rows": -1}}])") == uint64_t{0});
+}
+
+TEST_CASE("a plan without rows has no estimate", "[searchcount]")
+{
+    CHECK_FALSE(SearchCount::planRows("").has_value());
+    CHECK_FALSE(SearchCount::planRows("not json").has_value());
+    CHECK_FALSE(SearchCount::planRows(R"([{"Plan": {"Node Type": "Result"}}])").has_value());
+    CHECK_FALSE(SearchCount::planRows("[]").has_value());
+}
+
+TEST_CASE("a total is answered as json", "[searchcount]")
+{
+    CHECK(SearchCount::toJson(std::nullopt) == "null");
+    CHECK(SearchCount::toJson(SearchCount::Total{.rows = 42, .exact = true}) == R"({"total":42,"exact":true})");
+    CHECK(SearchCount::toJson(SearchCount::Total{.rows = 90000, .exact = false}) == R"({"total":90000,"exact":false})");
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include <jsoncons/json.hpp>
+#include <optional>
+#include <string>
+
+#include "utils/global/types.hpp"
+#include "utils/searchfilter/searchfilter.hpp"
+#include "validator/databaseschema/databaseschema.hpp"
+#include "validator/databaseschema/schemasnapshot.hpp"
+
+// the filters are compiled against a published snapshot, no database is needed
+namespace
+{
+    const std::string PATIENT = "patients";
+
+    void publishPatients()
+    {
+        SchemaSnapshot snapshot;
+        snapshot.schema["patients_safe"] = {
+            api::v2::ColumnInfo{.Name = "id", .DataType = "bigint", .Constraint = "", .isNullable = true},
+            api::v2::ColumnInfo{.Name = "name", .DataType = "text", .Constraint = "", .isNullable = true},
+            api::v2::ColumnInfo{.Name = "age", .DataType = "integer", .Constraint = "", .isNullable = true},
+            api::v2::ColumnInfo{.Name = "tags", .DataType = "ARRAY", .Constraint = "", .isNullable = true},
+        };
+        snapshot.indexes["patients"] = {"CREATE INDEX patients_age_idx ON public.patients USING btree (age)"};
+        DatabaseSchema::publish(std::move(snapshot));
+    }
+
+    std::optional<SearchFilter::Compiled> compile(const std::string &expression, std::string &error)
+    {
+        publishPatients();
+        return SearchFilter(jsoncons::json::parse(expression), PATIENT).compile(error);
+    }
+}  // namespace
+
+TEST_CASE("a filter compiles into one condition with bound values", "[searchfilter]")
+{
+    std::string                           error;
+    std::optional<SearchFilter::Compiled> compiled =
+        compile(R"({"and": [{"eq": {"name": "ann"}}, {"range": {"age": {"gte": 18, "lt": 65}}}, {"in": {"id": [1, 2]}}]})", error);
+
+    REQUIRE(compiled.has_value());
+    CHECK(compiled->condition == R"(("name" = $1 AND "age" >= $2 AND "age" < $3 AND "id" = ANY($4)))");
+    REQUIRE(compiled->params.size() == 4);
+    CHECK(compiled->params[0] == "ann");
+    CHECK(compiled->params[1] == "18");
+    CHECK(compiled->params[3] == R"({"1","2"})");
+}
+
+TEST_CASE("the predicates tell which of them an index serves", "[searchfilter]")
+{
+    std::string                           error;
+    std::optional<SearchFilter::Compiled> compiled = compile(R"({"or": [{"eq": {"age": 30}}, {"prefix": {"name": "a_"}}]})", error);
+
+    REQUIRE(compiled.has_value());
+    CHECK(compiled->params[1] == R"(a\_%)");
+    REQUIRE(compiled->predicates.size() == 2);
+    CHECK(compiled->predicates[0].column == "age");
+    CHECK(compiled->predicates[0].indexed);
+    CHECK(compiled->predicates[1].op == "prefix");
+    CHECK_FALSE(compiled->predicates[1].indexed);
+    CHECK(SearchFilter::describe(compiled->predicates).size() == 2);
+}
+
+TEST_CASE("an invalid filter reports what is wrong with it", "[searchfilter]")
+{
+    std::string error;
+
+    CHECK_FALSE(compile(R"({"eq": {"missing": 1}})", error).has_value());
+    CHECK(error == "Unknown filter column missing.");
+
+    CHECK_FALSE(compile(R"({"like": {"name": "a"}})", error).has_value());
+    CHECK(error == "Unknown filter operator like.");
+
+    CHECK_FALSE(compile(R"({"eq": {"tags": "a"}})", error).has_value());
+    CHECK(error == "Column tags of type ARRAY only supports is_null.");
+
+    CHECK_FALSE(compile(R"({"prefix": {"age": "1"}})", error).has_value());
+    CHECK_FALSE(compile(R"({"and": []})", error).has_value());
+}
@@ -0,0 +1,75 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/singleflight/singleflight.hpp"
+
+TEST_CASE("callers arriving during a flight share its value", "[singleflight]")
+{
+    SingleFlight<int>        flights;
+    std::atomic<int>         runs{0};
+    std::promise<void>       started;
+    std::promise<void>       release;
+    std::shared_future<void> released = release.get_future().share();
+
+    std::future<int> leader = std::async(std::launch::async,
+        [&]()
+        {
+            return flights.run("key",
+                [&]()
+                {
+                    ++runs;
+                    started.set_value();
+                    released.wait();
+                    return 42;
+                });
+        });
+    started.get_future().wait();
+
+    std::future<int> follower = std::async(std::launch::async, [&]() { return flights.run("key", [&]() { return ++runs; }); });
+
+    // the follower is parked on the flight until the leader lands
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+
+    CHECK(leader.get() == 42);
+    CHECK(follower.get() == 42);
+    CHECK(runs == 1);
+}
+
+TEST_CASE("a landed flight is not reused", "[singleflight]")
+{
+    SingleFlight<int> flights;
+
+    CHECK(flights.run("key", []() { return 1; }) == 1);
+    CHECK(flights.run("key", []() { return 2; }) == 2);
+}
+
+TEST_CASE("a failing flight fails its caller and the next call starts afresh", "[singleflight]")
+{
+    SingleFlight<int> flights;
+
+    CHECK_THROWS_AS(flights.run("key", []() -> int { throw std::runtime_error("down"); }), std::runtime_error);
+    CHECK(flights.run("key", []() { return 3; }) == 3);
+}
+
+TEST_CASE("only the first joiner leads and land reaches every waiter once", "[singleflight]")
+{
+    SingleFlight<std::string> flights;
+    std::vector<std::string>  seen;
+
+    CHECK(flights.join("key", [&](const std::string &value) { seen.push_back("a" + value); }));
+    CHECK_FALSE(flights.join("key", [&](const std::string &value) { seen.push_back("b" + value); }));
+    CHECK(flights.join("other", [&](const std::string &value) { seen.push_back("c" + value); }));
+
+    flights.land("key", "1");
+    flights.land("key", "2");
+
+    CHECK(seen == std::vector<std::string>{"a1", "b1"});
+    CHECK(flights.join("key", [](const std::string &) {}));
+}
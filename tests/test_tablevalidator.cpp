@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <jsoncons/json.hpp>
+#include <string>
+#include <unordered_set>
+
+#include "utils/global/http.hpp"
+#include "utils/global/types.hpp"
+#include "validator/tablevalidator.hpp"
+#include "validator/validator.hpp"
+
+namespace
+{
+    // enough columns that the perfect hash has to look past its first seeds
+    std::unordered_set<api::v2::ColumnInfo> manyColumns()
+    {
+        std::unordered_set<api::v2::ColumnInfo> columns;
+        for (int index = 0; index < 300; ++index)
+        {
+            columns.insert(api::v2::ColumnInfo{.Name = "column_" + std::to_string(index), .DataType = "integer", .Constraint = "", .isNullable = true});
+        }
+        columns.insert(api::v2::ColumnInfo{.Name = "name", .DataType = "character varying", .Constraint = "", .isNullable = false});
+        return columns;
+    }
+
+    Validator::Rule none() { return Validator::Rule(Validator::Rule::Action::NONE, {}); }
+}  // namespace
+
+TEST_CASE("every column is found through the perfect hash and nothing else is", "[tablevalidator]")
+{
+    TableValidator       validator(manyColumns());
+    api::v2::Http::Error error;
+
+    std::unordered_set<std::string> keys = {"name"};
+    for (int index = 0; index < 300; ++index)
+    {
+        keys.insert("column_" + std::to_string(index));
+    }
+    CHECK(validator.validateRead(keys, error, none()));
+
+    CHECK_FALSE(validator.validateRead({"column_300"}, error, none()));
+    CHECK(error.message == "Key not found in schema: column_300");
+    CHECK_FALSE(validator.validateRead({""}, error, none()));
+}
+
+TEST_CASE("a create is checked for types and non nullable columns", "[tablevalidator]")
+{
+    TableValidator       validator(manyColumns());
+    api::v2::Http::Error error;
+
+    CHECK(validator.validateCreate(jsoncons::json::parse(R"({"name": "ann", "column_7": 7})"), error, none()));
+
+    CHECK_FALSE(validator.validateCreate(jsoncons::json::parse(R"({"column_7": 7})"), error, none()));
+    CHECK(error.message == "Non-nullable column missing in data: name");
+
+    CHECK_FALSE(validator.validateCreate(jsoncons::json::parse(R"({"name": 1})"), error, none()));
+}
+
+TEST_CASE("the same rule built again resolves the same way and other rules do not share its flags", "[tablevalidator]")
+{
+    TableValidator       validator(manyColumns());
+    api::v2::Http::Error error;
+    jsoncons::json       data = jsoncons::json::parse(R"({"column_1": 1, "extra": 2})");
+
+    for (int round = 0; round < 2; ++round)
+    {
+        Validator::Rule ignore(Validator::Rule::Action::IGNORE_IF_MISSING_FROM_SCHEMA, {"extra"});
+        CHECK(validator.validateUpdate(data, error, ignore));
+
+        Validator::Rule immutable(Validator::Rule::Action::ASSERT_IMMUTABLE, {"column_1"});
+        CHECK_FALSE(validator.validateUpdate(data, error, immutable));
+        CHECK(error.message == "Key: [column_1] is not allowed to be changed");
+
+        CHECK_FALSE(validator.validateUpdate(data, error, none()));
+        CHECK(error.message == "Key: [extra] is not found in database schema");
+    }
+}